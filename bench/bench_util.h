@@ -0,0 +1,64 @@
+#pragma once
+#include <boost/json.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace bench
+{
+    using namespace std::literals;
+    using Clock = std::chrono::steady_clock;
+
+    // Не даёт компилятору выбросить вычисление, результат которого не используется
+    template <typename T>
+    inline void DoNotOptimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    struct Measurement
+    {
+        uint64_t iterations = 0;
+        std::chrono::nanoseconds total{ 0 };
+
+        double NsPerOp() const
+        {
+            return iterations == 0 ? 0.0 : static_cast<double>(total.count()) / static_cast<double>(iterations);
+        }
+
+        double OpsPerSecond() const
+        {
+            return total.count() == 0 ? 0.0 : static_cast<double>(iterations) * 1e9 / static_cast<double>(total.count());
+        }
+    };
+
+    // Повторяет fn, пока суммарное время не превысит min_time (но не меньше одного раза)
+    template <typename Fn>
+    Measurement Run(Fn&& fn, std::chrono::milliseconds min_time = 500ms)
+    {
+        Measurement result;
+        const auto start = Clock::now();
+        auto now = start;
+        do
+        {
+            fn();
+            ++result.iterations;
+            now = Clock::now();
+        } while (now - start < min_time);
+        result.total = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start);
+        return result;
+    }
+
+    // Результаты печатаются одним JSON-документом, чтобы их можно было сохранять и сравнивать между запусками
+    inline void PrintReport(const std::string& name, boost::json::array results)
+    {
+        boost::json::object report;
+        report["benchmark"] = name;
+        report["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        report["results"] = std::move(results);
+        std::cout << boost::json::serialize(report) << std::endl;
+    }
+}
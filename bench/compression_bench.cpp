@@ -0,0 +1,124 @@
+// Сравнение трафика и затрат CPU на сжатие:
+//  - статика: однократное сжатие с максимальным уровнем, дальше отдача готового буфера;
+//  - динамический JSON: сжатие каждого ответа с быстрым уровнем на IO-потоке.
+// Запуск: compression_bench [www-root]
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "bench_util.h"
+#include "../src/compression.h"
+
+namespace fs = std::filesystem;
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace
+{
+    struct Input
+    {
+        std::string name;
+        std::string content_type;
+        std::string data;
+    };
+
+    std::string ReadFile(const fs::path& path)
+    {
+        std::ifstream input(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+
+    // Ответ /api/v1/game/state с players_count собаками и таким же количеством трофеев
+    std::string MakeStateJSON(int players_count)
+    {
+        json::object players;
+        json::object lost_objects;
+        for (int i = 0; i < players_count; ++i)
+        {
+            json::object player;
+            player["pos"] = json::array{ 10.0 + i * 0.37, 4.0 + i * 0.11 };
+            player["speed"] = json::array{ i % 2 ? 3.0 : 0.0, 0.0 };
+            player["dir"] = "R";
+            player["bag"] = json::array{ json::object{{"id", i}, {"type", i % 2}} };
+            player["score"] = i * 10;
+            players[std::to_string(i)] = std::move(player);
+
+            json::object loot;
+            loot["type"] = i % 2;
+            loot["pos"] = json::array{ 5.0 + i * 0.5, 7.0 + i * 0.25 };
+            lost_objects[std::to_string(i)] = std::move(loot);
+        }
+        return json::serialize(json::object{ {"players", players}, {"lostObjects", lost_objects} });
+    }
+
+    json::object MeasureStatic(const Input& input, compression::Encoding encoding)
+    {
+        std::string packed;
+        auto compress = bench::Run([&] {
+            packed = compression::Compress(input.data, encoding, compression::Level::BEST);
+            }, 0ms);
+        // После прогрева отдача сжатого файла - это копия готового буфера в тело ответа
+        auto serve = bench::Run([&] {
+            std::string body = packed;
+            bench::DoNotOptimize(body);
+            });
+
+        json::object result;
+        result["path"] = "static";
+        result["input"] = input.name;
+        result["encoding"] = compression::GetEncodingName(encoding);
+        result["original_bytes"] = input.data.size();
+        result["compressed_bytes"] = packed.size();
+        result["ratio"] = static_cast<double>(packed.size()) / static_cast<double>(input.data.size());
+        result["one_time_compress_ms"] = static_cast<double>(compress.total.count()) / 1e6;
+        result["serve_ns_per_request"] = serve.NsPerOp();
+        return result;
+    }
+
+    json::object MeasureDynamic(const Input& input, compression::Encoding encoding)
+    {
+        std::string packed;
+        auto compress = bench::Run([&] {
+            packed = compression::Compress(input.data, encoding, compression::Level::FAST);
+            bench::DoNotOptimize(packed);
+            });
+
+        json::object result;
+        result["path"] = "dynamic";
+        result["input"] = input.name;
+        result["encoding"] = compression::GetEncodingName(encoding);
+        result["original_bytes"] = input.data.size();
+        result["compressed_bytes"] = packed.size();
+        result["ratio"] = static_cast<double>(packed.size()) / static_cast<double>(input.data.size());
+        result["compress_ns_per_response"] = compress.NsPerOp();
+        result["compress_mb_per_s"] = static_cast<double>(input.data.size()) * compress.OpsPerSecond() / 1e6;
+        return result;
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    fs::path www_root = argc > 1 ? fs::path(argv[1]) : fs::path("static");
+
+    std::vector<Input> static_inputs;
+    for (const auto* name : { "index.html", "game.html", "hall_of_fame.html" })
+    {
+        if (fs::exists(www_root / name))
+            static_inputs.push_back({ name, "text/html", ReadFile(www_root / name) });
+    }
+
+    std::vector<Input> dynamic_inputs;
+    for (int players : { 10, 100, 1000 })
+        dynamic_inputs.push_back({ "state_"s + std::to_string(players) + "_players", "application/json", MakeStateJSON(players) });
+
+    json::array results;
+    for (auto encoding : { compression::Encoding::GZIP, compression::Encoding::BROTLI })
+    {
+        for (const auto& input : static_inputs)
+            results.push_back(MeasureStatic(input, encoding));
+        for (const auto& input : dynamic_inputs)
+            results.push_back(MeasureDynamic(input, encoding));
+    }
+
+    bench::PrintReport("compression", std::move(results));
+}
@@ -0,0 +1,128 @@
+// Скорость установки соединений: несколько клиентских потоков в цикле открывают соединение,
+// отправляют один запрос с Connection: close, читают ответ и закрывают сокет.
+// Сравнивает обычный режим сервера и --reuse-port при большом потоке новых соединений.
+// Запуск: connection_rate_bench [host] [port] [target] [client_threads] [seconds]
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace json = boost::json;
+using tcp = net::ip::tcp;
+using namespace std::literals;
+
+namespace
+{
+    struct ClientResult
+    {
+        uint64_t connections = 0;
+        uint64_t errors = 0;
+        std::vector<double> connect_us;
+    };
+
+    ClientResult RunClient(const tcp::resolver::results_type& endpoints, const std::string& host,
+        const std::string& target, bench::Clock::time_point deadline)
+    {
+        ClientResult result;
+        net::io_context ioc;
+        http::request<http::empty_body> request(http::verb::get, target, 11);
+        request.set(http::field::host, host);
+        request.keep_alive(false);
+
+        while (bench::Clock::now() < deadline)
+        {
+            try
+            {
+                auto start = bench::Clock::now();
+                tcp::socket socket(ioc);
+                net::connect(socket, endpoints);
+                http::write(socket, request);
+
+                beast::flat_buffer buffer;
+                http::response<http::string_body> response;
+                http::read(socket, buffer, response);
+                auto finish = bench::Clock::now();
+
+                beast::error_code ec;
+                socket.shutdown(tcp::socket::shutdown_both, ec);
+                ++result.connections;
+                result.connect_us.push_back(std::chrono::duration<double, std::micro>(finish - start).count());
+            }
+            catch (const std::exception&)
+            {
+                ++result.errors;
+            }
+        }
+        return result;
+    }
+
+    double Percentile(std::vector<double>& values, double p)
+    {
+        if (values.empty())
+            return 0.0;
+        size_t index = std::min(values.size() - 1, static_cast<size_t>(p * static_cast<double>(values.size())));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+    std::string port = argc > 2 ? argv[2] : "8080";
+    std::string target = argc > 3 ? argv[3] : "/api/v1/maps";
+    unsigned threads = argc > 4 ? std::stoul(argv[4]) : std::max(1u, std::thread::hardware_concurrency());
+    unsigned seconds = argc > 5 ? std::stoul(argv[5]) : 5;
+
+    try
+    {
+        net::io_context ioc;
+        tcp::resolver resolver(ioc);
+        auto endpoints = resolver.resolve(host, port);
+
+        auto start = bench::Clock::now();
+        auto deadline = start + std::chrono::seconds(seconds);
+        std::vector<ClientResult> results(threads);
+        {
+            std::vector<std::jthread> clients;
+            for (unsigned i = 0; i < threads; ++i)
+                clients.emplace_back([&, i] { results[i] = RunClient(endpoints, host, target, deadline); });
+        }
+        double elapsed = std::chrono::duration<double>(bench::Clock::now() - start).count();
+
+        ClientResult total;
+        for (auto& result : results)
+        {
+            total.connections += result.connections;
+            total.errors += result.errors;
+            total.connect_us.insert(total.connect_us.end(), result.connect_us.begin(), result.connect_us.end());
+        }
+
+        json::object summary;
+        summary["target"] = target;
+        summary["client_threads"] = threads;
+        summary["connections"] = total.connections;
+        summary["errors"] = total.errors;
+        summary["connections_per_second"] = static_cast<double>(total.connections) / elapsed;
+        summary["p50_us"] = Percentile(total.connect_us, 0.5);
+        summary["p99_us"] = Percentile(total.connect_us, 0.99);
+        bench::PrintReport("connection_rate", json::array{ summary });
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,106 @@
+// Скорость записи ушедших игроков в локальный Postgres, строк в секунду, в зависимости от размера пачки:
+//  - literal: один INSERT с VALUES, собранными из экранированных строк (прежний способ);
+//  - prepared: подготовленный INSERT на каждую строку в одной транзакции;
+//  - copy: COPY через pqxx::stream_to.
+// Строки бенчмарка помечаются префиксом имени и удаляются в конце.
+// Запуск: GAME_DB_URL=postgres://... db_bench [seconds-per-case]
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "bench_util.h"
+#include "../src/database.h"
+
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace
+{
+    constexpr std::string_view NAME_PREFIX = "db_bench_"sv;
+
+    std::vector<postgres::RetiredPlayer> MakeBatch(size_t size)
+    {
+        std::vector<postgres::RetiredPlayer> batch;
+        batch.reserve(size);
+        for (size_t i = 0; i < size; ++i)
+            batch.push_back({ ""s, std::string(NAME_PREFIX) + std::to_string(i), static_cast<int>(i % 1000), static_cast<int64_t>(i * 37 % 600000) });
+        return batch;
+    }
+
+    void InsertLiteral(ConnectionPool& pool, const std::vector<postgres::RetiredPlayer>& batch)
+    {
+        auto conn = pool.GetConnection();
+        pqxx::work w{ *conn };
+        std::string query = "INSERT INTO retired_players (id, name, score, play_time_ms) VALUES ";
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            query.append(i == 0 ? "('" : ", ('");
+            query.append(util::detail::UUIDToString(util::detail::NewUUID()) + "'");
+            query.append(", '" + w.esc(batch[i].name) + "'");
+            query.append(", " + std::to_string(batch[i].score));
+            query.append(", " + std::to_string(batch[i].play_time_ms) + ")");
+        }
+        w.exec(query);
+        w.commit();
+    }
+
+    void Cleanup(ConnectionPool& pool)
+    {
+        auto conn = pool.GetConnection();
+        pqxx::work w{ *conn };
+        w.exec("DELETE FROM retired_players WHERE name LIKE " + w.quote(std::string(NAME_PREFIX) + "%"));
+        w.commit();
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    const char* db_url = std::getenv("GAME_DB_URL");
+    if (!db_url)
+    {
+        std::cerr << "GAME_DB_URL is not specified" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const auto time_per_case = std::chrono::milliseconds(argc > 1 ? std::atoi(argv[1]) * 1000 : 2000);
+
+    try
+    {
+        {
+            pqxx::connection conn{ db_url };
+            postgres::Database::InitSchema(conn);
+        }
+        auto pool = std::make_shared<ConnectionPool>(1, [db_url] {
+            auto conn = std::make_shared<pqxx::connection>(db_url);
+            postgres::Database::PrepareStatements(*conn);
+            return conn;
+            });
+        postgres::Database db(pool);
+
+        json::array results;
+        for (size_t batch_size : { 1, 10, 100, 1000, 10000 })
+        {
+            const auto batch = MakeBatch(batch_size);
+            auto measure = [&](std::string_view method, auto&& insert) {
+                auto round = bench::Run(insert, time_per_case);
+                json::object result;
+                result["method"] = method;
+                result["batch"] = batch_size;
+                result["batches"] = round.iterations;
+                result["rows_per_second"] = round.OpsPerSecond() * static_cast<double>(batch_size);
+                result["us_per_batch"] = round.NsPerOp() / 1e3;
+                results.push_back(std::move(result));
+                Cleanup(*pool);
+                };
+
+            measure("literal", [&] { InsertLiteral(*pool, batch); });
+            measure("prepared", [&] { db.AddRetiredPlayersToDB(batch, postgres::InsertMethod::PREPARED); });
+            measure("copy", [&] { db.AddRetiredPlayersToDB(batch, postgres::InsertMethod::COPY); });
+        }
+        bench::PrintReport("db_retirement_insert", std::move(results));
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
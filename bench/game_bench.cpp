@@ -0,0 +1,219 @@
+// Пропускная способность симуляции: Game::UpdateGameState без сервера, на синтетических картах.
+//  - grid: город из кварталов, дороги сеткой, базы на части перекрёстков;
+//  - corridor: несколько длинных параллельных дорог с редкими перемычками.
+// На карте dogs собак и loot предметов, генератор лута работает как на сервере. Собаки двигаются по сценарию:
+// каждые SCRIPT_PERIOD тиков четверть из них меняет направление. Сценарий и зерно карты фиксированы,
+// поэтому запуски на одной сборке сравнимы. В замер входит только UpdateGameState.
+// Отчёт: тиков в секунду, нс на собаку за тик, выделений памяти и байт на тик.
+// Запуск: game_bench [dogs] [loot] [seconds-per-case]
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "bench_util.h"
+#include "../src/model.h"
+#include "../src/extra_data.h"
+
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace
+{
+    // Выделения памяти считаются во всём процессе, но замер идёт только вокруг UpdateGameState
+    std::atomic<uint64_t> allocations{ 0 };
+    std::atomic<uint64_t> allocated_bytes{ 0 };
+}
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+    constexpr auto TICK = 50ms;
+    constexpr uint64_t SEED = 20240601;
+    constexpr int SCRIPT_PERIOD = 20;
+    constexpr double DOG_SPEED = 3.0;
+
+    struct MapSpec
+    {
+        std::string name;
+        std::vector<model::Road> roads;
+        std::vector<model::Point> offices;
+    };
+
+    // blocks x blocks кварталов по block единиц, база на каждом четвёртом перекрёстке
+    MapSpec GridCity(int blocks, int block)
+    {
+        MapSpec spec{ "grid"s };
+        const int size = blocks * block;
+        for (int i = 0; i <= blocks; ++i)
+        {
+            spec.roads.emplace_back(model::Road::HORIZONTAL, model::Point{ 0, i * block }, size);
+            spec.roads.emplace_back(model::Road::VERTICAL, model::Point{ i * block, 0 }, size);
+        }
+        for (int x = 0; x <= blocks; x += 2)
+        {
+            for (int y = 0; y <= blocks; y += 2)
+                spec.offices.push_back({ x * block, y * block });
+        }
+        return spec;
+    }
+
+    // lanes длинных дорог по length единиц, перемычки через каждые gap единиц
+    MapSpec Corridor(int lanes, int length, int gap)
+    {
+        MapSpec spec{ "corridor"s };
+        constexpr int LANE_WIDTH = 100;
+        for (int i = 0; i < lanes; ++i)
+            spec.roads.emplace_back(model::Road::HORIZONTAL, model::Point{ 0, i * LANE_WIDTH }, length);
+        for (int x = 0; x <= length; x += gap)
+        {
+            spec.roads.emplace_back(model::Road::VERTICAL, model::Point{ x, 0 }, (lanes - 1) * LANE_WIDTH);
+            spec.offices.push_back({ x, 0 });
+        }
+        return spec;
+    }
+
+    std::shared_ptr<model::Map> MakeMap(const MapSpec& spec)
+    {
+        auto map = std::make_shared<model::Map>(model::Map::Id(spec.name), spec.name);
+        for (const auto& road : spec.roads)
+            map->AddRoad(road);
+        for (size_t i = 0; i < spec.offices.size(); ++i)
+            map->AddOffice(model::Office(model::Office::Id("o"s + std::to_string(i)), spec.offices[i], { 0, 0 }));
+        map->AddDefaultMapSpeed(DOG_SPEED);
+        map->SetBagCapacity(3);
+        map->SetLootGenerator(std::make_unique<loot_gen::LootGenerator>(5s, 0.5));
+        return map;
+    }
+
+    json::array LootTypes()
+    {
+        json::array types;
+        for (int value : { 10, 30, 50 })
+            types.push_back(json::object{ { "value", value } });
+        return types;
+    }
+
+    model::Direction ScriptedDirection(int dog_id, int step)
+    {
+        static constexpr model::Direction DIRECTIONS[] = { model::Direction::UP, model::Direction::DOWN,
+            model::Direction::LEFT, model::Direction::RIGHT };
+        uint32_t h = static_cast<uint32_t>(dog_id) * 2654435761u ^ static_cast<uint32_t>(step) * 40503u;
+        return DIRECTIONS[(h >> 13) % 4];
+    }
+
+    json::object Measure(const MapSpec& spec, size_t dogs_count, size_t loot_count, std::chrono::milliseconds time_per_case)
+    {
+        model::Game game;
+        auto map = MakeMap(spec);
+        game.AddMap(map);
+        ExtraData extra;
+        extra.SetJSONLootTypes(*map->GetId(), LootTypes());
+        game.SetExtraData(std::move(extra));
+        // Собаки не уходят на покой за время замера
+        game.SetRetirementTime(std::chrono::hours(24));
+        game.SeedRandom(SEED);
+
+        auto session = std::make_shared<model::GameSession>(map);
+        std::vector<std::shared_ptr<model::Dog>> dogs;
+        dogs.reserve(dogs_count);
+        for (size_t i = 0; i < dogs_count; ++i)
+        {
+            auto dog = std::make_shared<model::Dog>(model::Direction::UP, map->GetDogSpeed(), map->GetRandomPosDog());
+            session->AddDog(dog);
+            dogs.push_back(std::move(dog));
+        }
+        for (size_t i = 0; i < loot_count; ++i)
+            map->AddLoot(std::make_shared<model::Loot>(static_cast<int>(i % 3), map->GetRandomPosLoot(), 10));
+        game.AddSession(session, *map->GetId());
+
+        std::chrono::nanoseconds total{ 0 };
+        uint64_t ticks = 0;
+        uint64_t tick_allocations = 0;
+        uint64_t tick_bytes = 0;
+        while (total < time_per_case)
+        {
+            if (ticks % SCRIPT_PERIOD == 0)
+            {
+                const int step = static_cast<int>(ticks / SCRIPT_PERIOD);
+                for (size_t i = step % 4; i < dogs.size(); i += 4)
+                {
+                    dogs[i]->SetInGameDirection(ScriptedDirection(dogs[i]->GetObjectId(), step));
+                    dogs[i]->SetInGameSpeed();
+                }
+            }
+
+            const uint64_t allocations_before = allocations.load(std::memory_order_relaxed);
+            const uint64_t bytes_before = allocated_bytes.load(std::memory_order_relaxed);
+            const auto start = bench::Clock::now();
+            game.UpdateGameState(TICK);
+            total += bench::Clock::now() - start;
+            tick_allocations += allocations.load(std::memory_order_relaxed) - allocations_before;
+            tick_bytes += allocated_bytes.load(std::memory_order_relaxed) - bytes_before;
+            ++ticks;
+
+            game.TakeScoredDogs();
+            game.TakeSpawnedLoot();
+        }
+
+        const double ns_per_tick = static_cast<double>(total.count()) / static_cast<double>(ticks);
+        json::object result;
+        result["map"] = spec.name;
+        result["roads"] = spec.roads.size();
+        result["dogs"] = dogs_count;
+        result["loot"] = loot_count;
+        result["loot_after"] = map->GetMapLoot().size();
+        result["ticks"] = ticks;
+        result["ticks_per_second"] = 1e9 / ns_per_tick;
+        result["ns_per_tick"] = ns_per_tick;
+        result["ns_per_dog"] = dogs_count == 0 ? 0.0 : ns_per_tick / static_cast<double>(dogs_count);
+        result["allocations_per_tick"] = static_cast<double>(tick_allocations) / static_cast<double>(ticks);
+        result["bytes_per_tick"] = static_cast<double>(tick_bytes) / static_cast<double>(ticks);
+        result["state_digest"] = game.GetStateDigest();
+        return result;
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    const size_t dogs = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 10000;
+    const size_t loot = argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 1000;
+    const auto time_per_case = std::chrono::milliseconds(argc > 3 ? std::atoll(argv[3]) * 1000 : 2000);
+
+    try
+    {
+        const MapSpec maps[] = { GridCity(20, 50), Corridor(4, 10000, 1000) };
+        json::array results;
+        for (const auto& spec : maps)
+        {
+            // Малая и полная загрузка показывают, растёт ли время тика линейно по числу собак
+            for (size_t count : { std::max<size_t>(1, dogs / 10), dogs })
+                results.push_back(Measure(spec, count, loot, time_per_case));
+        }
+        bench::PrintReport("game", std::move(results));
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
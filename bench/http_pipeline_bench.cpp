@@ -0,0 +1,97 @@
+// Пропускная способность одного keep-alive соединения в зависимости от глубины конвейера:
+// клиент отправляет depth запросов одной записью и затем читает depth ответов.
+// depth = 1 - классический режим "запрос - ответ".
+// Запуск: http_pipeline_bench [host] [port] [target]
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <sstream>
+
+#include "bench_util.h"
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace json = boost::json;
+using tcp = net::ip::tcp;
+using namespace std::literals;
+
+namespace
+{
+    std::string MakeRequests(std::string_view host, std::string_view target, int depth)
+    {
+        http::request<http::empty_body> request(http::verb::get, target, 11);
+        request.set(http::field::host, host);
+        request.keep_alive(true);
+
+        std::ostringstream serialized;
+        serialized << request;
+        std::string one = serialized.str();
+
+        std::string batch;
+        batch.reserve(one.size() * depth);
+        for (int i = 0; i < depth; ++i)
+            batch += one;
+        return batch;
+    }
+
+    json::object Measure(const tcp::resolver::results_type& endpoints, std::string_view host, std::string_view target, int depth)
+    {
+        net::io_context ioc;
+        tcp::socket socket(ioc);
+        net::connect(socket, endpoints);
+        socket.set_option(tcp::no_delay(true));
+
+        const std::string batch = MakeRequests(host, target, depth);
+        beast::flat_buffer buffer;
+        uint64_t bytes_received = 0;
+
+        auto round = bench::Run([&] {
+            net::write(socket, net::buffer(batch));
+            for (int i = 0; i < depth; ++i)
+            {
+                http::response<http::string_body> response;
+                bytes_received += http::read(socket, buffer, response);
+                if (response.result() != http::status::ok)
+                    throw std::runtime_error("Unexpected status "s + std::to_string(response.result_int()));
+            }
+            }, 2000ms);
+
+        json::object result;
+        result["target"] = target;
+        result["depth"] = depth;
+        result["requests"] = round.iterations * depth;
+        result["requests_per_second"] = round.OpsPerSecond() * depth;
+        result["us_per_round"] = round.NsPerOp() / 1e3;
+        result["bytes_received"] = bytes_received;
+        return result;
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+    std::string port = argc > 2 ? argv[2] : "8080";
+    std::string target = argc > 3 ? argv[3] : "/api/v1/maps";
+
+    try
+    {
+        net::io_context ioc;
+        tcp::resolver resolver(ioc);
+        auto endpoints = resolver.resolve(host, port);
+
+        json::array results;
+        for (int depth : { 1, 4, 16, 64 })
+            results.push_back(Measure(endpoints, host, target, depth));
+        bench::PrintReport("http_pipeline", std::move(results));
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
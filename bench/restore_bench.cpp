@@ -0,0 +1,199 @@
+// Время восстановления мира из снимка при запуске сервера.
+//  - flat: снимок в плоском формате, отображение в память, проверка и заполнение модели;
+//  - validate: только отображение и проверка плоского снимка;
+//  - archive: снимок прежнего формата (архив Boost.Serialization), включая перевод в плоский формат.
+// Мир синтетический: entities сущностей поровну делятся на лут на картах, собак и их игроков.
+// Каждый раунд восстанавливает мир в новую модель, в отчёт идут лучшее и среднее время раунда.
+// Запуск: restore_bench [entities] [rounds]
+#include <boost/archive/binary_oarchive.hpp>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "bench_util.h"
+#include "../src/serializator.h"
+#include "../src/player.h"
+
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace
+{
+    constexpr int MAPS = 4;
+    constexpr int ROAD_LENGTH = 1000;
+
+    std::string MapId(int i)
+    {
+        return "map" + std::to_string(i);
+    }
+
+    void AddMaps(model::Game& game)
+    {
+        for (int i = 0; i < MAPS; ++i)
+        {
+            auto map = std::make_shared<model::Map>(model::Map::Id(MapId(i)), MapId(i));
+            map->AddRoad(model::Road(model::Road::HORIZONTAL, { 0, 0 }, ROAD_LENGTH));
+            map->AddDefaultMapSpeed(4.0);
+            map->SetBagCapacity(3);
+            game.AddMap(map);
+        }
+    }
+
+    // Мир, который сохраняется и восстанавливается. Объекты держатся до конца, чтобы их id не повторились
+    struct World
+    {
+        model::Game game;
+        std::vector<std::shared_ptr<Player>> players;
+        std::unordered_map<int, std::vector<std::shared_ptr<Player>>> players_to_session;
+    };
+
+    void Populate(World& world, size_t entities)
+    {
+        AddMaps(world.game);
+        const size_t loot = entities / 3;
+        const size_t dogs = (entities - loot) / 2;
+
+        std::vector<std::shared_ptr<model::GameSession>> sessions;
+        for (int i = 0; i < MAPS; ++i)
+        {
+            auto session = std::make_shared<model::GameSession>(world.game.FindMap(model::Map::Id(MapId(i))));
+            world.game.AddSession(session, MapId(i));
+            sessions.push_back(session);
+        }
+
+        for (size_t i = 0; i < loot; ++i)
+        {
+            model::LootCoord coord{ static_cast<double>(i % ROAD_LENGTH), 0 };
+            sessions[i % MAPS]->GetMap()->AddLoot(std::make_shared<model::Loot>(static_cast<int>(i % 3), coord, 10));
+        }
+
+        for (size_t i = 0; i < dogs; ++i)
+        {
+            auto& session = sessions[i % MAPS];
+            auto dog = std::make_shared<model::Dog>(model::Direction::UP, session->GetMap()->GetDogSpeed(),
+                model::DogCoord{ static_cast<double>(i % ROAD_LENGTH), 0 });
+            // Каждая десятая собака несёт предмет
+            if (i % 10 == 0)
+                dog->AddLootElem(std::make_shared<model::Loot>(1, model::LootCoord{ 0, 0 }, 5));
+            session->AddDog(dog);
+            auto player = std::make_shared<Player>(session, dog, "player" + std::to_string(i));
+            player->SetToken(std::to_string(i));
+            world.players_to_session[session->GetObjectId()].push_back(player);
+            world.players.push_back(std::move(player));
+        }
+    }
+
+    // Снимок в формате версий до плоского: три вложенных контейнера в архиве Boost.Serialization
+    void WriteArchive(const World& world, const std::filesystem::path& path)
+    {
+        std::unordered_map<std::string, std::vector<model::LootSer>> loot;
+        std::unordered_map<std::string, std::unordered_map<int, model::DogSer>> dogs;
+        std::unordered_map<std::string, std::unordered_map<int, model::PlayerSer>> players;
+        for (const auto& [map_id, session] : world.game.GetSessions())
+        {
+            for (const auto& l : session->GetMap()->GetMapLoot())
+                loot[map_id].emplace_back(*l);
+        }
+        for (const auto& player : world.players)
+        {
+            const std::string& map_id = *player->GetSession()->GetMap()->GetId();
+            dogs[map_id].emplace(player->GetDog()->GetObjectId(), model::DogSer(*player->GetDog()));
+            players[map_id].emplace(player->GetObjectId(), model::PlayerSer(*player));
+        }
+
+        std::ofstream out(path, std::ios::out | std::ios::binary);
+        boost::archive::binary_oarchive oa{ out };
+        oa << loot;
+        oa << dogs;
+        oa << players;
+    }
+
+    size_t CountPlayers(const RestoredWorld& world)
+    {
+        size_t count = 0;
+        for (const auto& players : world.players)
+            count += players.size();
+        return count;
+    }
+
+    // Раунд: fn восстанавливает мир в новую модель. Подготовка и разрушение мира в замер не входят
+    template <typename Fn>
+    json::object Measure(std::string_view format, size_t entities, size_t rounds, Fn&& fn)
+    {
+        double best_ms = 0;
+        double total_ms = 0;
+        size_t restored = 0;
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            model::Game game;
+            AddMaps(game);
+            RestoredWorld world;
+            auto start = bench::Clock::now();
+            restored = fn(game, world);
+            double ms = std::chrono::duration<double, std::milli>(bench::Clock::now() - start).count();
+            best_ms = round == 0 ? ms : std::min(best_ms, ms);
+            total_ms += ms;
+        }
+
+        json::object result;
+        result["format"] = format;
+        result["entities"] = entities;
+        result["restored_players"] = restored;
+        result["best_ms"] = best_ms;
+        result["avg_ms"] = total_ms / static_cast<double>(rounds);
+        result["entities_per_second"] = best_ms == 0 ? 0.0 : static_cast<double>(entities) * 1e3 / best_ms;
+        return result;
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    const size_t entities = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 1000000;
+    const size_t rounds = std::max<size_t>(1, argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 3);
+
+    try
+    {
+        const auto dir = std::filesystem::temp_directory_path() / "restore_bench";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        const auto flat_path = dir / "flat";
+        const auto archive_path = dir / "archive";
+
+        {
+            World world;
+            Populate(world, entities);
+            Serializator(false, 0ms, flat_path).SerializeData(world.game.GetSessions(), world.players_to_session);
+            WriteArchive(world, archive_path);
+        }
+
+        json::array results;
+        results.push_back(Measure("flat", entities, rounds, [&](model::Game& game, RestoredWorld& world) {
+            world = Serializator(false, 0ms, flat_path).DeserializeData(game);
+            return CountPlayers(world);
+            }));
+        results.push_back(Measure("validate", entities, rounds, [&](model::Game&, RestoredWorld&) {
+            save::MappedFile file(flat_path);
+            return save::FlatView(file.GetData()).GetPlayers().size();
+            }));
+        results.push_back(Measure("archive", entities, rounds, [&](model::Game& game, RestoredWorld& world) {
+            world = Serializator(false, 0ms, archive_path).DeserializeData(game);
+            return CountPlayers(world);
+            }));
+
+        json::object sizes;
+        sizes["flat"] = std::filesystem::file_size(flat_path);
+        sizes["archive"] = std::filesystem::file_size(archive_path);
+        results.push_back(json::object{ {"file_bytes", std::move(sizes)} });
+
+        std::filesystem::remove_all(dir);
+        bench::PrintReport("restore", std::move(results));
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
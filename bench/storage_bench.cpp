@@ -0,0 +1,124 @@
+// Сравнение хранилищ зала славы: запись ушедших игроков пачками и чтение страниц /records.
+//  - write: AddRetiredPlayers пачками по 100 строк, строк в секунду;
+//  - top: первая страница из 100 строк;
+//  - offset: страница со смещения в середине таблицы;
+//  - keyset: страница после строки из середины таблицы.
+// local всегда работает во временном каталоге, postgres - только если задан GAME_DB_URL.
+// Строки бенчмарка в Postgres помечаются префиксом имени и удаляются в конце.
+// Запуск: [GAME_DB_URL=postgres://...] storage_bench [rows] [seconds-per-case]
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "bench_util.h"
+#include "../src/database.h"
+#include "../src/local_store.h"
+
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace
+{
+    constexpr std::string_view NAME_PREFIX = "storage_bench_"sv;
+    constexpr size_t BATCH = 100;
+    constexpr size_t PAGE = 100;
+
+    std::vector<storage::RetiredPlayer> MakeBatch(size_t first)
+    {
+        std::vector<storage::RetiredPlayer> batch;
+        batch.reserve(BATCH);
+        for (size_t i = first; i < first + BATCH; ++i)
+            batch.push_back({ ""s, std::string(NAME_PREFIX) + std::to_string(i), static_cast<int>(i * 7919 % 10000), static_cast<int64_t>(i * 37 % 600000) });
+        return batch;
+    }
+
+    void Measure(json::array& results, std::string_view backend, size_t rows, std::chrono::milliseconds time_per_case,
+        storage::RecordsStorage& store)
+    {
+        auto report = [&](std::string_view operation, const bench::Measurement& round, size_t rows_per_op) {
+            json::object result;
+            result["backend"] = backend;
+            result["operation"] = operation;
+            result["rows"] = rows;
+            result["ops"] = round.iterations;
+            result["rows_per_second"] = round.OpsPerSecond() * static_cast<double>(rows_per_op);
+            result["us_per_op"] = round.NsPerOp() / 1e3;
+            results.push_back(std::move(result));
+            };
+
+        // Таблица заполняется до rows строк, затем запись измеряется сверх этого
+        for (size_t written = 0; written < rows; written += BATCH)
+            store.AddRetiredPlayers(MakeBatch(written));
+
+        size_t next = rows;
+        report("write", bench::Run([&] {
+            store.AddRetiredPlayers(MakeBatch(next));
+            next += BATCH;
+            }, time_per_case), BATCH);
+
+        report("top", bench::Run([&] {
+            bench::DoNotOptimize(store.GetRetiredPlayersPage(nullptr, 0, PAGE));
+            }, time_per_case), PAGE);
+
+        const size_t middle = rows / 2;
+        report("offset", bench::Run([&] {
+            bench::DoNotOptimize(store.GetRetiredPlayersPage(nullptr, middle, PAGE));
+            }, time_per_case), PAGE);
+
+        auto anchor = store.GetRetiredPlayersPage(nullptr, middle, 1);
+        if (!anchor.empty())
+        {
+            report("keyset", bench::Run([&] {
+                bench::DoNotOptimize(store.GetRetiredPlayersPage(&anchor.front(), 0, PAGE));
+                }, time_per_case), PAGE);
+        }
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    const size_t rows = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 100000;
+    const auto time_per_case = std::chrono::milliseconds(argc > 2 ? std::atoi(argv[2]) * 1000 : 2000);
+
+    try
+    {
+        json::array results;
+        {
+            const auto dir = std::filesystem::temp_directory_path() / "storage_bench";
+            std::filesystem::remove_all(dir);
+            storage::LocalStore store{ { .dir = dir } };
+            Measure(results, "local", rows, time_per_case, store);
+            std::filesystem::remove_all(dir);
+        }
+
+        if (const char* db_url = std::getenv("GAME_DB_URL"))
+        {
+            {
+                pqxx::connection conn{ db_url };
+                postgres::Database::InitSchema(conn);
+            }
+            auto pool = std::make_shared<ConnectionPool>(1, [db_url] {
+                auto conn = std::make_shared<pqxx::connection>(db_url);
+                postgres::Database::PrepareStatements(*conn);
+                return conn;
+                });
+            postgres::Database db(pool);
+            Measure(results, "postgres", rows, time_per_case, db);
+
+            auto conn = pool->GetConnection();
+            pqxx::work w{ *conn };
+            w.exec("DELETE FROM retired_players WHERE name LIKE " + w.quote(std::string(NAME_PREFIX) + "%"));
+            w.commit();
+        }
+        else
+            std::cerr << "GAME_DB_URL is not specified, postgres is skipped" << std::endl;
+
+        bench::PrintReport("records_storage", std::move(results));
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,106 @@
+#include "admission_control.h"
+
+#include <algorithm>
+
+namespace admission
+{
+    RequestClass Classify(std::string_view target)
+    {
+        target = target.substr(0, target.find('?'));
+        if (target == "/api/v1/game/join"sv || target == "/api/v1/game/player/action"sv || target == "/api/v1/game/tick"sv)
+            return RequestClass::CRITICAL;
+        if (target.starts_with("/api/v1/maps"sv) || target.starts_with("/api/v1/game/records"sv)
+            || target.starts_with("/api/v1/game/leaderboard"sv) || target == "/api/v1/game/player/rank"sv)
+            return RequestClass::READ;
+        return RequestClass::STATE;
+    }
+
+    std::string_view GetClassName(RequestClass request_class)
+    {
+        switch (request_class)
+        {
+        case RequestClass::CRITICAL:
+            return "critical"sv;
+        case RequestClass::STATE:
+            return "state"sv;
+        case RequestClass::READ:
+            return "read"sv;
+        }
+        return "unknown"sv;
+    }
+
+    AdmissionController::Ticket::Ticket(Ticket&& other) noexcept
+        : controller_(other.controller_)
+        , request_class_(other.request_class_)
+        , queued_(other.queued_)
+    {
+        other.controller_ = nullptr;
+    }
+
+    AdmissionController::Ticket::~Ticket()
+    {
+        if (!controller_)
+            return;
+        Started();
+        controller_->stats_[static_cast<size_t>(request_class_)].in_flight.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void AdmissionController::Ticket::Started() noexcept
+    {
+        if (!controller_ || !queued_)
+            return;
+        queued_ = false;
+        controller_->simulation_depth_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    std::optional<AdmissionController::Ticket> AdmissionController::TryAdmit(RequestClass request_class, bool simulation)
+    {
+        auto& stats = stats_[static_cast<size_t>(request_class)];
+
+        // Счётчик увеличивается заранее и откатывается при отказе: так два потока не займут последнее место одновременно
+        int64_t in_flight = stats.in_flight.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t budget = GetBudget(request_class);
+        bool over_budget = budget != 0 && static_cast<size_t>(in_flight) > budget;
+        size_t depth_limit = simulation ? GetDepthLimit(request_class) : 0;
+        bool overloaded = depth_limit != 0
+            && static_cast<size_t>(simulation_depth_.load(std::memory_order_relaxed)) >= depth_limit;
+
+        if (over_budget || overloaded)
+        {
+            stats.in_flight.fetch_sub(1, std::memory_order_relaxed);
+            stats.rejected.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        if (simulation)
+            simulation_depth_.fetch_add(1, std::memory_order_relaxed);
+        stats.admitted.fetch_add(1, std::memory_order_relaxed);
+        return Ticket{ this, request_class, simulation };
+    }
+
+    size_t AdmissionController::GetBudget(RequestClass request_class) const noexcept
+    {
+        switch (request_class)
+        {
+        case RequestClass::STATE:
+            return options_.state_budget;
+        case RequestClass::READ:
+            return options_.read_budget;
+        default:
+            return 0;
+        }
+    }
+
+    size_t AdmissionController::GetDepthLimit(RequestClass request_class) const noexcept
+    {
+        switch (request_class)
+        {
+        case RequestClass::STATE:
+            return options_.max_queue_depth;
+        case RequestClass::READ:
+            return options_.max_queue_depth == 0 ? 0 : std::max<size_t>(1, options_.max_queue_depth / 2);
+        default:
+            return 0;
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace admission
+{
+    using namespace std::literals;
+
+    // Приоритет API-запроса при перегрузке потока симуляции
+    enum class RequestClass
+    {
+        // join, action, tick - изменяют игру, не отклоняются никогда и идут в срочную очередь потока симуляции
+        CRITICAL,
+        // state, players и прочие запросы игрока - отклоняются, когда очередь потока симуляции дошла до предела
+        STATE,
+        // maps, records, таблицы лидеров - ограничены своим бюджетом, а ждущие поток симуляции отклоняются уже на половине предела
+        READ
+    };
+
+    constexpr size_t REQUEST_CLASS_COUNT = 3;
+
+    RequestClass Classify(std::string_view target);
+    std::string_view GetClassName(RequestClass request_class);
+
+    // 0 в любом пределе означает "без ограничения"
+    struct Options
+    {
+        // Сколько допущенных запросов может ждать поток симуляции. Предел касается только запросов,
+        // которые сами встали бы в эту очередь: state из снимка, maps и records её не удлиняют
+        size_t max_queue_depth = 256;
+        // Сколько запросов класса одновременно находится в очереди или выполняется
+        size_t state_budget = 128;
+        size_t read_budget = 32;
+        unsigned retry_after_seconds = 1;
+    };
+
+    struct ClassStats
+    {
+        std::atomic<uint64_t> admitted{ 0 };
+        std::atomic<uint64_t> rejected{ 0 };
+        std::atomic<int64_t> in_flight{ 0 };
+    };
+
+    // Считает допущенные запросы и отдельно - ждущие поток симуляции, отказывает в допуске до постановки в очередь.
+    // Все счётчики атомарные: TryAdmit вызывается с IO-потоков, Ticket освобождается на strand
+    class AdmissionController
+    {
+    public:
+        // Допуск одного запроса. Живёт в обработчике на strand и освобождает бюджет в деструкторе
+        class Ticket
+        {
+        public:
+            Ticket(Ticket&& other) noexcept;
+            Ticket& operator=(Ticket&&) = delete;
+            Ticket(const Ticket&) = delete;
+            Ticket& operator=(const Ticket&) = delete;
+            ~Ticket();
+
+            // Вызывается, когда strand добрался до запроса: он больше не стоит в очереди
+            void Started() noexcept;
+
+        private:
+            friend class AdmissionController;
+            Ticket(AdmissionController* controller, RequestClass request_class, bool simulation) noexcept
+                : controller_(controller), request_class_(request_class), queued_(simulation) {}
+
+            AdmissionController* controller_;
+            RequestClass request_class_;
+            // Стоит в очереди потока симуляции
+            bool queued_;
+        };
+
+        explicit AdmissionController(Options options) : options_(options) {}
+        AdmissionController(const AdmissionController&) = delete;
+        AdmissionController& operator=(const AdmissionController&) = delete;
+
+        // simulation - запрос будет выполняться на потоке симуляции и до начала увеличивает его очередь
+        std::optional<Ticket> TryAdmit(RequestClass request_class, bool simulation);
+
+        const Options& GetOptions() const noexcept
+        {
+            return options_;
+        }
+
+        int64_t GetSimulationDepth() const noexcept
+        {
+            return simulation_depth_.load(std::memory_order_relaxed);
+        }
+
+        const ClassStats& GetStats(RequestClass request_class) const noexcept
+        {
+            return stats_[static_cast<size_t>(request_class)];
+        }
+
+    private:
+        Options options_;
+        std::atomic<int64_t> simulation_depth_{ 0 };
+        std::array<ClassStats, REQUEST_CLASS_COUNT> stats_;
+
+        size_t GetBudget(RequestClass request_class) const noexcept;
+        // Длина очереди потока симуляции, с которой запросы класса отклоняются. 0 - без ограничения
+        size_t GetDepthLimit(RequestClass request_class) const noexcept;
+    };
+}
@@ -0,0 +1,79 @@
+#include "api_executor.h"
+
+#include <algorithm>
+
+namespace api_executor
+{
+    WorkClass GetWorkClass(std::string_view target)
+    {
+        target = target.substr(0, target.find('?'));
+        if (target == "/api/v1/game/state"sv || target == "/api/v1/game/players"sv || target.starts_with("/api/v1/maps"sv))
+            return WorkClass::READ;
+        if (target.starts_with("/api/v1/game/records"sv))
+            return WorkClass::DATABASE;
+        return WorkClass::SIMULATION;
+    }
+
+    std::string_view GetWorkClassName(WorkClass work_class)
+    {
+        switch (work_class)
+        {
+        case WorkClass::SIMULATION:
+            return "simulation"sv;
+        case WorkClass::READ:
+            return "read"sv;
+        case WorkClass::DATABASE:
+            return "database"sv;
+        }
+        return "unknown"sv;
+    }
+
+    ApiExecutor::ApiExecutor(net::any_io_executor read_executor, unsigned db_threads)
+        : sim_strand_(net::make_strand(sim_ioc_))
+        , sim_work_(net::make_work_guard(sim_ioc_))
+        , read_executor_(std::move(read_executor))
+        , db_pool_(std::max(1u, db_threads))
+    {
+    }
+
+    ApiExecutor::~ApiExecutor()
+    {
+        Stop();
+    }
+
+    void ApiExecutor::Start()
+    {
+        if (sim_thread_.joinable())
+            return;
+        sim_thread_ = std::jthread([this] {
+            sim_ioc_.run();
+            });
+    }
+
+    void ApiExecutor::Stop()
+    {
+        sim_work_.reset();
+        sim_ioc_.stop();
+        if (sim_thread_.joinable())
+            sim_thread_.join();
+        db_pool_.stop();
+        db_pool_.join();
+        std::lock_guard lock{ sim_mutex_ };
+        sim_urgent_.clear();
+        sim_normal_.clear();
+    }
+
+    void ApiExecutor::RunNextSimulation()
+    {
+        std::function<void()> task;
+        {
+            std::lock_guard lock{ sim_mutex_ };
+            auto& queue = sim_urgent_.empty() ? sim_normal_ : sim_urgent_;
+            if (queue.empty())
+                return;
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+namespace api_executor
+{
+    namespace net = boost::asio;
+    using namespace std::literals;
+    using Strand = net::strand<net::io_context::executor_type>;
+
+    // Где выполняется API-запрос
+    enum class WorkClass
+    {
+        // join, action, tick и автоматический тикер - изменяют модель, строго по очереди
+        SIMULATION,
+        // state, players, maps - читают опубликованный снимок или неизменяемый кэш, параллельно на IO-потоках
+        READ,
+        // records - блокирующие запросы к БД
+        DATABASE
+    };
+
+    constexpr size_t WORK_CLASS_COUNT = 3;
+
+    // Очередь работы симуляции. Срочная разбирается первой
+    enum class Priority
+    {
+        // тики, join, action
+        URGENT,
+        // остальные запросы, которым нужна модель
+        NORMAL
+    };
+
+    WorkClass GetWorkClass(std::string_view target);
+    std::string_view GetWorkClassName(WorkClass work_class);
+
+    // Разводит API-запросы по классам работ с явными приоритетами:
+    // - у симуляции свой io_context и поток, тик не ждёт в общей очереди IO-потоков за чтением сокетов и сжатием,
+    //   а в очереди симуляции срочные задачи обходят обычные;
+    // - чтения выполняются на IO-потоках (read_executor), их количество ограничивает admission control;
+    // - запросы к БД идут в отдельный пул, блокирующий pqxx не занимает ни IO-потоки, ни поток симуляции
+    class ApiExecutor
+    {
+    public:
+        ApiExecutor(net::any_io_executor read_executor, unsigned db_threads);
+        ApiExecutor(const ApiExecutor&) = delete;
+        ApiExecutor& operator=(const ApiExecutor&) = delete;
+        ~ApiExecutor();
+
+        void Start();
+        // Останавливает поток симуляции и пул БД. Невыполненные задачи отбрасываются
+        void Stop();
+
+        Strand& GetSimulationStrand() noexcept
+        {
+            return sim_strand_;
+        }
+
+        // Отдельный strand на потоке симуляции для таймеров: срабатывание не ждёт очереди запросов,
+        // а саму работу таймер ставит в срочную очередь через Execute
+        Strand MakeTimerStrand()
+        {
+            return net::make_strand(sim_ioc_);
+        }
+
+        const net::any_io_executor& GetReadExecutor() const noexcept
+        {
+            return read_executor_;
+        }
+
+        // priority учитывается только для SIMULATION
+        template <typename Handler>
+        void Execute(WorkClass work_class, Handler&& handler, Priority priority = Priority::NORMAL)
+        {
+            submitted_[static_cast<size_t>(work_class)].fetch_add(1, std::memory_order_relaxed);
+            switch (work_class)
+            {
+            case WorkClass::SIMULATION:
+            {
+                // Каждая задача ставит в strand один вызов RunNextSimulation, а он берёт самую срочную из ждущих
+                if (priority == Priority::URGENT)
+                    urgent_submitted_.fetch_add(1, std::memory_order_relaxed);
+                auto task = std::make_shared<std::decay_t<Handler>>(std::forward<Handler>(handler));
+                {
+                    std::lock_guard lock{ sim_mutex_ };
+                    (priority == Priority::URGENT ? sim_urgent_ : sim_normal_).push_back([task] { (*task)(); });
+                }
+                return net::post(sim_strand_, [this] { RunNextSimulation(); });
+            }
+            case WorkClass::READ:
+                // Вызов приходит с IO-потока, поэтому чтение выполняется сразу, без лишней очереди
+                return net::dispatch(read_executor_, std::forward<Handler>(handler));
+            case WorkClass::DATABASE:
+                return net::post(db_pool_, std::forward<Handler>(handler));
+            }
+        }
+
+        uint64_t GetSubmitted(WorkClass work_class) const noexcept
+        {
+            return submitted_[static_cast<size_t>(work_class)].load(std::memory_order_relaxed);
+        }
+
+        uint64_t GetUrgentSubmitted() const noexcept
+        {
+            return urgent_submitted_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        net::io_context sim_ioc_{ 1 };
+        Strand sim_strand_;
+        net::executor_work_guard<net::io_context::executor_type> sim_work_;
+        std::jthread sim_thread_;
+        net::any_io_executor read_executor_;
+        net::thread_pool db_pool_;
+        std::array<std::atomic<uint64_t>, WORK_CLASS_COUNT> submitted_{};
+        std::atomic<uint64_t> urgent_submitted_{ 0 };
+        std::mutex sim_mutex_;
+        std::deque<std::function<void()>> sim_urgent_;
+        std::deque<std::function<void()>> sim_normal_;
+
+        void RunNextSimulation();
+    };
+}
@@ -1,17 +1,54 @@
 #include "application.h"
-#include <fstream>
+#include "log_data.h"
 
-Application::Application(model::Game& game, GameSettings settings, std::filesystem::path save_path, std::unique_ptr<postgres::Database> db) :
+namespace
+{
+	std::vector<std::string> GetMapIds(const model::Game& game)
+	{
+		std::vector<std::string> ids;
+		for (const auto& map : game.GetMaps())
+			ids.push_back(*map->GetId());
+		return ids;
+	}
+
+	leaderboard::Entry ToEntry(const storage::RetiredPlayer& player)
+	{
+		return { player.score, player.play_time_ms, player.name, player.id };
+	}
+
+	storage::RetiredPlayer ToRetiredPlayer(leaderboard::Entry entry)
+	{
+		return { std::move(entry.id), std::move(entry.name), entry.score, entry.play_time_ms };
+	}
+}
+
+Application::Application(model::Game& game, GameSettings settings, std::filesystem::path save_path, std::unique_ptr<storage::RecordsStorage> records_storage,
+	retirement::Options retirement_options, size_t records_cache_size, std::unique_ptr<wal::WriteAheadLog> wal) :
 	game_(game),
 	settings_(settings),
 	players_(std::make_unique<Players>()),
 	tokens_(std::make_unique<token::PlayersTokens>()),
+	wal_(std::move(wal)),
 	serializator_(std::make_unique<Serializator>
 		(settings.is_auto_save_mode,
 			std::chrono::milliseconds(settings.save_period),
 			save_path)),
-	db_(std::move(db))
-{}
+	records_storage_(std::move(records_storage)),
+	records_cache_(std::make_unique<records::RecordsCache>(records_cache_size)),
+	retirement_writer_(std::make_unique<retirement::RetirementWriter>(
+		[records_storage = records_storage_.get()](const std::vector<storage::RetiredPlayer>& plrs) { records_storage->AddRetiredPlayers(plrs); },
+		retirement_options)),
+	profiler_(GetMapIds(game))
+{
+	serializator_->SetWal(wal_.get());
+	LoadHallOfFame(records_cache_size);
+	game_.SetProfiler(&profiler_);
+}
+
+Application::~Application()
+{
+	game_.SetProfiler(nullptr);
+}
 
 std::shared_ptr<Player> Application::FindPlayerByToken(Token token)
 {
@@ -28,9 +65,69 @@ const std::vector<std::shared_ptr<Player>> Application::GetPlayersInSession(int
 	return players_->GetPlayersInSession(session_id);
 }
 
+const std::unordered_map<int, std::vector<std::shared_ptr<Player>>>& Application::GetAllPlayersBySessions() const
+{
+	return players_->GetAllPlayersBySessions();
+}
+
 void Application::AddPlayer(std::shared_ptr<Player> player)
 {
 	players_->Add(player);
+	UpdateLiveEntry(player);
+	MarkStateChanged();
+}
+
+std::shared_ptr<Player> Application::JoinGame(const std::string& map_id, const std::string& name)
+{
+	auto map = game_.FindMap(model::Map::Id(map_id));
+	model::DogCoord coords = settings_.randomize_spawn_points ? map->GetRandomPosDog() : map->GetStartPosDog();
+	auto player = AddJoinedPlayer(map_id, name, coords);
+	Token token = SetTokenForPlayer(player);
+	player->SetToken(*token);
+
+	// Токен и точка появления случайны, поэтому в журнал идут готовые значения
+	if (wal_ && !replaying_)
+		wal_->Append(wal::JoinRecord{ player->GetObjectId(), map_id, name, *token, coords });
+	// Точку появления повтор получает из того же генератора карты
+	if (recorder_)
+		recorder_->Append(sim_record::Join{ player->GetDog()->GetObjectId(), map_id, name });
+	return player;
+}
+
+void Application::MovePlayer(const std::shared_ptr<Player>& player, const std::string& move)
+{
+	player->GetDog()->ClearIdleTime();
+	if (move.empty())
+		player->GetDog()->StopDog();
+	else
+	{
+		player->GetDog()->SetInGameDirection(static_cast<model::Direction>(move.back()));
+		player->GetDog()->SetInGameSpeed();
+	}
+	MarkStateChanged();
+
+	if (wal_ && !replaying_)
+		wal_->Append(wal::ActionRecord{ player->GetPlayerToken(), move });
+	if (recorder_)
+		recorder_->Append(sim_record::Action{ player->GetDog()->GetObjectId(), move.empty() ? '\0' : move.back() });
+}
+
+void Application::Tick(std::chrono::milliseconds delta)
+{
+	tick_profile::ScopedTimer tick_timer(&profiler_, tick_profile::Phase::TICK);
+	OnTick(delta);
+	// Лут забирается и без журнала, иначе он копился бы в Game
+	auto loot = game_.TakeSpawnedLoot();
+	if (wal_)
+	{
+		tick_profile::ScopedTimer timer(&profiler_, tick_profile::Phase::COMMAND_LOG);
+		wal_->Append(wal::TickRecord{ delta.count(), std::move(loot) });
+	}
+	DeleteUnusedInfo(delta);
+	if (recorder_)
+		recorder_->Append(sim_record::Tick{ delta.count(), game_.GetStateDigest() });
+	tick_profile::ScopedTimer timer(&profiler_, tick_profile::Phase::SERIALIZATION);
+	SerializeOnTick(delta);
 }
 
 GameSettings& Application::GetSettings()
@@ -55,16 +152,52 @@ void Application::SerializeOnTick(std::chrono::milliseconds time)
 
 void Application::Deserialize()
 {
-	serializator_->DeserializeData(*this);
+	RestoredWorld restored = serializator_->DeserializeData(game_);
+
+	// Таблицы игроков и токенов собираются целиком и подменяют пустые разом
+	size_t count = 0;
+	for (const auto& players : restored.players)
+		count += players.size();
+	auto players = std::make_unique<Players>();
+	auto tokens = std::make_unique<token::PlayersTokens>();
+	tokens->Reserve(count);
+	for (size_t i = 0; i < restored.sessions.size(); ++i)
+	{
+		players->AddSessionPlayers(restored.sessions[i]->GetObjectId(), restored.players[i]);
+		for (const auto& player : restored.players[i])
+			tokens->AddTokenAndPlayer(player, Token(player->GetPlayerToken()));
+	}
+	players_ = std::move(players);
+	tokens_ = std::move(tokens);
+
+	for (const auto& session_players : restored.players)
+	{
+		for (const auto& player : session_players)
+			UpdateLiveEntry(player);
+	}
+	for (const auto& session : restored.sessions)
+		game_.AddSession(session, *session->GetMap()->GetId());
+	MarkStateChanged();
+
+	if (wal_)
+	{
+		ReplayWal(serializator_->GetRestoredCheckpoint());
+		serializator_->ReserveCheckpoints(wal_->GetLastSegment());
+	}
+	// Снимок покрывает повторённые команды, после его записи старые сегменты журнала удаляются
+	if (settings_.is_save_mode)
+		Serialize();
 }
 
 void Application::RestoreToken(Token token, std::shared_ptr<Player> player)
 {
 	tokens_->AddTokenAndPlayer(player, token);
+	MarkStateChanged();
 }
 
 void Application::DeleteUnusedInfo(std::chrono::milliseconds delta)
 {
+	tick_profile::ScopedTimer timer(&profiler_, tick_profile::Phase::RETIREMENT);
 	auto ids = game_.GetIdleDogs(delta);
 	if (ids.empty())
 		return;
@@ -75,33 +208,149 @@ void Application::DeleteUnusedInfo(std::chrono::milliseconds delta)
 		plrs.push_back(players_->GetPlayerByIndx(id));
 	}
 
-	AddRetiredPlayersToDB(plrs);
+	{
+		tick_profile::ScopedTimer db_timer(&profiler_, tick_profile::Phase::DB_WRITE);
+		AddRetiredPlayersToDB(plrs);
+	}
 	DeleteIdlePlayers(delta, ids);
 	plrs.clear();
 	DeleteEmptySessions();
+	MarkStateChanged();
 }
 
-std::vector<std::tuple<std::string, int, int>> Application::GetRetiredPlayersInfo(RecordsParams& p)
+records::RecordsPage Application::GetRetiredPlayersInfo(RecordsParams& p)
 {
-	return db_->GetRetiredPlayersFromDB(p);
+	std::optional<storage::RetiredPlayer> after;
+	if (!p.cursor.empty())
+	{
+		after = records::DecodeCursor(p.cursor);
+		if (!after)
+			throw std::invalid_argument("Invalid records cursor");
+	}
+	const storage::RetiredPlayer* after_ptr = after ? &*after : nullptr;
+
+	records::RecordsPage page;
+	if (auto cached = records_cache_->TryGetPage(after_ptr, p.start, p.maxItems))
+		page.rows = std::move(*cached);
+	else
+		page.rows = records_storage_->GetRetiredPlayersPage(after_ptr, p.start, p.maxItems);
+
+	if (p.maxItems != 0 && page.rows.size() == p.maxItems)
+		page.next_cursor = records::EncodeCursor(page.rows.back());
+	return page;
 }
 
 void Application::OnTick(std::chrono::milliseconds time)
 {
-	std::fstream out;
-	if (!out.is_open())
 	{
-		out.open("/tmp/volume/log.txt", std::ios::out | std::ios::app);
+		tick_profile::ScopedTimer timer(&profiler_, tick_profile::Phase::PLAYTIME);
+		UpdateAllPlayersPlayTime(time);
+	}
+	// Лут, движение и сбор Game замеряет сам, по каждой карте
+	game_.UpdateGameState(time);
+	live_clock_ += time;
+	for (int dog_id : game_.TakeScoredDogs())
+		UpdateLiveEntry(players_->GetPlayerByIndx(dog_id));
+	MarkStateChanged();
+}
+
+void Application::MarkStateChanged()
+{
+	state_version_.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t Application::GetStateVersion() const
+{
+	return state_version_.load(std::memory_order_acquire);
+}
+
+std::shared_ptr<Player> Application::AddJoinedPlayer(const std::string& map_id, const std::string& name, model::DogCoord coords)
+{
+	std::shared_ptr<model::GameSession> session;
+	std::shared_ptr<model::Map> map;
+	bool is_session_exist = game_.IsSessionExist(map_id);
+	if (is_session_exist)
+	{
+		session = game_.GetSession(map_id);
+		map = session->GetMap();
+	}
+	else
+	{
+		map = game_.FindMap(model::Map::Id(map_id));
+		session = std::make_shared<model::GameSession>(map);
 	}
 
-	//"C:\\Users\\impro\\Desktop\\fall_logs\\test_log.txt"
+	auto dog = std::make_shared<model::Dog>(model::Direction::UP, map->GetDogSpeed(), coords);
+	session->AddDog(dog);
+	auto player = std::make_shared<Player>(session, dog, name);
+	AddPlayer(player);
 
-	out << "START UPDATE ALL PLAYERS PLAYTIME" << std::endl;
-	UpdateAllPlayersPlayTime(time);
-	out << "END UPDATE ALL PLAYERS PLAYTIME" << std::endl;
-	out << "START UpdateGameState" << std::endl;
-	game_.UpdateGameState(time);
-	out << "END UpdateGameState" << std::endl;
+	if (is_session_exist)
+		game_.UpdateSession(session, map_id);
+	else
+		game_.AddSession(session, map_id);
+	return player;
+}
+
+void Application::ReplayWal(uint64_t checkpoint)
+{
+	auto records = wal_->ReadFrom(checkpoint);
+	if (records.empty())
+		return;
+
+	replaying_ = true;
+	for (const auto& record : records)
+		std::visit([this](const auto& r) { Apply(r); }, record);
+	replaying_ = false;
+	BOOST_LOG_TRIVIAL(info) << boost::log::add_value(data, boost::json::object{
+		{"message", "command log replayed"},
+		{"data", boost::json::object{ {"commands", records.size()}, {"checkpoint", checkpoint} }}
+		});
+}
+
+void Application::Apply(const wal::JoinRecord& record)
+{
+	if (!game_.FindMap(model::Map::Id(record.map_id)))
+		return;
+
+	// id выдаются счётчиками, которые на восстановленном мире могут отставать от записанных
+	model::Dog::ReserveIds(record.player_id - 1);
+	Player::ReserveIds(record.player_id - 1);
+	auto player = AddJoinedPlayer(record.map_id, record.name, record.coords);
+	RestoreToken(Token(record.token), player);
+	player->SetToken(record.token);
+}
+
+void Application::Apply(const wal::ActionRecord& record)
+{
+	if (auto player = FindPlayerByToken(Token(record.token)))
+		MovePlayer(player, record.move);
+}
+
+void Application::Apply(const wal::TickRecord& record)
+{
+	std::chrono::milliseconds delta(record.delta_ms);
+	game_.SetReplayLoot(record.loot);
+	OnTick(delta);
+	DeleteUnusedInfo(delta);
+}
+
+void Application::Apply(const wal::RetireRecord& record)
+{
+	// Строки, которые успели дойти до хранилища, уже загружены в зал славы
+	std::vector<storage::RetiredPlayer> missing;
+	for (const auto& row : record.players)
+	{
+		auto entry = ToEntry(row);
+		if (hall_of_fame_.GetRank(entry))
+			continue;
+		hall_of_fame_.Insert(std::move(entry));
+		missing.push_back(row);
+	}
+	if (missing.empty())
+		return;
+	records_cache_->Add(missing);
+	retirement_writer_->Enqueue(std::move(missing));
 }
 
 void Application::DeleteEmptySessions()
@@ -114,6 +363,7 @@ void Application::DeleteIdlePlayers(std::chrono::milliseconds time, std::vector<
 	for (const auto& id : ids)
 	{
 		auto player = players_->GetPlayerByIndx(id);
+		EraseLiveEntry(player);
 		tokens_->DeletePlayerByToken(Token(player->GetPlayerToken()));
 		players_->DeletePlayer(id);
 	}
@@ -121,7 +371,138 @@ void Application::DeleteIdlePlayers(std::chrono::milliseconds time, std::vector<
 
 void Application::AddRetiredPlayersToDB(std::vector<std::shared_ptr<Player>>& ids)
 {
-	db_->AddRetiredPlayersToDB(ids);
+	// При повторе строки с теми же id придут из RetireRecord
+	if (replaying_)
+		return;
+
+	// Тик не ждёт базу: строки копируются и уходят в очередь отдельного потока
+	std::vector<storage::RetiredPlayer> retired;
+	retired.reserve(ids.size());
+	for (const auto& plr : ids)
+	{
+		// id создаётся здесь, чтобы строка в кэше и в БД имела один ключ для курсора
+		retired.push_back({ util::detail::UUIDToString(util::detail::NewUUID()), plr->GetName(),
+			plr->GetDog()->GetCurrentScore(), static_cast<int64_t>(plr->GetPlayTime().count()) });
+	}
+	for (const auto& row : retired)
+		hall_of_fame_.Insert(ToEntry(row));
+	if (wal_)
+		wal_->Append(wal::RetireRecord{ retired });
+	records_cache_->Add(retired);
+	retirement_writer_->Enqueue(std::move(retired));
+}
+
+const retirement::RetirementWriter& Application::GetRetirementWriter() const
+{
+	return *retirement_writer_;
+}
+
+const Serializator& Application::GetSerializator() const
+{
+	return *serializator_;
+}
+
+const wal::WriteAheadLog* Application::GetWal() const
+{
+	return wal_.get();
+}
+
+void Application::SetRecorder(std::unique_ptr<sim_record::Recorder> recorder)
+{
+	// Повтор начинает с пустого мира: восстановленных из снимка объектов в записи не было бы
+	if (game_.IsAnySession())
+		throw std::logic_error("Recording must start from an empty world, start the server without a saved state");
+	recorder_ = std::move(recorder);
+}
+
+const storage::RecordsStorage& Application::GetRecordsStorage() const
+{
+	return *records_storage_;
+}
+
+void Application::FlushRetirements()
+{
+	retirement_writer_->Stop();
+}
+
+PlayerRank Application::GetPlayerRank(const std::shared_ptr<Player>& player) const
+{
+	PlayerRank rank;
+	rank.map_id = *player->GetSession()->GetMap()->GetId();
+	rank.score = player->GetDog()->GetCurrentScore();
+
+	const leaderboard::RankTree& live = live_boards_.at(rank.map_id);
+	rank.live_rank = live.GetRank(live_entries_.at(player->GetObjectId())).value();
+	rank.live_players = live.Size();
+
+	// Место, которое игрок занял бы в зале славы, если бы ушёл сейчас
+	rank.hall_of_fame_rank = hall_of_fame_.CountHigher({ rank.score, static_cast<int64_t>(player->GetPlayTime().count()), player->GetName(), "" });
+	rank.hall_of_fame_players = hall_of_fame_.Size();
+	return rank;
+}
+
+std::vector<leaderboard::Entry> Application::GetLiveLeaderboard(const std::string& map_id, size_t offset, size_t limit) const
+{
+	auto it = live_boards_.find(map_id);
+	if (it == live_boards_.end())
+		return {};
+
+	auto entries = it->second.GetRange(offset, limit);
+	for (auto& entry : entries)
+		entry.play_time_ms += live_clock_.count();
+	return entries;
+}
+
+const tick_profile::TickProfiler& Application::GetTickProfiler() const
+{
+	return profiler_;
+}
+
+void Application::LoadHallOfFame(size_t records_cache_size)
+{
+	// Таблица читается целиком по ключу, без OFFSET
+	constexpr size_t LOAD_BATCH = 10000;
+	std::optional<storage::RetiredPlayer> after;
+	while (true)
+	{
+		auto page = records_storage_->GetRetiredPlayersPage(after ? &*after : nullptr, 0, LOAD_BATCH);
+		for (const auto& row : page)
+			hall_of_fame_.Insert(ToEntry(row));
+		if (page.size() < LOAD_BATCH)
+			break;
+		after = std::move(page.back());
+	}
+
+	std::vector<storage::RetiredPlayer> top;
+	for (auto& entry : hall_of_fame_.GetRange(0, records_cache_size))
+		top.push_back(ToRetiredPlayer(std::move(entry)));
+	records_cache_->Reset(std::move(top));
+}
+
+void Application::UpdateLiveEntry(const std::shared_ptr<Player>& player)
+{
+	auto& board = live_boards_[*player->GetSession()->GetMap()->GetId()];
+	auto [it, inserted] = live_entries_.try_emplace(player->GetObjectId());
+	if (!inserted)
+		board.Erase(it->second);
+	else
+		it->second = { 0, (player->GetPlayTime() - live_clock_).count(), player->GetName(), std::to_string(player->GetObjectId()) };
+
+	it->second.score = player->GetDog()->GetCurrentScore();
+	board.Insert(it->second);
+}
+
+void Application::EraseLiveEntry(const std::shared_ptr<Player>& player)
+{
+	auto it = live_entries_.find(player->GetObjectId());
+	if (it == live_entries_.end())
+		return;
+
+	auto board = live_boards_.find(*player->GetSession()->GetMap()->GetId());
+	board->second.Erase(it->second);
+	if (board->second.Size() == 0)
+		live_boards_.erase(board);
+	live_entries_.erase(it);
 }
 
 void Application::UpdateAllPlayersPlayTime(std::chrono::milliseconds time)
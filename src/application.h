@@ -1,11 +1,19 @@
 #pragma once
 #include <pqxx/pqxx>
+#include <atomic>
 
 #include "model.h"
 #include "players.h"
 #include "players_tokens.h"
 #include "serializator.h"
-#include "database.h"
+#include "records_storage.h"
+#include "tagged_uuid.h"
+#include "retirement_writer.h"
+#include "records_cache.h"
+#include "leaderboard.h"
+#include "wal.h"
+#include "sim_record.h"
+#include "tick_profiler.h"
 
 struct GameSettings
 {
@@ -17,34 +25,101 @@ struct GameSettings
 	uint32_t retirement_time;
 };
 
+// Места игрока с нуля: среди живых игроков его карты и в зале славы с текущим счётом
+struct PlayerRank
+{
+	std::string map_id;
+	int score;
+	size_t live_rank;
+	size_t live_players;
+	size_t hall_of_fame_rank;
+	size_t hall_of_fame_players;
+};
+
 class Application
 {
 public:
-	Application(model::Game& game, GameSettings settings, std::filesystem::path save_path, std::unique_ptr<postgres::Database> db);
+	// wal - журнал команд. Без него мир восстанавливается только на последнюю контрольную точку
+	Application(model::Game& game, GameSettings settings, std::filesystem::path save_path, std::unique_ptr<storage::RecordsStorage> records_storage,
+		retirement::Options retirement_options = {}, size_t records_cache_size = 1000, std::unique_ptr<wal::WriteAheadLog> wal = nullptr);
+	// Отключает профайлер от Game, которая живёт дольше
+	~Application();
 	std::shared_ptr<Player> FindPlayerByToken(Token token);
 	Token SetTokenForPlayer(std::shared_ptr<Player> player);
 	const std::vector<std::shared_ptr<Player>> GetPlayersInSession(int session_id) const;
+	const std::unordered_map<int, std::vector<std::shared_ptr<Player>>>& GetAllPlayersBySessions() const;
 	void AddPlayer(std::shared_ptr<Player> player);
+	// Команды, меняющие мир. Вызываются на strand симуляции и пишутся в журнал команд
+	std::shared_ptr<Player> JoinGame(const std::string& map_id, const std::string& name);
+	// move - направление или пустая строка для остановки
+	void MovePlayer(const std::shared_ptr<Player>& player, const std::string& move);
+	void Tick(std::chrono::milliseconds delta);
 	GameSettings& GetSettings();
 	model::Game& GetGame();
 	void Serialize();
 	void SerializeOnTick(std::chrono::milliseconds time);
+	// Снимок, журнал изменений, затем команды из журнала команд. Восстановленный мир сразу сохраняется новым снимком
 	void Deserialize();
 	void RestoreToken(Token token, std::shared_ptr<Player> player);
 	void DeleteUnusedInfo(std::chrono::milliseconds delta);
-	std::vector<std::tuple<std::string, int, int>> GetRetiredPlayersInfo(RecordsParams& p);
+	// Первые страницы берутся из кэша, остальные - из БД. Повреждённый курсор - std::invalid_argument
+	records::RecordsPage GetRetiredPlayersInfo(RecordsParams& p);
 	void OnTick(std::chrono::milliseconds time);
+	// Версия игрового состояния растёт при каждом изменении, видимом в state/players.
+	// Меняется только на strand симуляции, читается с любого потока
+	void MarkStateChanged();
+	uint64_t GetStateVersion() const;
+	const retirement::RetirementWriter& GetRetirementWriter() const;
+	const Serializator& GetSerializator() const;
+	// nullptr, если журнал команд выключен
+	const wal::WriteAheadLog* GetWal() const;
+	// Записывает команды и тики для повтора вне сервера. Запись начинается только с пустого мира, иначе std::logic_error
+	void SetRecorder(std::unique_ptr<sim_record::Recorder> recorder);
+	const storage::RecordsStorage& GetRecordsStorage() const;
+	// Дописывает ушедших игроков в БД. Вызывается при остановке сервера
+	void FlushRetirements();
+	// Таблицы лидеров меняются и читаются только на strand симуляции
+	PlayerRank GetPlayerRank(const std::shared_ptr<Player>& player) const;
+	// Живые игроки карты по местам, play_time_ms - текущее время игры
+	std::vector<leaderboard::Entry> GetLiveLeaderboard(const std::string& map_id, size_t offset, size_t limit) const;
+	// Время фаз тиков. Счётчики атомарные, читать можно с любого потока
+	const tick_profile::TickProfiler& GetTickProfiler() const;
 
 private:
 	model::Game& game_;
 	GameSettings settings_;
 	std::unique_ptr<Players> players_;
 	std::unique_ptr<token::PlayersTokens> tokens_;
+	// Объявлен перед serializator_: потоку сохранений журнал нужен до самой остановки
+	std::unique_ptr<wal::WriteAheadLog> wal_;
+	// Идёт повтор журнала: команды не пишутся в него заново, ушедшие игроки берутся из записей
+	bool replaying_ = false;
+	std::unique_ptr<sim_record::Recorder> recorder_;
 	std::unique_ptr<Serializator> serializator_;
-	std::unique_ptr<postgres::Database> db_;
+	std::unique_ptr<storage::RecordsStorage> records_storage_;
+	std::unique_ptr<records::RecordsCache> records_cache_;
+	// Объявлен после records_storage_: при разрушении сначала дописывает очередь, пока хранилище ещё живо
+	std::unique_ptr<retirement::RetirementWriter> retirement_writer_;
+	std::atomic<uint64_t> state_version_{ 0 };
+	leaderboard::RankTree hall_of_fame_;
+	// В живых таблицах play_time_ms хранит минус момент входа по live_clock_: порядок тот же,
+	// что по времени игры, но ключ не меняется каждый тик - дерево трогают только новые очки
+	std::unordered_map<std::string, leaderboard::RankTree> live_boards_;
+	std::unordered_map<int, leaderboard::Entry> live_entries_;
+	std::chrono::milliseconds live_clock_{ 0 };
+	tick_profile::TickProfiler profiler_;
 
+	std::shared_ptr<Player> AddJoinedPlayer(const std::string& map_id, const std::string& name, model::DogCoord coords);
+	void ReplayWal(uint64_t checkpoint);
+	void Apply(const wal::JoinRecord& record);
+	void Apply(const wal::ActionRecord& record);
+	void Apply(const wal::TickRecord& record);
+	void Apply(const wal::RetireRecord& record);
 	void DeleteEmptySessions();
 	void DeleteIdlePlayers(std::chrono::milliseconds time, std::vector<int>& ids);
 	void AddRetiredPlayersToDB(std::vector<std::shared_ptr<Player>>& ids);
 	void UpdateAllPlayersPlayTime(std::chrono::milliseconds time);
+	void LoadHallOfFame(size_t records_cache_size);
+	void UpdateLiveEntry(const std::shared_ptr<Player>& player);
+	void EraseLiveEntry(const std::shared_ptr<Player>& player);
 };
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include <boost/crc.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace codec
+{
+    // Простые значения пишутся как есть, в порядке байт машины. Строка - размер Size (по умолчанию uint32) и байты
+    template <typename T>
+    void Put(std::string& out, T value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    // Строка должна помещаться в Size
+    template <typename Size = uint32_t>
+    void PutString(std::string& out, std::string_view value)
+    {
+        Put<Size>(out, static_cast<Size>(value.size()));
+        out += value;
+    }
+
+    // Читают значение из начала in и сдвигают его. false, если данных не хватает
+    template <typename T>
+    bool Get(std::string_view& in, T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (in.size() < sizeof(value))
+            return false;
+        std::memcpy(&value, in.data(), sizeof(value));
+        in.remove_prefix(sizeof(value));
+        return true;
+    }
+
+    // int хранится как int32
+    inline bool GetInt(std::string_view& in, int& value)
+    {
+        int32_t v = 0;
+        if (!Get(in, v))
+            return false;
+        value = v;
+        return true;
+    }
+
+    template <typename Size = uint32_t>
+    bool GetString(std::string_view& in, std::string& value)
+    {
+        Size size = 0;
+        if (!Get(in, size) || in.size() < size)
+            return false;
+        value.assign(in.data(), size);
+        in.remove_prefix(size);
+        return true;
+    }
+
+    // CRC32 строк журналов и сохранений
+    inline uint32_t Checksum(std::string_view data)
+    {
+        boost::crc_32_type crc;
+        crc.process_bytes(data.data(), data.size());
+        return crc.checksum();
+    }
+}
@@ -0,0 +1,202 @@
+#include "compression.h"
+
+#include <brotli/encode.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace compression
+{
+    namespace
+    {
+        constexpr int GZIP_WINDOW_BITS = MAX_WBITS + 16; // +16 - заголовок gzip вместо zlib
+        constexpr int GZIP_MEM_LEVEL = 8;
+        constexpr int BROTLI_FAST_QUALITY = 4;
+
+        std::string_view Trim(std::string_view str)
+        {
+            while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+                str.remove_prefix(1);
+            while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+                str.remove_suffix(1);
+            return str;
+        }
+
+        bool IEquals(std::string_view lhs, std::string_view rhs)
+        {
+            return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](char l, char r) {
+                return std::tolower(static_cast<unsigned char>(l)) == std::tolower(static_cast<unsigned char>(r));
+                });
+        }
+
+        // q-значение из параметров токена Accept-Encoding ("gzip;q=0.5"), по умолчанию 1
+        double ParseQuality(std::string_view params)
+        {
+            while (!params.empty())
+            {
+                size_t semicolon = params.find(';');
+                std::string_view param = Trim(params.substr(0, semicolon));
+                params = semicolon == std::string_view::npos ? ""sv : params.substr(semicolon + 1);
+
+                if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=')
+                {
+                    std::string value(param.substr(2));
+                    try
+                    {
+                        return std::stod(value);
+                    }
+                    catch (...)
+                    {
+                        return 0.0;
+                    }
+                }
+            }
+            return 1.0;
+        }
+
+        // Поток zlib создаётся один раз на поток и сбрасывается deflateReset перед каждым сжатием
+        class GzipContext
+        {
+        public:
+            explicit GzipContext(int level)
+            {
+                if (deflateInit2(&stream_, level, Z_DEFLATED, GZIP_WINDOW_BITS, GZIP_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+                    throw std::runtime_error("Can't initialize zlib stream");
+            }
+
+            GzipContext(const GzipContext&) = delete;
+            GzipContext& operator=(const GzipContext&) = delete;
+
+            ~GzipContext()
+            {
+                deflateEnd(&stream_);
+            }
+
+            std::string Compress(std::string_view data)
+            {
+                deflateReset(&stream_);
+
+                std::string result;
+                result.resize(deflateBound(&stream_, static_cast<uLong>(data.size())));
+
+                stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+                stream_.avail_in = static_cast<uInt>(data.size());
+                stream_.next_out = reinterpret_cast<Bytef*>(result.data());
+                stream_.avail_out = static_cast<uInt>(result.size());
+
+                if (deflate(&stream_, Z_FINISH) != Z_STREAM_END)
+                    throw std::runtime_error("gzip compression failed");
+
+                result.resize(stream_.total_out);
+                return result;
+            }
+
+        private:
+            z_stream stream_{};
+        };
+
+        std::string CompressBrotli(std::string_view data, int quality)
+        {
+            size_t size = BrotliEncoderMaxCompressedSize(data.size());
+            std::string result(size, '\0');
+
+            if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                data.size(), reinterpret_cast<const uint8_t*>(data.data()),
+                &size, reinterpret_cast<uint8_t*>(result.data())))
+                throw std::runtime_error("brotli compression failed");
+
+            result.resize(size);
+            return result;
+        }
+    }
+
+    Encoding ChooseEncoding(std::string_view accept_encoding)
+    {
+        double gzip_q = 0.0;
+        double br_q = 0.0;
+        double any_q = -1.0;
+        bool has_gzip = false;
+        bool has_br = false;
+
+        while (!accept_encoding.empty())
+        {
+            size_t comma = accept_encoding.find(',');
+            std::string_view token = accept_encoding.substr(0, comma);
+            accept_encoding = comma == std::string_view::npos ? ""sv : accept_encoding.substr(comma + 1);
+
+            size_t semicolon = token.find(';');
+            std::string_view name = Trim(token.substr(0, semicolon));
+            double q = semicolon == std::string_view::npos ? 1.0 : ParseQuality(token.substr(semicolon + 1));
+
+            if (IEquals(name, "gzip"sv))
+            {
+                gzip_q = q;
+                has_gzip = true;
+            }
+            else if (IEquals(name, "br"sv))
+            {
+                br_q = q;
+                has_br = true;
+            }
+            else if (name == "*"sv)
+                any_q = q;
+        }
+
+        if (!has_gzip && any_q > 0)
+            gzip_q = any_q;
+        if (!has_br && any_q > 0)
+            br_q = any_q;
+
+        if (br_q > 0 && br_q >= gzip_q)
+            return Encoding::BROTLI;
+        if (gzip_q > 0)
+            return Encoding::GZIP;
+        return Encoding::IDENTITY;
+    }
+
+    std::string_view GetEncodingName(Encoding encoding)
+    {
+        switch (encoding)
+        {
+        case Encoding::GZIP:
+            return "gzip"sv;
+        case Encoding::BROTLI:
+            return "br"sv;
+        default:
+            return "identity"sv;
+        }
+    }
+
+    bool IsCompressibleContentType(std::string_view content_type)
+    {
+        content_type = content_type.substr(0, content_type.find(';'));
+        return content_type.substr(0, 5) == "text/"sv
+            || content_type == "application/json"sv
+            || content_type == "application/xml"sv
+            || content_type == "application/javascript"sv
+            || content_type == "image/svg+xml"sv;
+    }
+
+    std::string Compress(std::string_view data, Encoding encoding, Level level)
+    {
+        switch (encoding)
+        {
+        case Encoding::GZIP:
+        {
+            if (level == Level::BEST)
+            {
+                thread_local GzipContext best_context(Z_BEST_COMPRESSION);
+                return best_context.Compress(data);
+            }
+            thread_local GzipContext fast_context(Z_BEST_SPEED);
+            return fast_context.Compress(data);
+        }
+        case Encoding::BROTLI:
+            return CompressBrotli(data, level == Level::BEST ? BROTLI_MAX_QUALITY : BROTLI_FAST_QUALITY);
+        default:
+            return std::string(data);
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/beast/http.hpp>
+
+#include <string>
+#include <string_view>
+
+namespace compression
+{
+    namespace http = boost::beast::http;
+    using namespace std::literals;
+
+    enum class Encoding
+    {
+        IDENTITY,
+        GZIP,
+        BROTLI
+    };
+
+    // FAST - для динамических ответов на IO-потоках, BEST - для однократного сжатия статики
+    enum class Level
+    {
+        FAST,
+        BEST
+    };
+
+    // Динамические ответы меньше одного сегмента TCP сжимать нет смысла
+    constexpr size_t DYNAMIC_COMPRESSION_THRESHOLD = 1400;
+
+    // Выбирает лучшую поддерживаемую кодировку из заголовка Accept-Encoding с учётом q-значений
+    Encoding ChooseEncoding(std::string_view accept_encoding);
+    std::string_view GetEncodingName(Encoding encoding);
+    bool IsCompressibleContentType(std::string_view content_type);
+
+    // Контекст zlib переиспользуется в пределах потока, поэтому функция потокобезопасна
+    std::string Compress(std::string_view data, Encoding encoding, Level level);
+
+    // Сжимает тело уже готового ответа, если это имеет смысл. Ответы с Content-Encoding не трогает
+    template <typename Fields>
+    void CompressResponse(http::response<http::string_body, Fields>& response, Encoding encoding)
+    {
+        if (encoding == Encoding::IDENTITY
+            || response.body().size() < DYNAMIC_COMPRESSION_THRESHOLD
+            || response.find(http::field::content_encoding) != response.end()
+            || !IsCompressibleContentType(response[http::field::content_type]))
+            return;
+
+        std::string compressed = Compress(response.body(), encoding, Level::FAST);
+        if (compressed.size() >= response.body().size())
+            return;
+
+        response.body() = std::move(compressed);
+        response.set(http::field::content_encoding, GetEncodingName(encoding));
+        response.set(http::field::vary, "Accept-Encoding"sv);
+        response.content_length(response.body().size());
+    }
+}
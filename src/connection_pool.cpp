@@ -0,0 +1,126 @@
+#include "connection_pool.h"
+
+#include <algorithm>
+#include <pqxx/nontransaction>
+
+ConnectionPool::ConnectionPool(Options options, ConnectionFactory connection_factory)
+    : options_{ options }
+    , connection_factory_{ std::move(connection_factory) } {
+    options_.max_size = std::max<size_t>({ 1, options_.max_size, options_.min_size });
+    //    ,   ,  
+    for (size_t i = 0; i < options_.min_size; ++i) {
+        idle_.push_back({ CreateConnection(), Clock::now() });
+        ++size_;
+    }
+}
+
+ConnectionPool::ConnectionWrapper ConnectionPool::GetConnection() {
+    const auto start = Clock::now();
+    const auto deadline = start + options_.acquire_timeout;
+    std::vector<ConnectionPtr> expired;
+
+    std::unique_lock lock{ mutex_ };
+    TakeExpired(start, expired);
+
+    ++stats_.waiting;
+    bool available = cond_var_.wait_until(lock, deadline, [this] {
+        return !idle_.empty() || size_ < options_.max_size;
+        });
+    --stats_.waiting;
+    if (!available) {
+        ++stats_.timeouts;
+        throw AcquireTimeout{};
+    }
+
+    //      ,        
+    ConnectionPtr conn;
+    bool check = false;
+    if (!idle_.empty()) {
+        conn = std::move(idle_.back().conn);
+        check = start - idle_.back().since >= options_.validate_after;
+        idle_.pop_back();
+    }
+    else {
+        ++size_;
+        ++stats_.created;
+    }
+
+    const auto wait_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    ++stats_.acquired;
+    stats_.total_wait_us += wait_us;
+    stats_.max_wait_us = std::max(stats_.max_wait_us, wait_us);
+    ++stats_.in_use;
+    stats_.peak_in_use = std::max(stats_.peak_in_use, stats_.in_use);
+    lock.unlock();
+
+    try {
+        if (conn && check && !IsAlive(*conn)) {
+            conn.reset();
+            std::lock_guard reconnect_lock{ mutex_ };
+            ++stats_.reconnects;
+        }
+        if (!conn) {
+            conn = CreateConnection();
+        }
+    }
+    catch (...) {
+        {
+            std::lock_guard failed_lock{ mutex_ };
+            --size_;
+            --stats_.in_use;
+        }
+        cond_var_.notify_one();
+        throw;
+    }
+    return { std::move(conn), *this };
+}
+
+ConnectionPool::Stats ConnectionPool::GetStats() const {
+    std::lock_guard lock{ mutex_ };
+    Stats stats = stats_;
+    stats.size = size_;
+    return stats;
+}
+
+void ConnectionPool::ReturnConnection(ConnectionPtr&& conn) {
+    std::vector<ConnectionPtr> expired;
+    {
+        std::lock_guard lock{ mutex_ };
+        --stats_.in_use;
+        //    :  GetConnection  
+        if (conn->is_open()) {
+            idle_.push_back({ std::move(conn), Clock::now() });
+        }
+        else {
+            --size_;
+            expired.push_back(std::move(conn));
+        }
+        TakeExpired(Clock::now(), expired);
+    }
+    //         
+    cond_var_.notify_one();
+}
+
+ConnectionPool::ConnectionPtr ConnectionPool::CreateConnection() {
+    return connection_factory_();
+}
+
+bool ConnectionPool::IsAlive(pqxx::connection& conn) const {
+    try {
+        pqxx::nontransaction check{ conn };
+        check.exec("SELECT 1");
+        return true;
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+void ConnectionPool::TakeExpired(Clock::time_point now, std::vector<ConnectionPtr>& expired) {
+    while (size_ > options_.min_size && !idle_.empty() && now - idle_.front().since >= options_.idle_timeout) {
+        expired.push_back(std::move(idle_.front().conn));
+        idle_.pop_front();
+        --size_;
+        ++stats_.reaped;
+    }
+}
@@ -4,12 +4,55 @@
 #include <pqxx/connection>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <vector>
 
 class ConnectionPool {
     using PoolType = ConnectionPool;
     using ConnectionPtr = std::shared_ptr<pqxx::connection>;
+    using Clock = std::chrono::steady_clock;
 
 public:
+    // ConnectionFactory       
+    using ConnectionFactory = std::function<ConnectionPtr()>;
+
+    struct Options {
+        //        
+        size_t min_size = 1;
+        //     
+        size_t max_size = 8;
+        //  GetConnection   ,    AcquireTimeout
+        std::chrono::milliseconds acquire_timeout{ 2000 };
+        //   min_size,  , 
+        std::chrono::milliseconds idle_timeout{ 60000 };
+        // ,  ,    
+        std::chrono::milliseconds validate_after{ 5000 };
+    };
+
+    struct Stats {
+        size_t size = 0;
+        size_t in_use = 0;
+        size_t peak_in_use = 0;
+        size_t waiting = 0;
+        uint64_t acquired = 0;
+        uint64_t timeouts = 0;
+        uint64_t created = 0;
+        uint64_t reconnects = 0;
+        uint64_t reaped = 0;
+        uint64_t total_wait_us = 0;
+        uint64_t max_wait_us = 0;
+    };
+
+    class AcquireTimeout : public std::runtime_error {
+    public:
+        AcquireTimeout() : std::runtime_error("Timed out waiting for a database connection") {
+        }
+    };
+
     class ConnectionWrapper {
     public:
         ConnectionWrapper(std::shared_ptr<pqxx::connection>&& conn, PoolType& pool) noexcept
@@ -43,41 +86,41 @@ public:
         PoolType* pool_;
     };
 
-    // ConnectionFactory is a functional object returning std::shared_ptr<pqxx::connection>
-    template <typename ConnectionFactory>
-    ConnectionPool(size_t capacity, ConnectionFactory&& connection_factory) {
-        pool_.reserve(capacity);
-        for (size_t i = 0; i < capacity; ++i) {
-            pool_.emplace_back(connection_factory());
-        }
+    ConnectionPool(Options options, ConnectionFactory connection_factory);
+    //   ,  
+    ConnectionPool(size_t capacity, ConnectionFactory connection_factory)
+        : ConnectionPool(Options{ .min_size = capacity, .max_size = capacity }, std::move(connection_factory)) {
     }
 
-    ConnectionWrapper GetConnection() {
-        std::unique_lock lock{ mutex_ };
-        //     ,  cond_var_      
-        //    
-        cond_var_.wait(lock, [this] {
-            return used_connections_ < pool_.size();
-            });
-        //        
+    //  ,  ( size < max_size)  AcquireTimeout   acquire_timeout.
+    // ,   , ;    
+    ConnectionWrapper GetConnection();
 
-        return { std::move(pool_[used_connections_++]), *this };
+    Stats GetStats() const;
+
+    const Options& GetOptions() const noexcept {
+        return options_;
     }
 
 private:
-    void ReturnConnection(ConnectionPtr&& conn) {
-        //     
-        {
-            std::lock_guard lock{ mutex_ };
-            assert(used_connections_ != 0);
-            pool_[--used_connections_] = std::move(conn);
-        }
-        //         
-        cond_var_.notify_one();
-    }
+    struct IdleConnection {
+        ConnectionPtr conn;
+        Clock::time_point since;
+    };
+
+    void ReturnConnection(ConnectionPtr&& conn);
+    ConnectionPtr CreateConnection();
+    bool IsAlive(pqxx::connection& conn) const;
+    //       min_size.     
+    void TakeExpired(Clock::time_point now, std::vector<ConnectionPtr>& expired);
 
-    std::mutex mutex_;
+    Options options_;
+    ConnectionFactory connection_factory_;
+    mutable std::mutex mutex_;
     std::condition_variable cond_var_;
-    std::vector<ConnectionPtr> pool_;
-    size_t used_connections_ = 0;
-};
\ No newline at end of file
+    //  :    ,   -   
+    std::deque<IdleConnection> idle_;
+    //  ,      
+    size_t size_ = 0;
+    Stats stats_;
+};
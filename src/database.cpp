@@ -3,10 +3,13 @@
 #include <pqxx/zview.hxx>
 #include <pqxx/pqxx>
 
- postgres::Database::Database(std::shared_ptr<ConnectionPool> connection_pool) : connection_pool_(connection_pool)
+postgres::Database::Database(std::shared_ptr<ConnectionPool> connection_pool) : connection_pool_(connection_pool)
 {
-    auto conn = connection_pool_->GetConnection();
-    pqxx::work w{ *conn };
+}
+
+void postgres::Database::InitSchema(pqxx::connection& conn)
+{
+    pqxx::work w{ conn };
 
     w.exec(R"(
                 CREATE TABLE IF NOT EXISTS retired_players( 
@@ -15,48 +18,96 @@
                 score integer NOT NULL,
                 play_time_ms integer NOT NULL)
             )"_zv);
-    w.exec("CREATE INDEX IF NOT EXISTS score_play_time_name_idx ON retired_players (score DESC, play_time_ms ASC, name ASC); "_zv);
+    // Имена сравниваются побайтово, как в records::RecordsCache, id делает порядок строгим для постраничной выборки по ключу
+    w.exec(R"(CREATE INDEX IF NOT EXISTS retired_players_rank_idx ON retired_players (score DESC, play_time_ms ASC, name COLLATE "C" ASC, id ASC);)"_zv);
+    w.exec("DROP INDEX IF EXISTS score_play_time_name_idx;"_zv);
     w.commit();
 }
 
-void postgres::Database::AddRetiredPlayersToDB(std::vector<std::shared_ptr<Player>>& plrs)
+void postgres::Database::PrepareStatements(pqxx::connection& conn)
 {
+    conn.prepare(Statements::INSERT_RETIRED_PLAYER,
+        "INSERT INTO retired_players (id, name, score, play_time_ms) VALUES ($1, $2, $3, $4);"_zv);
+    conn.prepare(Statements::SELECT_RETIRED_PLAYERS,
+        R"(SELECT id::text, name, score, play_time_ms FROM retired_players
+           ORDER BY score DESC, play_time_ms ASC, name COLLATE "C" ASC, id ASC OFFSET $1 LIMIT $2;)"_zv);
+    conn.prepare(Statements::SELECT_RETIRED_PLAYERS_AFTER,
+        R"(SELECT id::text, name, score, play_time_ms FROM retired_players
+           WHERE score <= $1 AND (score < $1 OR play_time_ms > $2
+               OR (play_time_ms = $2 AND (name COLLATE "C" > $3 OR (name COLLATE "C" = $3 AND id > $4::uuid))))
+           ORDER BY score DESC, play_time_ms ASC, name COLLATE "C" ASC, id ASC LIMIT $5;)"_zv);
+}
+
+void postgres::Database::AddRetiredPlayersToDB(const std::vector<RetiredPlayer>& plrs, InsertMethod method)
+{
+    if (plrs.empty())
+        return;
+    if (method == InsertMethod::AUTO)
+        method = plrs.size() >= COPY_THRESHOLD ? InsertMethod::COPY : InsertMethod::PREPARED;
+
     auto conn = connection_pool_->GetConnection();
     pqxx::work w{ *conn };
-    std::string query = "INSERT INTO retired_players (id, name, score, play_time_ms) VALUES ";
-    for (const auto& plr : plrs)
+    if (method == InsertMethod::COPY)
     {
-        std::string uuid = util::detail::UUIDToString(util::detail::NewUUID());
-        double play_time = static_cast<double>(plr->GetPlayTime().count());
-        query.append("('" + uuid + "'");
-        query.append(", '" + w.esc(plr->GetName()) + "'");
-        query.append(", " + std::to_string(plr->GetDog()->GetCurrentScore()));
-        if (plr == plrs.back())
+        auto stream = pqxx::stream_to::table(w, { "retired_players"_zv }, { "id"_zv, "name"_zv, "score"_zv, "play_time_ms"_zv });
+        for (const auto& plr : plrs)
         {
-            query.append(", " + std::to_string(play_time) + ");");
+            stream.write_values(plr.id.empty() ? util::detail::UUIDToString(util::detail::NewUUID()) : plr.id, plr.name, plr.score, plr.play_time_ms);
         }
-        else
+        stream.complete();
+    }
+    else
+    {
+        for (const auto& plr : plrs)
         {
-            query.append(", " + std::to_string(play_time) + "), ");
+            w.exec_prepared(Statements::INSERT_RETIRED_PLAYER,
+                plr.id.empty() ? util::detail::UUIDToString(util::detail::NewUUID()) : plr.id, plr.name, plr.score, plr.play_time_ms);
         }
     }
-    w.exec(query);
     w.commit();
 }
 
-std::vector<std::tuple<std::string, int, int>> postgres::Database::GetRetiredPlayersFromDB(RecordsParams& p)
+std::vector<postgres::RetiredPlayer> postgres::Database::GetRetiredPlayersPage(const RetiredPlayer* after, size_t offset, size_t limit)
 {
     auto conn = connection_pool_->GetConnection();
     pqxx::read_transaction r(*conn);
-    std::string query = "SELECT name, score, play_time_ms FROM retired_players ORDER BY score DESC, play_time_ms ASC, name ASC OFFSET " 
-        + r.quote(p.start) + " LIMIT " + r.quote(p.maxItems) + ";";
+    auto rows = after
+        ? r.exec_prepared(Statements::SELECT_RETIRED_PLAYERS_AFTER, after->score, after->play_time_ms, after->name, after->id, limit)
+        : r.exec_prepared(Statements::SELECT_RETIRED_PLAYERS, offset, limit);
 
-    std::vector<std::tuple<std::string, int, int>> retired_players_info;
+    std::vector<RetiredPlayer> retired_players;
+    retired_players.reserve(rows.size());
 
-    for (const auto row : r.query<std::string, int, int>(query))
+    for (const auto& row : rows)
     {
-        retired_players_info.push_back(row);
+        retired_players.push_back({ row[0].as<std::string>(), row[1].as<std::string>(), row[2].as<int>(), row[3].as<int64_t>() });
     }
 
-    return retired_players_info;
+    return retired_players;
+}
+
+void postgres::Database::AddRetiredPlayers(const std::vector<RetiredPlayer>& plrs)
+{
+    AddRetiredPlayersToDB(plrs);
+}
+
+boost::json::object postgres::Database::GetStats() const
+{
+    const auto pool = connection_pool_->GetStats();
+    return boost::json::object{
+        {"backend", "postgres"},
+        {"pool", boost::json::object{
+            {"size", pool.size},
+            {"inUse", pool.in_use},
+            {"peakInUse", pool.peak_in_use},
+            {"waiting", pool.waiting},
+            {"acquired", pool.acquired},
+            {"timeouts", pool.timeouts},
+            {"created", pool.created},
+            {"reconnects", pool.reconnects},
+            {"reaped", pool.reaped},
+            {"avgWaitUs", pool.acquired == 0 ? 0.0 : static_cast<double>(pool.total_wait_us) / static_cast<double>(pool.acquired)},
+            {"maxWaitUs", pool.max_wait_us}
+        }}
+    };
 }
\ No newline at end of file
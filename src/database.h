@@ -5,6 +5,7 @@
 #include <tuple>
 
 #include "connection_pool.h"
+#include "records_storage.h"
 #include "tagged_uuid.h"
 #include "player.h"
 
@@ -12,14 +13,47 @@ using namespace std::literals;
 using pqxx::operator"" _zv;
 
 namespace postgres {
-    class Database {
+    using RetiredPlayer = storage::RetiredPlayer;
+
+    enum class InsertMethod {
+        // Небольшие пачки - подготовленным INSERT на каждую строку в одной транзакции
+        PREPARED,
+        // Большие пачки - через COPY (pqxx::stream_to)
+        COPY,
+        // Выбирается по размеру пачки
+        AUTO
+    };
+
+    // Пачки от этого размера пишутся через COPY
+    constexpr size_t COPY_THRESHOLD = 32;
+
+    // Имена подготовленных запросов
+    struct Statements {
+        Statements() = delete;
+        constexpr static pqxx::zview INSERT_RETIRED_PLAYER = "insert_retired_player"_zv;
+        constexpr static pqxx::zview SELECT_RETIRED_PLAYERS = "select_retired_players"_zv;
+        constexpr static pqxx::zview SELECT_RETIRED_PLAYERS_AFTER = "select_retired_players_after"_zv;
+    };
+
+    class Database : public storage::RecordsStorage {
     public:
 
         explicit Database(std::shared_ptr<ConnectionPool> connection_pool);
-        void AddRetiredPlayersToDB(std::vector<std::shared_ptr<Player>>& plrs);
-        std::vector<std::tuple<std::string, int, int>> GetRetiredPlayersFromDB(RecordsParams& p);
+
+        // Создаёт таблицы и индексы. Вызывается один раз до создания пула: prepare требует существующих таблиц
+        static void InitSchema(pqxx::connection& conn);
+        // Регистрирует подготовленные запросы на новом соединении. Вызывается из фабрики ConnectionPool
+        static void PrepareStatements(pqxx::connection& conn);
+
+        void AddRetiredPlayersToDB(const std::vector<RetiredPlayer>& plrs, InsertMethod method = InsertMethod::AUTO);
+        // Страница зала славы: строки после after (keyset по индексу retired_players_rank_idx) или со смещения offset
+        std::vector<RetiredPlayer> GetRetiredPlayersPage(const RetiredPlayer* after, size_t offset, size_t limit) override;
+
+        void AddRetiredPlayers(const std::vector<RetiredPlayer>& plrs) override;
+        // Состояние пула соединений
+        boost::json::object GetStats() const override;
 
     private:
         std::shared_ptr<ConnectionPool> connection_pool_;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace etag
+{
+    using namespace std::literals;
+
+    // FNV-1a: детерминированный между перезапусками, в отличие от std::hash
+    inline std::uint64_t Fnv1a64(std::string_view data, std::uint64_t hash = 14695981039346656037ull)
+    {
+        for (unsigned char c : data)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Сильный ETag вида "0123456789abcdef" по содержимому тела ответа
+    inline std::string MakeStrongETag(std::string_view body)
+    {
+        char buffer[19];
+        std::snprintf(buffer, sizeof(buffer), "\"%016llx\"", static_cast<unsigned long long>(Fnv1a64(body)));
+        return std::string(buffer, 18);
+    }
+
+    // Проверка заголовка If-None-Match: список ETag через запятую или "*".
+    // Для If-None-Match используется слабое сравнение (RFC 9110, 13.1.2), поэтому префикс W/ игнорируется
+    inline bool IsNoneMatchSatisfied(std::string_view if_none_match, std::string_view etag)
+    {
+        while (!if_none_match.empty())
+        {
+            size_t comma = if_none_match.find(',');
+            std::string_view candidate = if_none_match.substr(0, comma);
+            if_none_match = comma == std::string_view::npos ? ""sv : if_none_match.substr(comma + 1);
+
+            while (!candidate.empty() && (candidate.front() == ' ' || candidate.front() == '\t'))
+                candidate.remove_prefix(1);
+            while (!candidate.empty() && (candidate.back() == ' ' || candidate.back() == '\t'))
+                candidate.remove_suffix(1);
+
+            if (candidate == "*"sv)
+                return true;
+            if (candidate.substr(0, 2) == "W/"sv)
+                candidate.remove_prefix(2);
+            if (candidate == etag)
+                return true;
+        }
+        return false;
+    }
+}
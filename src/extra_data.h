@@ -7,12 +7,15 @@
 
 #include <optional>
 #include <unordered_map>
+#include <string>
 #include <string_view>
 
 struct RecordsParams
 {
     size_t start = 0;
     size_t maxItems = 100;
+    // Курсор из заголовка X-Records-Cursor предыдущей страницы. Если задан, start не учитывается
+    std::string cursor;
 };
 
 class ExtraData
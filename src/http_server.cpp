@@ -2,6 +2,7 @@
 #include "logging_request_handler.h"
 
 #include <boost/asio/dispatch.hpp>
+#include <charconv>
 #include <iostream>
 
 namespace http_server
@@ -16,4 +17,33 @@ namespace http_server
         };
         BOOST_LOG_TRIVIAL(fatal) << boost::log::add_value(data, error) << "error"sv;
     }
+
+    tcp::endpoint ParseEndpoint(std::string_view endpoint) {
+        std::string_view address;
+        std::string_view port;
+        if (endpoint.starts_with('[')) {
+            // IPv6: [адрес]:порт
+            size_t close = endpoint.find("]:"sv);
+            if (close == std::string_view::npos) {
+                throw std::invalid_argument("Invalid listen address "s + std::string(endpoint));
+            }
+            address = endpoint.substr(1, close - 1);
+            port = endpoint.substr(close + 2);
+        }
+        else {
+            size_t colon = endpoint.rfind(':');
+            if (colon == std::string_view::npos) {
+                throw std::invalid_argument("Listen address must contain a port: "s + std::string(endpoint));
+            }
+            address = endpoint.substr(0, colon);
+            port = endpoint.substr(colon + 1);
+        }
+
+        net::ip::port_type port_number = 0;
+        auto [ptr, ec] = std::from_chars(port.data(), port.data() + port.size(), port_number);
+        if (ec != std::errc{} || ptr != port.data() + port.size()) {
+            throw std::invalid_argument("Invalid port in listen address "s + std::string(endpoint));
+        }
+        return { net::ip::make_address(address), port_number };
+    }
 }  // namespace http_server
@@ -4,10 +4,26 @@
 #define BOOST_BEAST_USE_STD_STRING_VIEW
 
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ip/v6_only.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <deque>
 #include <iostream>
+#include <optional>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+#include "session_arena.h"
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 namespace http_server {
 
@@ -20,6 +36,49 @@ namespace http_server {
 
     void ReportError(beast::error_code ec, std::string_view what);
 
+#ifdef __linux__
+    // В Asio нет готовой опции для SO_REUSEPORT
+    using ReusePort = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+    // Ограничения одного соединения
+    struct SessionOptions {
+        std::uint32_t header_limit = 8 * 1024;
+        std::uint64_t body_limit = 1024 * 1024;
+        // Время на получение запроса после прихода его первого байта
+        std::chrono::seconds read_timeout{ 30 };
+        // Сколько keep-alive соединение может ждать следующий запрос
+        std::chrono::seconds idle_timeout{ 30 };
+        // Сколько отправка файла может ждать, пока клиент освободит буфер сокета
+        std::chrono::seconds write_timeout{ 30 };
+    };
+
+    struct ServerOptions {
+        std::vector<tcp::endpoint> endpoints;
+        int backlog = net::socket_base::max_listen_connections;
+        // 0 - без ограничения. Лишние соединения закрываются сразу после accept
+        std::size_t max_connections = 0;
+        bool tcp_nodelay = true;
+        bool tcp_keepalive = false;
+        bool reuse_port = false;
+        SessionOptions session;
+    };
+
+    // Разбирает адрес вида 0.0.0.0:8080 или [::]:8080
+    tcp::endpoint ParseEndpoint(std::string_view endpoint);
+
+    namespace detail {
+        template <typename T>
+        struct IsBasicString : std::false_type {};
+
+        template <typename Char, typename Traits, typename Allocator>
+        struct IsBasicString<std::basic_string<Char, Traits, Allocator>> : std::true_type {};
+
+        // Тело ответа лежит в одной строке и может быть отправлено как есть
+        template <typename Body>
+        constexpr bool IsStringBody = IsBasicString<typename Body::value_type>::value;
+    }
+
     class SessionBase {
     public:
         // Запрещаем копирование и присваивание объектов SessionBase и его наследников
@@ -39,69 +98,319 @@ namespace http_server {
         }
 
     protected:
-        using HttpRequest = http::request<http::string_body>;
-
-        explicit SessionBase(tcp::socket&& socket)
-            : stream_(std::move(socket)) {
+        // Заголовки и тело запроса размещаются в памяти соединения
+        using RequestAllocator = ArenaAllocator<char>;
+        using HttpRequest = http::request<http::basic_string_body<char, std::char_traits<char>, RequestAllocator>,
+            http::basic_fields<RequestAllocator>>;
+        // Номер запроса внутри соединения, ответы отправляются строго в порядке номеров
+        using RequestId = std::uint64_t;
+
+        // Сколько запросов клиент может прислать вперёд, не дожидаясь ответов
+        static constexpr std::size_t max_pipeline_depth = 16;
+        // Сколько готовых ответов склеивается в одну запись
+        static constexpr std::size_t max_write_batch = 32;
+
+        SessionBase(tcp::socket&& socket, const SessionOptions& options)
+            : arena_(std::make_shared<SessionArena>())
+            , options_(options)
+            , stream_(std::move(socket)) {
+            auto& stats = GetSessionStats();
+            stats.sessions_opened.fetch_add(1, std::memory_order_relaxed);
+            stats.sessions_active.fetch_add(1, std::memory_order_relaxed);
         }
 
+        // Может вызываться из любого потока: ответ переносится в память соединения,
+        // а постановка в очередь выполняется на executor сессии
         template <typename Body, typename Fields>
-        void Write(http::response<Body, Fields>&& response) {
-            // Запись выполняется асинхронно, поэтому response перемещаем в область кучи
-            auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
-
-            auto self = GetSharedThis();
-            http::async_write(stream_, *safe_response,
-                [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
-                    self->OnWrite(safe_response->need_eof(), ec, bytes_written);
+        void Write(RequestId id, http::response<Body, Fields>&& response) {
+            using Response = http::response<Body, Fields>;
+            Outgoing outgoing;
+
+            if constexpr (detail::IsStringBody<Body>) {
+                if (!response.has_content_length() && !response.chunked())
+                    response.prepare_payload();
+                if (!response.chunked()) {
+                    // Заголовок сериализуется сразу, тело отправляется из самого ответа без копирования
+                    std::ostringstream header;
+                    header << response.base();
+                    outgoing.header = header.str();
+                }
+            }
+            outgoing.close = response.need_eof();
+
+#ifdef __linux__
+            if constexpr (std::is_same_v<Body, http::file_body>) {
+                outgoing.response = std::allocate_shared<FileWriteState>(GetAllocator(), std::move(response));
+                outgoing.write_alone = &SessionBase::SendFileResponse;
+            }
+            else
+#endif
+            {
+                auto safe_response = std::allocate_shared<Response>(GetAllocator(), std::move(response));
+                if constexpr (detail::IsStringBody<Body>) {
+                    if (!outgoing.header.empty())
+                        outgoing.body = net::buffer(safe_response->body());
+                }
+                if (outgoing.header.empty())
+                    outgoing.write_alone = &SessionBase::WriteResponse<Response>;
+                outgoing.response = std::move(safe_response);
+            }
+
+            net::dispatch(stream_.get_executor(),
+                [self = GetSharedThis(), id, outgoing = std::move(outgoing)]() mutable {
+                    self->Enqueue(id, std::move(outgoing));
                 });
         }
 
-        ~SessionBase() = default;
+        ~SessionBase() {
+            GetSessionStats().sessions_active.fetch_sub(1, std::memory_order_relaxed);
+        }
     private:
+        // Ответ, ожидающий отправки
+        struct Outgoing
+        {
+            // Владеет объектом ответа в памяти соединения
+            std::shared_ptr<void> response;
+            // Для строковых ответов - готовый заголовок и тело, они склеиваются с соседними ответами
+            std::string header;
+            net::const_buffer body;
+            bool close = false;
+            // Ответ, который нельзя склеить (файл), записывается отдельной операцией
+            void (SessionBase::*write_alone)(Outgoing&) = nullptr;
+        };
+
+#ifdef __linux__
+        // Отправляется часть файла от его текущей позиции длиной Content-Length, без заголовка - до конца
+        struct FileWriteState
+        {
+            explicit FileWriteState(http::response<http::file_body>&& response_)
+                : response(std::move(response_)) {
+                beast::error_code ec;
+                first = response.body().file().pos(ec);
+                end = response.body().size();
+                auto content_length = response[http::field::content_length];
+                std::uint64_t length = 0;
+                if (!ec && !content_length.empty()
+                    && std::from_chars(content_length.data(), content_length.data() + content_length.size(), length).ec == std::errc{})
+                    end = std::min(end, first + length);
+            }
+
+            http::response<http::file_body> response;
+            http::response_serializer<http::file_body> serializer{ response };
+            std::uint64_t first = 0;
+            std::uint64_t end = 0;
+        };
+#endif
+
+        using RequestParser = http::request_parser<HttpRequest::body_type, RequestAllocator>;
+
+        std::shared_ptr<SessionArena> arena_;
+        SessionOptions options_;
         // tcp_stream содержит внутри себя сокет и добавляет поддержку таймаутов
         beast::tcp_stream stream_;
+#ifdef __linux__
+        // sendfile пишет в сокет мимо tcp_stream, поэтому ожидание сокета ограничивается отдельно
+        net::steady_timer send_timer_{ stream_.get_executor() };
+#endif
         beast::flat_buffer buffer_;
-        HttpRequest request_;
+        // Парсер создаётся заново для каждого запроса - у него одноразовые лимиты и состояние
+        std::optional<RequestParser> parser_;
+
+        // Всё состояние ниже меняется только на executor сессии (strand)
+        RequestId next_request_id_ = 0;
+        RequestId next_response_id_ = 0;
+        // ready_[i] - ответ на запрос next_response_id_ + i, пустой, если обработчик ещё не ответил
+        std::deque<std::optional<Outgoing>> ready_;
+        // Ответы, которые сейчас записываются в сокет
+        std::vector<Outgoing> writing_batch_;
+        std::vector<net::const_buffer> write_buffers_;
+        bool reading_ = false;
+        bool writing_ = false;
+        // Клиент закрыл соединение или попросил закрыть его после ответа - больше не читаем
+        bool read_closed_ = false;
+
+        RequestAllocator GetAllocator() const {
+            return RequestAllocator(arena_);
+        }
+
+        std::size_t GetRequestsInFlight() const {
+            return static_cast<std::size_t>(next_request_id_ - next_response_id_);
+        }
 
         void Read()
         {
-            using namespace std::literals;
+            reading_ = true;
+            if (buffer_.size() != 0)
+                return ReadRequest();
+
+            // Начала следующего запроса ждём не дольше idle_timeout
+            constexpr std::size_t first_read_size = 4096;
+            stream_.expires_after(options_.idle_timeout);
+            stream_.async_read_some(buffer_.prepare(first_read_size),
+                beast::bind_front_handler(&SessionBase::OnIdleRead, GetSharedThis()));
+        }
+
+        void OnIdleRead(beast::error_code ec, std::size_t bytes_read)
+        {
+            if (ec == net::error::eof)
+                ec = http::error::end_of_stream;
+            if (ec)
+                return OnRead(ec, 0);
+            buffer_.commit(bytes_read);
+            ReadRequest();
+        }
+
+        void ReadRequest()
+        {
             // Очищаем запрос от прежнего значения (метод Read может быть вызван несколько раз)
-            request_ = {};
-            stream_.expires_after(30s);
-            // Считываем request_ из stream_, используя buffer_ для хранения считанных данных
-            http::async_read(stream_, buffer_, request_,
+            parser_.emplace(std::piecewise_construct, std::make_tuple(GetAllocator()), std::make_tuple(GetAllocator()));
+            parser_->header_limit(options_.header_limit);
+            parser_->body_limit(options_.body_limit);
+            stream_.expires_after(options_.read_timeout);
+            // Считываем запрос из stream_, используя buffer_ для хранения считанных данных
+            http::async_read(stream_, buffer_, *parser_,
                 // По окончании операции будет вызван метод OnRead
                 beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
         }
 
+        // Читаем следующий запрос, не дожидаясь ответов на предыдущие, пока не достигнут предел конвейера
+        void ReadAhead()
+        {
+            if (!reading_ && !read_closed_ && GetRequestsInFlight() < max_pipeline_depth)
+                Read();
+        }
+
         void OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read)
         {
             using namespace std::literals;
+            reading_ = false;
             if (ec == http::error::end_of_stream) {
-                // Нормальная ситуация - клиент закрыл соединение
-                return Close();
+                // Нормальная ситуация - клиент закрыл соединение. Закрываем после отправки всех ответов
+                read_closed_ = true;
+                if (GetRequestsInFlight() == 0 && !writing_)
+                    Close();
+                return;
+            }
+            if (ec == http::error::header_limit || ec == http::error::body_limit) {
+                // Запрос дальше не читаем: отвечаем ошибкой и закрываем соединение после ответа
+                read_closed_ = true;
+                GetSessionStats().requests_too_large.fetch_add(1, std::memory_order_relaxed);
+                return Write(next_request_id_++, MakeTooLargeResponse(ec == http::error::header_limit));
+            }
+            if (ec == net::error::operation_aborted && read_closed_) {
+                // Сокет закрыт по таймауту отправки файла, он уже учтён
+                return;
+            }
+            if (ec == beast::error::timeout) {
+                // tcp_stream уже закрыл сокет, ответы на принятые запросы отправить не получится
+                read_closed_ = true;
+                GetSessionStats().timeouts.fetch_add(1, std::memory_order_relaxed);
+                return;
             }
             if (ec) {
+                read_closed_ = true;
                 return http_server::ReportError(ec, "read"sv);
             }
-            HandleRequest(std::move(request_));
+            GetSessionStats().requests.fetch_add(1, std::memory_order_relaxed);
+            HttpRequest request = parser_->release();
+            parser_.reset();
+            if (!request.keep_alive())
+                read_closed_ = true;
+
+            RequestId id = next_request_id_++;
+            HandleRequest(id, std::move(request));
+            ReadAhead();
+        }
+
+        http::response<http::string_body> MakeTooLargeResponse(bool is_header) const
+        {
+            http::response<http::string_body> response(
+                is_header ? http::status::request_header_fields_too_large : http::status::payload_too_large, 11);
+            response.set(http::field::content_type, "text/plain"sv);
+            response.body() = is_header ? "Request header is too large"sv : "Request body is too large"sv;
+            response.prepare_payload();
+            response.keep_alive(false);
+            return response;
+        }
+
+        void Enqueue(RequestId id, Outgoing&& outgoing)
+        {
+            std::size_t index = static_cast<std::size_t>(id - next_response_id_);
+            if (ready_.size() <= index)
+                ready_.resize(index + 1);
+            ready_[index] = std::move(outgoing);
+            DoWrite();
+        }
+
+        // Отправляет готовые ответы с начала очереди. Подряд идущие строковые ответы
+        // уходят одной операцией записи с набором буферов
+        void DoWrite()
+        {
+            if (writing_ || ready_.empty() || !ready_.front())
+                return;
+
+            writing_ = true;
+            if (ready_.front()->write_alone) {
+                writing_batch_.push_back(std::move(*ready_.front()));
+                ready_.pop_front();
+                ++next_response_id_;
+                auto& outgoing = writing_batch_.back();
+                return (this->*outgoing.write_alone)(outgoing);
+            }
+
+            bool close = false;
+            while (!close && !ready_.empty() && ready_.front() && !ready_.front()->write_alone
+                && writing_batch_.size() < max_write_batch) {
+                close = ready_.front()->close;
+                writing_batch_.push_back(std::move(*ready_.front()));
+                ready_.pop_front();
+                ++next_response_id_;
+            }
+
+            write_buffers_.clear();
+            for (const auto& outgoing : writing_batch_) {
+                write_buffers_.push_back(net::buffer(outgoing.header));
+                write_buffers_.push_back(outgoing.body);
+            }
+            net::async_write(stream_, write_buffers_,
+                [close, self = GetSharedThis()](beast::error_code ec, std::size_t bytes_written) {
+                    self->OnWrite(close, ec, bytes_written);
+                });
+        }
+
+        template <typename Response>
+        void WriteResponse(Outgoing& outgoing)
+        {
+            auto& response = *static_cast<Response*>(outgoing.response.get());
+            http::async_write(stream_, response,
+                [close = outgoing.close, self = GetSharedThis()](beast::error_code ec, std::size_t bytes_written) {
+                    self->OnWrite(close, ec, bytes_written);
+                });
         }
 
         void OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written)
         {
+            // Блоки ответов возвращаются в пул арены и достанутся следующим ответам
+            writing_batch_.clear();
+            writing_ = false;
+
             if (ec) {
+                read_closed_ = true;
                 return ReportError(ec, "write"sv);
             }
 
             if (close) {
                 // Семантика ответа требует закрыть соединение
+                read_closed_ = true;
                 return Close();
             }
 
-            // Считываем следующий запрос
-            Read();
+            if (read_closed_ && GetRequestsInFlight() == 0)
+                return Close();
+
+            DoWrite();
+            // Освободилось место в конвейере - считываем следующий запрос
+            ReadAhead();
         }
 
         void Close() {
@@ -114,8 +423,73 @@ namespace http_server {
             }
         }
 
+#ifdef __linux__
+        // Файл отдаётся без копирования в user space: после заголовка тело
+        // передаётся ядром из файла прямо в сокет
+        void SendFileResponse(Outgoing& outgoing)
+        {
+            auto& state = *static_cast<FileWriteState*>(outgoing.response.get());
+            http::async_write_header(stream_, state.serializer,
+                [&state, self = GetSharedThis()](beast::error_code ec, std::size_t bytes_written) {
+                    if (ec) {
+                        return self->OnWrite(state.response.need_eof(), ec, bytes_written);
+                    }
+                    self->SendFile(state, state.first);
+                });
+        }
+
+        void SendFile(FileWriteState& state, std::uint64_t offset)
+        {
+            auto& socket = stream_.socket();
+            auto& response = state.response;
+            int file_fd = response.body().file().native_handle();
+
+            beast::error_code ec;
+            socket.native_non_blocking(true, ec);
+            while (!ec && offset < state.end) {
+                off_t file_offset = static_cast<off_t>(offset);
+                ssize_t sent = ::sendfile(socket.native_handle(), file_fd, &file_offset, state.end - offset);
+                if (sent > 0) {
+                    offset += sent;
+                }
+                else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    // Буфер сокета заполнен - продолжим, когда он станет доступен для записи.
+                    // Клиент, который не читает дольше write_timeout, отключается как при таймауте tcp_stream
+                    send_timer_.expires_after(options_.write_timeout);
+                    send_timer_.async_wait([self = GetSharedThis()](beast::error_code ec) {
+                        // Обработчик мог попасть в очередь до отмены таймера
+                        if (!ec && self->send_timer_.expiry() <= net::steady_timer::clock_type::now()) {
+                            GetSessionStats().timeouts.fetch_add(1, std::memory_order_relaxed);
+                            self->read_closed_ = true;
+                            self->stream_.close();
+                        }
+                    });
+                    return socket.async_wait(tcp::socket::wait_write,
+                        [self = GetSharedThis(), &state, offset](beast::error_code ec) {
+                            // Сдвиг срока отменяет таймер и отключает его обработчик, если тот уже в очереди
+                            self->send_timer_.expires_at(net::steady_timer::time_point::max());
+                            if (ec) {
+                                if (ec == net::error::operation_aborted)
+                                    ec = beast::error::timeout;
+                                return self->OnWrite(state.response.need_eof(), ec, offset);
+                            }
+                            self->SendFile(state, offset);
+                        });
+                }
+                else if (sent < 0 && errno == EINTR) {
+                    continue;
+                }
+                else {
+                    // sent == 0 - файл укоротился во время отправки
+                    ec = sent == 0 ? beast::error_code(net::error::eof) : beast::error_code(errno, sys::system_category());
+                }
+            }
+            OnWrite(response.need_eof(), ec, offset);
+        }
+#endif
+
         // Обработку запроса делегируем подклассу
-        virtual void HandleRequest(HttpRequest&& request) = 0;
+        virtual void HandleRequest(RequestId id, HttpRequest&& request) = 0;
 
         virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
     };
@@ -124,8 +498,8 @@ namespace http_server {
     class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
     public:
         template <typename Handler>
-        Session(tcp::socket&& socket, Handler&& request_handler)
-            : SessionBase(std::move(socket))
+        Session(tcp::socket&& socket, const SessionOptions& options, Handler&& request_handler)
+            : SessionBase(std::move(socket), options)
             , request_handler_(std::forward<Handler>(request_handler)) {
         }
     private:
@@ -134,12 +508,12 @@ namespace http_server {
             return this->shared_from_this();
         }
 
-        void HandleRequest(HttpRequest&& request) override {
+        void HandleRequest(RequestId id, HttpRequest&& request) override {
             // Захватываем умный указатель на текущий объект Session в лямбде,=
             // чтобы продлить время жизни сессии до вызова лямбды.
             // Используется generic-лямбда функция, способная принять response произвольного типа
-            request_handler_(GetEndpoint(), std::move(request), [self = this->shared_from_this()](auto&& response) {
-                self->Write(std::move(response));
+            request_handler_(GetEndpoint(), std::move(request), [self = this->shared_from_this(), id](auto&& response) {
+                self->Write(id, std::move(response));
                 });
         }
     };
@@ -148,24 +522,40 @@ namespace http_server {
     class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
     public:
         template <typename Handler>
-        Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler)
+        Listener(net::io_context& ioc, const tcp::endpoint& endpoint, const ServerOptions& options, Handler&& request_handler)
             : ioc_(ioc)
             // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
             , acceptor_(net::make_strand(ioc))
-            , request_handler_(std::forward<Handler>(request_handler)) {
+            , request_handler_(std::forward<Handler>(request_handler))
+            , max_connections_(options.max_connections)
+            , tcp_nodelay_(options.tcp_nodelay)
+            , tcp_keepalive_(options.tcp_keepalive)
+            , session_options_(options.session) {
             // Открываем acceptor, используя протокол (IPv4 или IPv6), указанный в endpoint
             acceptor_.open(endpoint.protocol());
+            // [::] не должен занимать и IPv4-порт, иначе его нельзя слушать вместе с 0.0.0.0
+            if (endpoint.address().is_v6())
+                acceptor_.set_option(net::ip::v6_only(true));
 
             // После закрытия TCP-соединения сокет некоторое время может считаться занятым,
             // чтобы компьютеры могли обменяться завершающими пакетами данных.
             // Однако это может помешать повторно открыть сокет в полузакрытом состоянии.
             // Флаг reuse_address разрешает открыть сокет, когда он "наполовину закрыт"
             acceptor_.set_option(net::socket_base::reuse_address(true));
+            // reuse_port - несколько Listener (по одному на io_context) слушают один порт,
+            // ядро само распределяет между ними входящие соединения
+            if (options.reuse_port) {
+#ifdef __linux__
+                acceptor_.set_option(ReusePort(true));
+#else
+                throw std::runtime_error("SO_REUSEPORT is supported only on Linux");
+#endif
+            }
             // Привязываем acceptor к адресу и порту endpoint
             acceptor_.bind(endpoint);
             // Переводим acceptor в состояние, в котором он способен принимать новые соединения
             // Благодаря этому новые подключения будут помещаться в очередь ожидающих соединений
-            acceptor_.listen(net::socket_base::max_listen_connections);
+            acceptor_.listen(options.backlog);
         }
 
         void Run() {
@@ -176,6 +566,10 @@ namespace http_server {
         net::io_context& ioc_;
         tcp::acceptor acceptor_;
         RequestHandler request_handler_;
+        std::size_t max_connections_;
+        bool tcp_nodelay_;
+        bool tcp_keepalive_;
+        SessionOptions session_options_;
 
         void DoAccept() {
             acceptor_.async_accept(
@@ -200,6 +594,19 @@ namespace http_server {
                 return ReportError(ec, "accept"sv);
             }
 
+            auto& stats = GetSessionStats();
+            if (max_connections_ != 0
+                && stats.sessions_active.load(std::memory_order_relaxed) >= static_cast<std::int64_t>(max_connections_)) {
+                // Перегрузка: закрываем соединение, не тратя на него память сессии
+                stats.sessions_rejected.fetch_add(1, std::memory_order_relaxed);
+                socket.close(ec);
+                return DoAccept();
+            }
+
+            // Без TCP_NODELAY ответы конвейера, записанные по отдельности, ждут ACK клиента (алгоритм Нейгла)
+            socket.set_option(tcp::no_delay(tcp_nodelay_), ec);
+            socket.set_option(net::socket_base::keep_alive(tcp_keepalive_), ec);
+
             // Асинхронно обрабатываем сессию
             AsyncRunSession(std::move(socket));
 
@@ -208,17 +615,20 @@ namespace http_server {
         }
 
         void AsyncRunSession(tcp::socket&& socket) {
-            std::make_shared<Session<RequestHandler>>(std::move(socket), request_handler_)->Run();
+            std::make_shared<Session<RequestHandler>>(std::move(socket), session_options_, request_handler_)->Run();
         }
     };
 
+    // Запускает по одному Listener на каждый адрес из options.endpoints
     template <typename RequestHandler>
-    void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler) {
+    void ServeHttp(net::io_context& ioc, const ServerOptions& options, RequestHandler&& handler) {
         // При помощи decay_t исключим ссылки из типа RequestHandler,
         // чтобы Listener хранил RequestHandler по значению
         using MyListener = Listener<std::decay_t<RequestHandler>>;
 
-        std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler))->Run();
+        for (const auto& endpoint : options.endpoints) {
+            std::make_shared<MyListener>(ioc, endpoint, options, handler)->Run();
+        }
     }
 
 }  // namespace http_server
@@ -20,6 +20,9 @@ namespace json_support
     char const* INVALID_TOKEN = "invalidToken";
     char const* UNKNOWN_TOKEN = "unknownToken";
     char const* BAD_REQUEST = "badRequest";
+    char const* SERVICE_UNAVAILABLE = "serviceUnavailable";
+    char const* TOO_MANY_REQUESTS = "tooManyRequests";
+    char const* FORBIDDEN = "forbidden";
 
     namespace json = boost::json;
     using namespace std::literals;
@@ -38,20 +41,16 @@ namespace json_support
         return maps_arr;
     }
 
-    json::object GetJSONRequiredMap(const std::shared_ptr<model::Map>& map, const std::unordered_map<std::string_view, boost::json::array> loot_types)
+    json::object GetJSONRequiredMap(const std::shared_ptr<model::Map>& map, const std::unordered_map<std::string_view, boost::json::array>& loot_types)
     {
         boost::json::object json_map;
-        std::string id = *(map->GetId());
-        std::string name = map->GetName();
-        std::vector<model::Road> roads = map->GetRoads();
-        std::vector<model::Building> buildings = map->GetBuildings();
-        std::vector<model::Office> offices = map->GetOffices();
+        const std::string& id = *(map->GetId());
 
         json_map[ID] = json::string(id);
-        json_map[NAME] = json::string(name);
-        json_map["roads"] = MakeJSONRoadsArr(roads);
-        json_map["buildings"] = MakeJSONBuildingsArr(buildings);
-        json_map["offices"] = MakeJSONOfficesArr(offices);
+        json_map[NAME] = json::string(map->GetName());
+        json_map["roads"] = MakeJSONRoadsArr(map->GetRoads());
+        json_map["buildings"] = MakeJSONBuildingsArr(map->GetBuildings());
+        json_map["offices"] = MakeJSONOfficesArr(map->GetOffices());
         json_map["lootTypes"] = loot_types.at(id);
 
         return json_map;
@@ -81,6 +80,30 @@ namespace json_support
         return not_allowed_method;
     }
 
+    json::object GetJSONServiceUnavailable()
+    {
+        json::object unavailable;
+        unavailable[CODE] = SERVICE_UNAVAILABLE;
+        unavailable[MESSAGE] = json::string("Server is overloaded, retry later");
+        return unavailable;
+    }
+
+    json::object GetJSONTooManyRequests()
+    {
+        json::object too_many;
+        too_many[CODE] = TOO_MANY_REQUESTS;
+        too_many[MESSAGE] = json::string("Request rate limit exceeded");
+        return too_many;
+    }
+
+    json::object GetJSONForbidden()
+    {
+        json::object forbidden;
+        forbidden[CODE] = FORBIDDEN;
+        forbidden[MESSAGE] = json::string("Admin token required");
+        return forbidden;
+    }
+
     json::array MakeJSONRoadsArr(const std::vector<model::Road>& roads)
     {
         json::array road_arr;
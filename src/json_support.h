@@ -21,10 +21,13 @@ namespace json_support
     using namespace std::literals;
     //For API
     json::array GetJSONAllMaps(const model::Game::Maps& maps);
-    json::object GetJSONRequiredMap(const std::shared_ptr<model::Map>& map, const std::unordered_map<std::string_view, boost::json::array>);
+    json::object GetJSONRequiredMap(const std::shared_ptr<model::Map>& map, const std::unordered_map<std::string_view, boost::json::array>& loot_types);
     json::object GetJSONNotFound();
     json::object GetJSONBadRequest();
     json::object GetJSONNotAllowedMethod();
+    json::object GetJSONServiceUnavailable();
+    json::object GetJSONTooManyRequests();
+    json::object GetJSONForbidden();
 
     json::array MakeJSONRoadsArr(const std::vector<model::Road>&);
     json::array MakeJSONBuildingsArr(const std::vector<model::Building>&);
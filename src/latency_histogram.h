@@ -0,0 +1,181 @@
+#pragma once
+#include <boost/json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace latency
+{
+    // Гистограмма в духе HdrHistogram: на каждую степень двойки SUB_BUCKETS равных корзин,
+    // поэтому относительная ошибка перцентилей не больше 1 / SUB_BUCKETS на всём диапазоне uint64.
+    // Единицы значений выбирает вызывающий. Не потокобезопасна: потоки пишут в свои и потом сливаются через Merge
+    class Histogram
+    {
+    public:
+        static constexpr int SUB_BITS = 5;
+        static constexpr uint64_t SUB_BUCKETS = uint64_t{ 1 } << SUB_BITS;
+        static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+        static size_t BucketIndex(uint64_t value) noexcept
+        {
+            if (value < SUB_BUCKETS)
+                return static_cast<size_t>(value);
+            const int msb = std::bit_width(value) - 1;
+            const int shift = msb - SUB_BITS;
+            return static_cast<size_t>(shift + 1) * SUB_BUCKETS + static_cast<size_t>((value >> shift) - SUB_BUCKETS);
+        }
+
+        // Наименьшее значение корзины
+        static uint64_t BucketLow(size_t index) noexcept
+        {
+            const size_t group = index / SUB_BUCKETS;
+            if (group == 0)
+                return index;
+            return (SUB_BUCKETS + index % SUB_BUCKETS) << (group - 1);
+        }
+
+        // Наибольшее значение корзины
+        static uint64_t BucketHigh(size_t index) noexcept
+        {
+            const size_t group = index / SUB_BUCKETS;
+            return group == 0 ? index : BucketLow(index) + ((uint64_t{ 1 } << (group - 1)) - 1);
+        }
+
+        void Record(uint64_t value) noexcept
+        {
+            ++counts_[BucketIndex(value)];
+            ++count_;
+            sum_ += value;
+            min_ = std::min(min_, value);
+            max_ = std::max(max_, value);
+        }
+
+        void Merge(const Histogram& other) noexcept
+        {
+            for (size_t i = 0; i < BUCKETS; ++i)
+                counts_[i] += other.counts_[i];
+            count_ += other.count_;
+            sum_ += other.sum_;
+            min_ = std::min(min_, other.min_);
+            max_ = std::max(max_, other.max_);
+        }
+
+        uint64_t GetCount() const noexcept
+        {
+            return count_;
+        }
+
+        uint64_t GetBucketCount(size_t index) const noexcept
+        {
+            return counts_[index];
+        }
+
+        uint64_t GetMin() const noexcept
+        {
+            return count_ == 0 ? 0 : min_;
+        }
+
+        uint64_t GetMax() const noexcept
+        {
+            return max_;
+        }
+
+        double GetMean() const noexcept
+        {
+            return count_ == 0 ? 0.0 : static_cast<double>(sum_) / static_cast<double>(count_);
+        }
+
+        // p от 0 до 1. Верхняя граница корзины, в которую попал перцентиль, но не больше максимума
+        uint64_t Percentile(double p) const noexcept
+        {
+            if (count_ == 0)
+                return 0;
+            const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * static_cast<double>(count_))));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKETS; ++i)
+            {
+                seen += counts_[i];
+                if (seen >= rank)
+                    return std::min(std::max(BucketHigh(i), min_), max_);
+            }
+            return max_;
+        }
+
+    private:
+        friend class AtomicHistogram;
+
+        std::array<uint64_t, BUCKETS> counts_{};
+        uint64_t count_ = 0;
+        uint64_t sum_ = 0;
+        uint64_t min_ = std::numeric_limits<uint64_t>::max();
+        uint64_t max_ = 0;
+    };
+
+    // Те же корзины на атомарных счётчиках: один поток пишет без блокировок, другие в это время снимают копию.
+    // Копия может разойтись с пишущим потоком на последние значения, но число значений в ней равно сумме корзин
+    class AtomicHistogram
+    {
+    public:
+        void Record(uint64_t value) noexcept
+        {
+            counts_[Histogram::BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+            sum_.fetch_add(value, std::memory_order_relaxed);
+            uint64_t min = min_.load(std::memory_order_relaxed);
+            while (value < min && !min_.compare_exchange_weak(min, value, std::memory_order_relaxed))
+                ;
+            uint64_t max = max_.load(std::memory_order_relaxed);
+            while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed))
+                ;
+        }
+
+        Histogram Snapshot() const noexcept
+        {
+            Histogram result;
+            for (size_t i = 0; i < Histogram::BUCKETS; ++i)
+            {
+                result.counts_[i] = counts_[i].load(std::memory_order_relaxed);
+                result.count_ += result.counts_[i];
+            }
+            result.sum_ = sum_.load(std::memory_order_relaxed);
+            result.min_ = min_.load(std::memory_order_relaxed);
+            result.max_ = max_.load(std::memory_order_relaxed);
+            // Корзина могла обновиться раньше границ
+            if (result.count_ != 0)
+                result.min_ = std::min(result.min_, result.max_);
+            return result;
+        }
+
+    private:
+        std::array<std::atomic<uint64_t>, Histogram::BUCKETS> counts_{};
+        std::atomic<uint64_t> sum_{ 0 };
+        std::atomic<uint64_t> min_{ std::numeric_limits<uint64_t>::max() };
+        std::atomic<uint64_t> max_{ 0 };
+    };
+
+    // Сводка и непустые корзины как [наибольшее значение корзины, число значений]
+    inline boost::json::object MakeJSONHistogram(const Histogram& histogram)
+    {
+        boost::json::object result;
+        result["count"] = histogram.GetCount();
+        result["min"] = histogram.GetMin();
+        result["mean"] = histogram.GetMean();
+        result["p50"] = histogram.Percentile(0.5);
+        result["p90"] = histogram.Percentile(0.9);
+        result["p99"] = histogram.Percentile(0.99);
+        result["p999"] = histogram.Percentile(0.999);
+        result["max"] = histogram.GetMax();
+        boost::json::array buckets;
+        for (size_t i = 0; i < Histogram::BUCKETS; ++i)
+        {
+            if (uint64_t count = histogram.GetBucketCount(i))
+                buckets.push_back(boost::json::array{ Histogram::BucketHigh(i), count });
+        }
+        result["buckets"] = std::move(buckets);
+        return result;
+    }
+}
@@ -0,0 +1,190 @@
+#include "leaderboard.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace leaderboard
+{
+    bool IsRankedHigher(const Entry& lhs, const Entry& rhs)
+    {
+        return std::tie(rhs.score, lhs.play_time_ms, lhs.name, lhs.id) < std::tie(lhs.score, rhs.play_time_ms, rhs.name, rhs.id);
+    }
+
+    bool operator==(const Entry& lhs, const Entry& rhs)
+    {
+        return std::tie(lhs.score, lhs.play_time_ms, lhs.name, lhs.id) == std::tie(rhs.score, rhs.play_time_ms, rhs.name, rhs.id);
+    }
+
+    bool RankTree::Insert(Entry entry)
+    {
+        if (GetRank(entry))
+            return false;
+        size_t rank = CountHigher(entry);
+
+        uint32_t node;
+        if (free_.empty())
+        {
+            node = static_cast<uint32_t>(nodes_.size());
+            nodes_.push_back({ std::move(entry), NextPriority() });
+        }
+        else
+        {
+            node = free_.back();
+            free_.pop_back();
+            nodes_[node] = { std::move(entry), NextPriority() };
+        }
+
+        uint32_t left, right;
+        Split(root_, rank, left, right);
+        root_ = Merge(Merge(left, node), right);
+        return true;
+    }
+
+    bool RankTree::Erase(const Entry& entry)
+    {
+        auto rank = GetRank(entry);
+        if (!rank)
+            return false;
+
+        uint32_t left, middle, right;
+        Split(root_, *rank, left, right);
+        Split(right, 1, middle, right);
+        nodes_[middle].entry = {};
+        free_.push_back(middle);
+        root_ = Merge(left, right);
+        return true;
+    }
+
+    size_t RankTree::CountHigher(const Entry& key) const
+    {
+        size_t count = 0;
+        uint32_t node = root_;
+        while (node != NIL)
+        {
+            const Node& n = nodes_[node];
+            if (IsRankedHigher(n.entry, key))
+            {
+                count += SizeOf(n.left) + 1;
+                node = n.right;
+            }
+            else
+                node = n.left;
+        }
+        return count;
+    }
+
+    std::optional<size_t> RankTree::GetRank(const Entry& entry) const
+    {
+        size_t rank = 0;
+        uint32_t node = root_;
+        while (node != NIL)
+        {
+            const Node& n = nodes_[node];
+            if (IsRankedHigher(n.entry, entry))
+            {
+                rank += SizeOf(n.left) + 1;
+                node = n.right;
+            }
+            else if (IsRankedHigher(entry, n.entry))
+                node = n.left;
+            else
+                return rank + SizeOf(n.left);
+        }
+        return std::nullopt;
+    }
+
+    std::vector<Entry> RankTree::GetRange(size_t offset, size_t limit) const
+    {
+        std::vector<Entry> out;
+        if (offset >= Size() || limit == 0)
+            return out;
+        out.reserve(std::min(limit, Size() - offset));
+        Collect(root_, offset, limit, out);
+        return out;
+    }
+
+    void RankTree::Clear()
+    {
+        nodes_.clear();
+        free_.clear();
+        root_ = NIL;
+    }
+
+    uint64_t RankTree::NextPriority()
+    {
+        // splitmix64: приоритеты не зависят от порядка вставки, дерево сбалансировано
+        // и при загрузке уже отсортированной таблицы из БД
+        uint64_t z = (seed_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    void RankTree::Update(uint32_t node)
+    {
+        Node& n = nodes_[node];
+        n.size = SizeOf(n.left) + SizeOf(n.right) + 1;
+    }
+
+    void RankTree::Split(uint32_t node, size_t count, uint32_t& left, uint32_t& right)
+    {
+        if (node == NIL)
+        {
+            left = right = NIL;
+            return;
+        }
+
+        size_t left_size = SizeOf(nodes_[node].left);
+        if (count <= left_size)
+        {
+            Split(nodes_[node].left, count, left, nodes_[node].left);
+            right = node;
+        }
+        else
+        {
+            Split(nodes_[node].right, count - left_size - 1, nodes_[node].right, right);
+            left = node;
+        }
+        Update(node);
+    }
+
+    uint32_t RankTree::Merge(uint32_t left, uint32_t right)
+    {
+        if (left == NIL)
+            return right;
+        if (right == NIL)
+            return left;
+
+        if (nodes_[left].priority > nodes_[right].priority)
+        {
+            nodes_[left].right = Merge(nodes_[left].right, right);
+            Update(left);
+            return left;
+        }
+        nodes_[right].left = Merge(left, nodes_[right].left);
+        Update(right);
+        return right;
+    }
+
+    void RankTree::Collect(uint32_t node, size_t& skip, size_t limit, std::vector<Entry>& out) const
+    {
+        if (node == NIL || out.size() >= limit)
+            return;
+
+        const Node& n = nodes_[node];
+        // Поддеревья целиком до offset пропускаются по размеру, не обходом
+        size_t left_size = SizeOf(n.left);
+        if (skip >= left_size)
+            skip -= left_size;
+        else
+            Collect(n.left, skip, limit, out);
+
+        if (out.size() >= limit)
+            return;
+        if (skip > 0)
+            --skip;
+        else
+            out.push_back(n.entry);
+        Collect(n.right, skip, limit, out);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace leaderboard
+{
+    // Ключ таблицы: больше очков, меньше время игры, затем имя и id побайтово
+    struct Entry
+    {
+        int score = 0;
+        int64_t play_time_ms = 0;
+        std::string name;
+        std::string id;
+    };
+
+    bool IsRankedHigher(const Entry& lhs, const Entry& rhs);
+    bool operator==(const Entry& lhs, const Entry& rhs);
+
+    // Декартово дерево с размерами поддеревьев: вставка, удаление, место записи
+    // и выборка диапазона мест за O(log n) в среднем. Не потокобезопасно
+    class RankTree
+    {
+    public:
+        explicit RankTree(uint64_t seed = 0x9E3779B97F4A7C15ull) : seed_(seed) {}
+
+        // false, если такая запись уже есть
+        bool Insert(Entry entry);
+        // false, если записи нет
+        bool Erase(const Entry& entry);
+
+        // Сколько записей стоит выше key. Сама key в дереве может отсутствовать
+        size_t CountHigher(const Entry& key) const;
+        // Место записи с нуля или nullopt, если её нет
+        std::optional<size_t> GetRank(const Entry& entry) const;
+        // Не больше limit записей начиная с места offset
+        std::vector<Entry> GetRange(size_t offset, size_t limit) const;
+
+        size_t Size() const noexcept
+        {
+            return SizeOf(root_);
+        }
+
+        void Clear();
+
+    private:
+        static constexpr uint32_t NIL = UINT32_MAX;
+
+        struct Node
+        {
+            Entry entry;
+            uint64_t priority;
+            uint32_t left = NIL;
+            uint32_t right = NIL;
+            uint32_t size = 1;
+        };
+
+        // Узлы лежат в одном векторе, удалённые переиспользуются через free_
+        std::vector<Node> nodes_;
+        std::vector<uint32_t> free_;
+        uint32_t root_ = NIL;
+        uint64_t seed_;
+
+        uint32_t SizeOf(uint32_t node) const noexcept
+        {
+            return node == NIL ? 0 : nodes_[node].size;
+        }
+
+        uint64_t NextPriority();
+        void Update(uint32_t node);
+        // Первые count записей дерева node уходят в left, остальные - в right
+        void Split(uint32_t node, size_t count, uint32_t& left, uint32_t& right);
+        uint32_t Merge(uint32_t left, uint32_t right);
+        void Collect(uint32_t node, size_t& skip, size_t limit, std::vector<Entry>& out) const;
+    };
+}
@@ -0,0 +1,281 @@
+#include "local_store.h"
+#include "binary_codec.h"
+
+#include <stdexcept>
+#include <string_view>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "tagged_uuid.h"
+
+namespace storage
+{
+    namespace
+    {
+        // Строка файла: размер тела, CRC32 тела, тело. Числа - в порядке байт машины
+        constexpr size_t HEADER_SIZE = 2 * sizeof(uint32_t);
+        // Самое длинное тело, которое пишет AppendRecord: очки, время игры и две строки с длиной в uint16
+        constexpr size_t MAX_RECORD_SIZE = sizeof(int32_t) + sizeof(int64_t) + 2 * (sizeof(uint16_t) + UINT16_MAX);
+        constexpr size_t COMPACT_CHUNK = 10000;
+
+        using codec::Checksum;
+        using codec::Get;
+        using codec::GetString;
+        using codec::Put;
+        using codec::PutString;
+
+        leaderboard::Entry ToEntry(const RetiredPlayer& player)
+        {
+            return { player.score, player.play_time_ms, player.name, player.id };
+        }
+
+        RetiredPlayer ToRetiredPlayer(leaderboard::Entry entry)
+        {
+            return { std::move(entry.id), std::move(entry.name), entry.score, entry.play_time_ms };
+        }
+
+        void AppendRecord(std::string& out, const leaderboard::Entry& entry)
+        {
+            std::string body;
+            Put<int32_t>(body, entry.score);
+            Put<int64_t>(body, entry.play_time_ms);
+            PutString<uint16_t>(body, std::string_view(entry.id).substr(0, UINT16_MAX));
+            // Имя ограничено 100 символами ещё при входе в игру, здесь - размером поля длины
+            PutString<uint16_t>(body, std::string_view(entry.name).substr(0, UINT16_MAX));
+
+            Put<uint32_t>(out, static_cast<uint32_t>(body.size()));
+            Put<uint32_t>(out, Checksum(body));
+            out += body;
+        }
+
+        void WriteAll(std::FILE* file, const std::string& data, const std::filesystem::path& path)
+        {
+            if (std::fwrite(data.data(), 1, data.size(), file) != data.size() || std::fflush(file) != 0)
+                throw std::runtime_error("Can't write " + path.string());
+        }
+    }
+
+    LocalStore::LocalStore(Options options)
+        : options_(std::move(options))
+        , snapshot_path_(options_.dir / "records.dat")
+        , log_path_(options_.dir / "records.log")
+    {
+        std::filesystem::create_directories(options_.dir);
+        Load(snapshot_path_, false);
+        uint64_t valid = Load(log_path_, true);
+
+        // Хвост журнала, оборванный при падении, отрезается: дальше в него пишутся целые строки
+        if (std::filesystem::exists(log_path_) && std::filesystem::file_size(log_path_) > valid)
+        {
+            truncated_bytes_ = std::filesystem::file_size(log_path_) - valid;
+            std::filesystem::resize_file(log_path_, valid);
+        }
+        OpenLog("ab");
+        log_size_ = valid;
+    }
+
+    LocalStore::~LocalStore()
+    {
+        if (log_)
+            std::fclose(log_);
+    }
+
+    void LocalStore::AddRetiredPlayers(const std::vector<RetiredPlayer>& players)
+    {
+        if (players.empty())
+            return;
+
+        std::vector<leaderboard::Entry> entries;
+        entries.reserve(players.size());
+        std::string data;
+        for (const auto& player : players)
+        {
+            entries.push_back(ToEntry(player));
+            if (entries.back().id.empty())
+                entries.back().id = util::detail::UUIDToString(util::detail::NewUUID());
+            AppendRecord(data, entries.back());
+        }
+
+        std::lock_guard write_lock{ write_mutex_ };
+        // Строка попадает в индекс только после записи в журнал
+        try
+        {
+            WriteAll(log_, data, log_path_);
+            if (options_.sync)
+                Sync(log_);
+        }
+        catch (...)
+        {
+            RollbackLog();
+            throw;
+        }
+        log_size_ += data.size();
+        {
+            std::unique_lock index_lock{ index_mutex_ };
+            for (auto& entry : entries)
+                index_.Insert(std::move(entry));
+        }
+
+        if ((log_records_ += players.size()) >= options_.compact_after)
+            CompactLocked();
+    }
+
+    std::vector<RetiredPlayer> LocalStore::GetRetiredPlayersPage(const RetiredPlayer* after, size_t offset, size_t limit)
+    {
+        std::vector<leaderboard::Entry> entries;
+        {
+            std::shared_lock lock{ index_mutex_ };
+            if (after)
+            {
+                leaderboard::Entry key = ToEntry(*after);
+                offset = index_.CountHigher(key) + (index_.GetRank(key) ? 1 : 0);
+            }
+            entries = index_.GetRange(offset, limit);
+        }
+
+        std::vector<RetiredPlayer> page;
+        page.reserve(entries.size());
+        for (auto& entry : entries)
+            page.push_back(ToRetiredPlayer(std::move(entry)));
+        return page;
+    }
+
+    boost::json::object LocalStore::GetStats() const
+    {
+        return boost::json::object{
+            {"backend", "local"},
+            {"records", Size()},
+            {"logRecords", log_records_.load(std::memory_order_relaxed)},
+            {"compactions", compactions_.load(std::memory_order_relaxed)},
+            {"truncatedBytes", truncated_bytes_}
+        };
+    }
+
+    void LocalStore::Compact()
+    {
+        std::lock_guard write_lock{ write_mutex_ };
+        CompactLocked();
+    }
+
+    void LocalStore::CompactLocked()
+    {
+        // Пока мьютекс записи занят, индекс меняться не может: читаем его кусками без блокировки читателей
+        std::filesystem::path tmp_path = snapshot_path_;
+        tmp_path += ".tmp";
+        std::FILE* tmp = std::fopen(tmp_path.string().c_str(), "wb");
+        if (!tmp)
+            throw std::runtime_error("Can't create " + tmp_path.string());
+        try
+        {
+            for (size_t offset = 0; ; offset += COMPACT_CHUNK)
+            {
+                std::vector<leaderboard::Entry> chunk;
+                {
+                    std::shared_lock index_lock{ index_mutex_ };
+                    chunk = index_.GetRange(offset, COMPACT_CHUNK);
+                }
+                if (chunk.empty())
+                    break;
+
+                std::string data;
+                for (const auto& entry : chunk)
+                    AppendRecord(data, entry);
+                WriteAll(tmp, data, tmp_path);
+            }
+            Sync(tmp);
+        }
+        catch (...)
+        {
+            std::fclose(tmp);
+            throw;
+        }
+        std::fclose(tmp);
+
+        // Падение между rename и очисткой журнала безопасно: повторные строки при загрузке отбрасываются
+        std::filesystem::rename(tmp_path, snapshot_path_);
+        std::fclose(log_);
+        log_ = nullptr;
+        OpenLog("wb");
+        log_size_ = 0;
+        log_records_ = 0;
+        ++compactions_;
+    }
+
+    size_t LocalStore::Size() const
+    {
+        std::shared_lock lock{ index_mutex_ };
+        return index_.Size();
+    }
+
+    uint64_t LocalStore::Load(const std::filesystem::path& path, bool is_log)
+    {
+        std::FILE* file = std::fopen(path.string().c_str(), "rb");
+        if (!file)
+            return 0;
+
+        uint64_t valid = 0;
+        std::string header(HEADER_SIZE, '\0');
+        std::string body;
+        while (std::fread(header.data(), 1, HEADER_SIZE, file) == HEADER_SIZE)
+        {
+            std::string_view in = header;
+            uint32_t size = 0, crc = 0;
+            Get(in, size);
+            Get(in, crc);
+            if (size > MAX_RECORD_SIZE)
+                break;
+            body.resize(size);
+            if (std::fread(body.data(), 1, size, file) != size || Checksum(body) != crc)
+                break;
+
+            leaderboard::Entry entry;
+            std::string_view fields = body;
+            int32_t score = 0;
+            if (!Get(fields, score) || !Get(fields, entry.play_time_ms) || !GetString<uint16_t>(fields, entry.id) || !GetString<uint16_t>(fields, entry.name))
+                break;
+            entry.score = score;
+            index_.Insert(std::move(entry));
+            valid += HEADER_SIZE + size;
+            if (is_log)
+                ++log_records_;
+        }
+
+        bool complete = std::feof(file) && valid == std::filesystem::file_size(path);
+        std::fclose(file);
+        // Снимок пишется целиком и переименовывается, повреждение в нём - не обрыв записи
+        if (!is_log && !complete)
+            throw std::runtime_error("Records snapshot is corrupted: " + path.string());
+        return valid;
+    }
+
+    void LocalStore::OpenLog(const char* mode)
+    {
+        log_ = std::fopen(log_path_.string().c_str(), mode);
+        if (!log_)
+            throw std::runtime_error("Can't open " + log_path_.string());
+    }
+
+    void LocalStore::RollbackLog()
+    {
+        // Часть пачки могла попасть в файл. Без отката следующие пачки легли бы за оборванной строкой,
+        // и при загрузке журнал обрезался бы на ней вместе с ними
+        std::fclose(log_);
+        log_ = nullptr;
+        std::error_code ec;
+        std::filesystem::resize_file(log_path_, log_size_, ec);
+        OpenLog("ab");
+        if (ec)
+            throw std::runtime_error("Can't truncate " + log_path_.string() + ": " + ec.message());
+    }
+
+    void LocalStore::Sync(std::FILE* file)
+    {
+        std::fflush(file);
+#ifdef __linux__
+        if (::fsync(::fileno(file)) != 0)
+            throw std::runtime_error("fsync failed");
+#endif
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <shared_mutex>
+
+#include "records_storage.h"
+#include "leaderboard.h"
+
+namespace storage
+{
+    // Зал славы без Postgres: для одного узла, тестов и бенчмарков.
+    // На диске - отсортированный снимок records.dat и журнал дописываемых строк records.log,
+    // в памяти - дерево с местами всех строк. Журнал периодически сливается в новый снимок
+    class LocalStore : public RecordsStorage
+    {
+    public:
+        struct Options
+        {
+            std::filesystem::path dir;
+            // Журнал сливается со снимком, когда в нём набирается столько строк
+            size_t compact_after = 100000;
+            // fsync журнала после каждой пачки. Без него пачка переживает падение процесса, но не ОС
+            bool sync = false;
+        };
+
+        explicit LocalStore(Options options);
+        ~LocalStore() override;
+        LocalStore(const LocalStore&) = delete;
+        LocalStore& operator=(const LocalStore&) = delete;
+
+        void AddRetiredPlayers(const std::vector<RetiredPlayer>& players) override;
+        std::vector<RetiredPlayer> GetRetiredPlayersPage(const RetiredPlayer* after, size_t offset, size_t limit) override;
+        boost::json::object GetStats() const override;
+
+        // Переписывает снимок по индексу и очищает журнал. Чтение при этом не блокируется
+        void Compact();
+        size_t Size() const;
+
+    private:
+        Options options_;
+        std::filesystem::path snapshot_path_;
+        std::filesystem::path log_path_;
+
+        mutable std::shared_mutex index_mutex_;
+        leaderboard::RankTree index_;
+
+        // Запись в журнал и сжатие выполняются по одной
+        std::mutex write_mutex_;
+        std::FILE* log_ = nullptr;
+        // Длина журнала по последнюю целиком записанную пачку
+        uint64_t log_size_ = 0;
+        std::atomic<size_t> log_records_{ 0 };
+        std::atomic<uint64_t> compactions_{ 0 };
+        uint64_t truncated_bytes_ = 0;
+
+        // Загружает файл в индекс. Возвращает длину корректного начала файла
+        uint64_t Load(const std::filesystem::path& path, bool is_log);
+        // Вызывается под write_mutex_
+        void CompactLocked();
+        void OpenLog(const char* mode);
+        // Обрезает журнал после неудачной записи до log_size_ и открывает заново
+        void RollbackLog();
+        void Sync(std::FILE* file);
+    };
+}
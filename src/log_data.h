@@ -0,0 +1,9 @@
+#pragma once
+#include <boost/json/object.hpp>
+#include <boost/log/expressions/keyword.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/utility/manipulators/add_value.hpp>
+
+// JSON-тело записи лога. Консольный лог сервера печатает только его:
+// BOOST_LOG_TRIVIAL(info) << boost::log::add_value(data, message)
+BOOST_LOG_ATTRIBUTE_KEYWORD(data, "AdditionalData", boost::json::object)
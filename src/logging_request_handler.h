@@ -16,6 +16,7 @@
 #include <boost/date_time.hpp>
 
 #include "json_support.h"
+#include "log_data.h"
 
 namespace net = boost::asio;
 namespace logging = boost::log;
@@ -30,8 +31,6 @@ using FileResponse = http::response<http::file_body>;
 using Response = std::variant<StringResponse, FileResponse>;
 using Strand = net::strand<net::io_context::executor_type>;
 
-BOOST_LOG_ATTRIBUTE_KEYWORD(data, "AdditionalData", json::object)
-
 namespace server_logging
 {
     template <class SomeRequestHandler>
@@ -79,7 +78,7 @@ namespace server_logging
                     send(response);
                 };
 
-            decorated_.operator()(std::move(req), std::move(log_send));
+            decorated_.operator()(endp, std::move(req), std::move(log_send));
         }
 
         void LogServerStarted(const net::ip::port_type port, const boost::asio::ip::address address)
@@ -0,0 +1,73 @@
+#include "maps_cache.h"
+#include "json_support.h"
+#include "etag.h"
+
+namespace maps_cache
+{
+    using namespace std::literals;
+
+    namespace
+    {
+        Representation MakeEncodedRepresentation(const Representation& identity, compression::Encoding encoding)
+        {
+            Representation representation;
+            std::string packed = compression::Compress(*identity.body, encoding, compression::Level::BEST);
+            if (packed.size() >= identity.body->size())
+                return representation;
+
+            // У каждого представления свой сильный ETag: "<hash>-gzip", "<hash>-br"
+            representation.etag = identity.etag;
+            representation.etag.insert(representation.etag.size() - 1, "-"s.append(compression::GetEncodingName(encoding)));
+            representation.body = std::make_shared<const std::string>(std::move(packed));
+            return representation;
+        }
+
+        CachedDocument MakeDocument(std::string body)
+        {
+            CachedDocument document;
+            document.identity.etag = etag::MakeStrongETag(body);
+            document.identity.body = std::make_shared<const std::string>(std::move(body));
+            document.gzip = MakeEncodedRepresentation(document.identity, compression::Encoding::GZIP);
+            document.brotli = MakeEncodedRepresentation(document.identity, compression::Encoding::BROTLI);
+            return document;
+        }
+    }
+
+    const Representation& CachedDocument::Select(compression::Encoding& encoding) const
+    {
+        if (encoding == compression::Encoding::BROTLI && brotli.body)
+            return brotli;
+        if (encoding != compression::Encoding::IDENTITY && gzip.body)
+        {
+            encoding = compression::Encoding::GZIP;
+            return gzip;
+        }
+        encoding = compression::Encoding::IDENTITY;
+        return identity;
+    }
+
+    MapsCache::MapsCache(const model::Game& game)
+    {
+        const auto& loot_types = game.GetExtraData().GetJSONLootType();
+
+        maps_list_ = MakeDocument(json_support::GetFormattedJSONStr(json_support::GetJSONAllMaps(game.GetMaps())));
+        maps_.reserve(game.GetMaps().size());
+        for (const auto& map : game.GetMaps())
+        {
+            maps_.emplace(*map->GetId(),
+                MakeDocument(json_support::GetFormattedJSONStr(json_support::GetJSONRequiredMap(map, loot_types))));
+        }
+    }
+
+    const CachedDocument& MapsCache::GetMapsList() const noexcept
+    {
+        return maps_list_;
+    }
+
+    const CachedDocument* MapsCache::FindMap(std::string_view id) const
+    {
+        if (auto it = maps_.find(id); it != maps_.end())
+            return &it->second;
+        return nullptr;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "model.h"
+#include "compression.h"
+
+namespace maps_cache
+{
+    struct Representation
+    {
+        std::shared_ptr<const std::string> body;
+        std::string etag;
+    };
+
+    // Готовый к отправке неизменяемый JSON-документ и его заранее сжатые варианты
+    struct CachedDocument
+    {
+        Representation identity;
+        // Пустой body - сжатие не дало выигрыша
+        Representation gzip;
+        Representation brotli;
+
+        // Возвращает вариант для кодировки клиента, encoding заменяется на фактически выбранную
+        const Representation& Select(compression::Encoding& encoding) const;
+    };
+
+    // Карты не меняются после json_loader::LoadGame, поэтому ответы /api/v1/maps
+    // сериализуются один раз при старте и дальше только копируются в ответ
+    class MapsCache
+    {
+    public:
+        explicit MapsCache(const model::Game& game);
+        MapsCache(const MapsCache&) = delete;
+        MapsCache& operator=(const MapsCache&) = delete;
+
+        const CachedDocument& GetMapsList() const noexcept;
+        // nullptr, если карты с таким id нет
+        const CachedDocument* FindMap(std::string_view id) const;
+
+    private:
+        struct StringHasher
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view str) const noexcept
+            {
+                return std::hash<std::string_view>{}(str);
+            }
+        };
+
+        CachedDocument maps_list_;
+        std::unordered_map<std::string, CachedDocument, StringHasher, std::equal_to<>> maps_;
+    };
+}
@@ -1,7 +1,10 @@
 #include "model.h"
+#include "log_data.h"
+#include "tick_profiler.h"
 #include <algorithm>
+#include <bit>
+#include <functional>
 #include <stdexcept>
-#include <fstream>
 #include <set>
 
 namespace model {
@@ -165,29 +168,29 @@ LootCoord Map::GetRandomPosLoot() const noexcept
     return GetRandomPosDog();
 }
 
+void Map::SeedRandom(uint64_t seed)
+{
+    std::seed_seq seq{ static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) };
+    rng_.seed(seq);
+}
+
 int Map::GetRandomRoadIndex() const
 {
-    std::random_device dev;
-    std::mt19937 rng(dev());
     std::uniform_int_distribution<std::mt19937::result_type> dist(0, static_cast<int>(roads_.size() - 1));
 
-    return dist(rng);
+    return dist(rng_);
 }
 
 int Map::GetRandomLootTypeIndex(size_t loot_types_size) const
 {
-    std::random_device dev;
-    std::mt19937 rng(dev());
     std::uniform_int_distribution<std::mt19937::result_type> dist(0, static_cast<int>(loot_types_size - 1));
 
-    return dist(rng);
+    return dist(rng_);
 }
 
 DogCoord Map::GetRandomCoord(const int index) const
 {
     Road road = roads_[index];
-    std::random_device dev;
-    std::mt19937 rng(dev());
 
     double start_x = static_cast<double>(road.GetStart().x - HALF_ROAD_WIDTH);
     double end_x = static_cast<double>(road.GetEnd().x + HALF_ROAD_WIDTH);
@@ -212,7 +215,7 @@ DogCoord Map::GetRandomCoord(const int index) const
     std::uniform_real_distribution<double> dist(start_x, end_x);
     std::uniform_real_distribution<double> dist2(start_y, end_y);
 
-    return { dist(rng), dist2(rng) };
+    return { dist(rng_), dist2(rng_) };
 }
 
 std::vector<Road> Map::WhatRoadsDogOn(const DogCoord coords) const
@@ -288,6 +291,11 @@ Dog::Dog(Direction dir, DogSpeed speed, DogCoord start_pos) : coords_(std::move(
     object_id_ = generation_id_;
 }
 
+Dog::Dog(int object_id, Direction dir, DogSpeed speed, DogCoord start_pos)
+    : dir_(std::move(dir)), object_id_(object_id), coords_(std::move(start_pos)), default_speed_(std::move(speed)), idle_time_(0)
+{
+}
+
 const int Dog::GetGenerationId() const noexcept {
     return generation_id_;
 }
@@ -319,17 +327,23 @@ const Direction Dog::GetDirection() const noexcept
 
 void Dog::SetCoords(DogCoord coord)
 {
+    // Стоящей собаке координаты переприсваиваются каждый тик, это не изменение
+    if (coord.x != coords_.x || coord.y != coords_.y)
+        ++version_;
     coords_ = std::move(coord);
 }
 
 void Dog::StopDog()
 {
+    if (speed_.speed_x != 0 || speed_.speed_y != 0)
+        ++version_;
     speed_.speed_x = 0;
     speed_.speed_y = 0;
 }
 
 void Dog::SetInGameSpeed()
 {
+    ++version_;
     switch (dir_)
     {
     case Direction::UP:
@@ -397,6 +411,7 @@ DogCoord Dog::CalculateCoordinates(const std::chrono::milliseconds deltaTime) co
 
 void Dog::SetInGameDirection(Direction dir)
 {
+    ++version_;
     dir_ = std::move(dir);
 }
 
@@ -413,6 +428,7 @@ void Dog::DropLoot()
     }
 
     bag_.clear();
+    ++version_;
 }
 
 void Dog::AddLootElem(const std::shared_ptr<Loot> loot)
@@ -432,6 +448,7 @@ void Dog::AddLootElem(const std::shared_ptr<Loot> loot)
     bag_.clear();
     bag_.resize(bag_.size() + 1);
     bag_ = std::move(t);
+    ++version_;
 }
 
 int Dog::GetCurrentScore() const
@@ -495,11 +512,20 @@ void Game::UpdateGameState(const std::chrono::duration<double, std::milli> delta
         auto dogs = session_.second->GetDogs();
         auto map = session_.second->GetMap();
         collision_detector::Provider provider{};
+        const size_t map_index = profiler_ ? map_id_to_index_.at(map->GetId()) : 0;
 
-        GenerateLoot(provider, map, dogs.size(), time);
-        CalculatePositions(provider, dogs, map, time);
+        {
+            tick_profile::ScopedTimer timer(profiler_, map_index, tick_profile::Phase::LOOT);
+            GenerateLoot(provider, map, dogs.size(), time);
+        }
+        {
+            tick_profile::ScopedTimer timer(profiler_, map_index, tick_profile::Phase::MOVEMENT);
+            CalculatePositions(provider, dogs, map, time);
+        }
+        tick_profile::ScopedTimer timer(profiler_, map_index, tick_profile::Phase::GATHER);
         FindGatherEvents(provider, map, session_.second);
     }
+    replay_loot_.reset();
 }
 
 const std::unordered_map<std::string, std::shared_ptr<GameSession>>& Game::GetSessions() const noexcept
@@ -531,8 +557,80 @@ const ExtraData& Game::GetExtraData() const
     return data_;
 }
 
+void Game::SeedRandom(uint64_t seed)
+{
+    for (size_t i = 0; i < maps_.size(); ++i)
+        maps_[i]->SeedRandom(seed + i * 0x9E3779B97F4A7C15ull);
+}
+
+namespace
+{
+    // splitmix64: перемешивает биты, чтобы сумма хэшей не теряла различий
+    uint64_t Mix(uint64_t value)
+    {
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    uint64_t Combine(uint64_t hash, uint64_t value)
+    {
+        return Mix(hash ^ value);
+    }
+
+    uint64_t Combine(uint64_t hash, double value)
+    {
+        return Combine(hash, std::bit_cast<uint64_t>(value));
+    }
+}
+
+uint64_t Game::GetStateDigest() const
+{
+    uint64_t digest = 0;
+    for (const auto& [map_id, session] : sessions_)
+    {
+        uint64_t map_hash = std::hash<std::string>{}(map_id);
+        for (const auto& [id, dog] : session->GetDogs())
+        {
+            uint64_t h = Combine(map_hash, static_cast<uint64_t>(id));
+            h = Combine(h, dog->GetCoords().x);
+            h = Combine(h, dog->GetCoords().y);
+            h = Combine(h, dog->GetSpeed().speed_x);
+            h = Combine(h, dog->GetSpeed().speed_y);
+            h = Combine(h, static_cast<uint64_t>(dog->GetDirection()));
+            h = Combine(h, static_cast<uint64_t>(dog->GetCurrentScore()));
+            h = Combine(h, static_cast<uint64_t>(dog->GetIdleTime().count()));
+            for (const auto& loot : dog->GetLoot())
+                h = Combine(h, static_cast<uint64_t>(loot->GetId()));
+            digest += h;
+        }
+        for (const auto& loot : session->GetMap()->GetMapLoot())
+        {
+            uint64_t h = Combine(~map_hash, static_cast<uint64_t>(loot->GetId()));
+            h = Combine(h, static_cast<uint64_t>(loot->GetIndex()));
+            h = Combine(h, loot->GetCoord().x);
+            h = Combine(h, loot->GetCoord().y);
+            digest += h;
+        }
+    }
+    return digest;
+}
+
 void Game::GenerateLoot(collision_detector::Provider& provider, std::shared_ptr<Map> map, const unsigned dogs_count, const std::chrono::milliseconds time)
 {
+    if (replay_loot_)
+    {
+        for (const auto& spawn : *replay_loot_)
+        {
+            if (spawn.map_id != *map->GetId())
+                continue;
+            Loot::ReserveIds(spawn.id - 1);
+            map->AddLoot(std::make_shared<Loot>(spawn.type, spawn.coord, spawn.value));
+        }
+        return;
+    }
+
     unsigned new_loot_count = map->GetLootGenerator()->get()->Generate(time, map->GetLootCount(), static_cast<unsigned>(dogs_count));
     auto loot_types = this->GetExtraData().GetJSONLootType().at(*map->GetId());
     for (unsigned i = 0; i < new_loot_count; ++i)
@@ -541,6 +639,7 @@ void Game::GenerateLoot(collision_detector::Provider& provider, std::shared_ptr<
         auto random_pos = map->GetRandomPosLoot();
         std::shared_ptr<Loot> ptr_loot = std::make_shared<Loot>(index, random_pos, static_cast<int>(data_.GetJSONLootType().at(*map->GetId())[index].at("value").get_int64()));
         map->AddLoot(ptr_loot);
+        spawned_loot_.push_back({ *map->GetId(), ptr_loot->GetId(), index, random_pos, ptr_loot->GetValue() });
     }
 }
 void Game::CalculatePositions(collision_detector::Provider& provider, 
@@ -652,8 +751,6 @@ void Game::FindGatherEvents(collision_detector::Provider& provider, std::shared_
     if (collected_loot.empty())
         return;
 
-
-    //"C:\\Users\\impro\\Desktop\\fall_logs\\test_log.txt"
     std::set<geom::Point2D> deleted_poses;
     try
     {
@@ -673,40 +770,25 @@ void Game::FindGatherEvents(collision_detector::Provider& provider, std::shared_
                 if (dog_gatherer->GetLoot().size() < map->GetBagCapacity())
                 {
                     dog_gatherer->AddLootElem(index_loot.second);
-
-                    std::fstream out;
-                    if (!out.is_open())
-                    {
-                        out.open("/tmp/volume/log.txt", std::ios::out | std::ios::app);
-                    }
-
-                    out << "START DELETE REQUIREDLOOTBYINDX" << std::endl;
                     map->DeleteRequiredLootByIndx(index_loot.first);
                     deleted_poses.insert(pos);
-                    out << "END DELETE REQUIREDLOOTBYINDX" << std::endl;
                 }
             }
-            else
+            else if (!dog_gatherer->GetLoot().empty())
+            {
                 dog_gatherer->DropLoot();
+                scored_dogs_.push_back(dog_gatherer->GetObjectId());
+            }
         }
     }
     catch (std::exception& ex)
     {
-        std::fstream out;
-        if (!out.is_open())
-        {
-            out.open("/tmp/volume/log.txt", std::ios::out | std::ios::app);
-        }
-        out << "OOPS, EXCEPTION" << std::endl;
-        out << ex.what() << std::endl;
-    }
-
-    std::fstream out;
-    if (!out.is_open())
-    {
-        out.open("/tmp/volume/log.txt", std::ios::out | std::ios::app);
+        // Тик не прерывается: остальные карты должны обновиться
+        BOOST_LOG_TRIVIAL(error) << boost::log::add_value(data, boost::json::object{
+            {"message", "gather events failed"},
+            {"data", boost::json::object{ {"map", *map->GetId()}, {"error", ex.what()} }}
+            });
     }
-    out << "END OF CYCLE OF LOOT_EVENT" << std::endl;
 }
 
 }  // namespace model
\ No newline at end of file
@@ -7,6 +7,9 @@
 #include <random>
 #include <iostream>
 #include <chrono>
+#include <utility>
+#include <optional>
+#include <algorithm>
 
 #include "collision_detector.h"
 #include "loot_generator.h"
@@ -15,6 +18,10 @@
 //#include "model_serialization.h"
 using namespace std::chrono_literals;
 
+namespace tick_profile {
+class TickProfiler;
+}  // namespace tick_profile
+
 namespace model {
 
 constexpr double ITEM_WIDTH = 0.0;
@@ -69,6 +76,16 @@ struct DogSpeed
     double speed_y;
 };
 
+// Лут, созданный генератором на тике. Генератор случаен, поэтому журнал команд записывает его результат
+struct LootSpawn
+{
+    std::string map_id;
+    int id;
+    int type;
+    LootCoord coord;
+    int value;
+};
+
 class Road {
 private:
     struct HorizontalTag {
@@ -164,6 +181,10 @@ public:
         ++generation_id_;
         object_id_ = generation_id_;
     }
+    // Восстановленный лут с сохранённым id. Счётчик id не меняется
+    Loot(int object_id, int index, LootCoord coord, int value) : object_id_(object_id), index_(index), coord_(coord), value_(value)
+    {
+    }
 
     int GetId() const
     {
@@ -189,6 +210,12 @@ public:
     {
         return generation_id_;
     }
+
+    // Следующий лут получит id больше last_id
+    static void ReserveIds(int last_id)
+    {
+        generation_id_ = std::max(generation_id_, last_id);
+    }
 private:
     static inline int generation_id_ = -1;
     int object_id_;
@@ -224,22 +251,12 @@ public:
     const std::unique_ptr<loot_gen::LootGenerator>* GetLootGenerator() const;
     void SetBagCapacity(int capacity);
     int GetBagCapacity() const;
+    // Случайные точки и типы лута карты берутся из одного генератора. С тем же зерном повторяются те же значения
+    void SeedRandom(uint64_t seed);
 
     void AddLoot(std::shared_ptr<Loot> ptr_loot)
     {
-        std::vector <std::shared_ptr<Loot>> t;
-        t.resize(all_loot_.size() + 1);
-
-        for (size_t i = 0; i < t.size(); ++i)
-        {
-            if (i == all_loot_.size())
-            {
-                t[i] = ptr_loot;
-                break;
-            }
-            t[i] = all_loot_[i];
-        }
-        all_loot_ = std::move(t);
+        all_loot_.push_back(std::move(ptr_loot));
     }
 
     const std::vector<std::shared_ptr<Loot>>& GetMapLoot() const
@@ -269,27 +286,10 @@ public:
         throw std::logic_error("Can't get right loot by pos");
     }
 
+    // Порядок остального лута сохраняется
     void DeleteRequiredLootByIndx(size_t indx)
     {
-        std::vector <std::shared_ptr<Loot>> t;
-        t.resize(all_loot_.size() - 1);
-        bool erased_item_has_found = false;
-        for (size_t i = 0; i < all_loot_.size(); ++i)
-        {
-            if (erased_item_has_found)
-            {
-                t[i - 1] = all_loot_[i];
-                continue;
-            }
-            if (i == indx)
-            {
-                erased_item_has_found = true;
-                continue;
-            }
-
-            t[i] = all_loot_[i];
-        }
-        all_loot_ = std::move(t);
+        all_loot_.erase(all_loot_.begin() + indx);
     }
 
 private:
@@ -306,6 +306,7 @@ private:
     std::unique_ptr<loot_gen::LootGenerator> loot_gen_;
     std::vector<std::shared_ptr<Loot>> all_loot_; //loot index and coords
     size_t bag_capacity_ = 0;
+    mutable std::mt19937 rng_{ std::random_device{}() };
 
     int GetRandomRoadIndex() const;
     DogCoord GetRandomCoord(const int index) const;
@@ -316,6 +317,8 @@ class Dog
     friend class DogSer;
 public:
     Dog(Direction dir, DogSpeed speed, DogCoord start_pos);
+    // Восстановленная собака с сохранённым id. Счётчик id не меняется
+    Dog(int object_id, Direction dir, DogSpeed speed, DogCoord start_pos);
     const int GetGenerationId() const noexcept;
     const int GetObjectId() const noexcept;
     const DogCoord& GetCoords() const noexcept;
@@ -338,6 +341,8 @@ public:
 
     void ClearIdleTime()
     {
+        if (idle_time_ != 0ms)
+            ++version_;
         idle_time_ = 0ms;
     }
 
@@ -346,6 +351,18 @@ public:
         return idle_time_;
     }
 
+    // Растёт при каждом изменении собаки, кроме накопления простоя: по нему контрольная точка находит изменённых собак
+    uint64_t GetVersion() const noexcept
+    {
+        return version_;
+    }
+
+    // Следующая собака получит id больше last_id
+    static void ReserveIds(int last_id)
+    {
+        generation_id_ = std::max(generation_id_, last_id);
+    }
+
 private:
     Direction dir_;
     static inline int generation_id_ = -1;
@@ -356,6 +373,7 @@ private:
     DogSpeed default_speed_{ 0, 0 };
     std::vector<std::shared_ptr<Loot>> bag_;
     std::chrono::milliseconds idle_time_;
+    uint64_t version_ = 0;
 };
 
 class GameSession
@@ -373,6 +391,12 @@ public:
         dogs_.insert({id, dog_ptr});
     }
 
+    // Место под count собак, чтобы массовое восстановление не перестраивало таблицу
+    void ReserveDogs(size_t count)
+    {
+        dogs_.reserve(count);
+    }
+
     const int& GetGenerationId() const noexcept 
     {
         return generation_id_;
@@ -424,6 +448,33 @@ public:
     void UpdateGameState(const std::chrono::duration<double, std::milli> deltaTime);
     void SetExtraData(ExtraData);
     const ExtraData& GetExtraData() const;
+    // Зерно генераторов всех карт: карта i получает своё зерно из seed и i
+    void SeedRandom(uint64_t seed);
+    // Хэш собак и лута всех сессий. Не зависит от порядка обхода: совпадает у миров, прошедших одинаковые тики
+    uint64_t GetStateDigest() const;
+    // Время генерации лута, движения и сбора по картам. nullptr - без замеров
+    void SetProfiler(tick_profile::TickProfiler* profiler) noexcept
+    {
+        profiler_ = profiler;
+    }
+
+    // id собак, сдавших трофеи на базу с прошлого вызова
+    std::vector<int> TakeScoredDogs()
+    {
+        return std::exchange(scored_dogs_, {});
+    }
+
+    // Лут, созданный генератором с прошлого вызова
+    std::vector<LootSpawn> TakeSpawnedLoot()
+    {
+        return std::exchange(spawned_loot_, {});
+    }
+
+    // Следующий тик возьмёт лут отсюда вместо генератора: так тик повторяется при восстановлении из журнала
+    void SetReplayLoot(std::vector<LootSpawn> loot)
+    {
+        replay_loot_ = std::move(loot);
+    }
 
     void SetRetirementTime(std::chrono::milliseconds dog_retirement_time)
     {
@@ -506,6 +557,10 @@ private:
 
     ExtraData data_;
     std::chrono::milliseconds dog_retirement_time_;
+    std::vector<int> scored_dogs_;
+    std::vector<LootSpawn> spawned_loot_;
+    std::optional<std::vector<LootSpawn>> replay_loot_;
+    tick_profile::TickProfiler* profiler_ = nullptr;
 };
 
 }  // namespace model
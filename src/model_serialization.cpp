@@ -1,5 +1,7 @@
 #include "model_serialization.h"
 #include "player.h"
+
+#include <algorithm>
 //LootSer
 	model::LootSer::LootSer::LootSer() = default;
 	model::LootSer::LootSer(const model::Loot& loot) :
@@ -10,12 +12,45 @@
 		generation_id_(loot.GetGenerationId())
 	{}
 
-	std::shared_ptr<model::Loot> model::LootSer::Restore() const
+	model::LootSer::LootSer(const save::FlatLoot& loot) :
+		generation_id_(loot.generation_id),
+		object_id_(loot.object_id),
+		index_(loot.type),
+		coord_{ loot.x, loot.y },
+		value_(loot.value)
+	{}
+
+	void model::IdCounters::Merge(const IdCounters& other)
+	{
+		loot = std::max(loot, other.loot);
+		dog = std::max(dog, other.dog);
+		player = std::max(player, other.player);
+	}
+
+	void model::IdCounters::Reserve() const
+	{
+		model::Loot::ReserveIds(loot);
+		model::Dog::ReserveIds(dog);
+		Player::ReserveIds(player);
+	}
+
+	std::shared_ptr<model::Loot> model::LootSer::Restore(IdCounters& ids) const
 	{
-		std::shared_ptr<model::Loot> l_ptr = std::make_shared<model::Loot>(index_, coord_, value_);
-		l_ptr->generation_id_ = generation_id_;
-		l_ptr->object_id_ = object_id_;
-		return l_ptr;
+		ids.loot = std::max(ids.loot, generation_id_);
+		return std::make_shared<model::Loot>(object_id_, index_, coord_, value_);
+	}
+
+	save::FlatLoot model::LootSer::ToFlat(uint32_t map) const
+	{
+		save::FlatLoot loot;
+		loot.map = map;
+		loot.generation_id = generation_id_;
+		loot.object_id = object_id_;
+		loot.type = index_;
+		loot.value = value_;
+		loot.x = coord_.x;
+		loot.y = coord_.y;
+		return loot;
 	}
 
 	model::DogSer::DogSer() = default;
@@ -35,24 +70,70 @@
 		}
 	}
 
+	model::DogSer::DogSer(const save::FlatDog& dog, std::span<const save::FlatLoot> bag)
+		: dir_(static_cast<Direction>(dog.dir)),
+		generation_id_(dog.generation_id),
+		object_id_(dog.object_id),
+		score_(dog.score),
+		coords_{ dog.x, dog.y },
+		speed_{ dog.speed_x, dog.speed_y },
+		default_speed_{ dog.default_speed_x, dog.default_speed_y },
+		idle_time_(dog.idle_time)
+	{
+		bag_.reserve(bag.size());
+		for (const auto& l : bag)
+			bag_.emplace_back(l);
+	}
+
 //DogSer
-	[[nodiscard]] std::shared_ptr<model::Dog> model::DogSer::Restore() const {
-		std::shared_ptr<model::Dog> dog = std::make_shared<model::Dog>(dir_, default_speed_, coords_);
-		dog->generation_id_ = generation_id_;
-		dog->object_id_ = object_id_;
+	[[nodiscard]] std::shared_ptr<model::Dog> model::DogSer::Restore(IdCounters& ids) const {
+		ids.dog = std::max(ids.dog, generation_id_);
+		std::shared_ptr<model::Dog> dog = std::make_shared<model::Dog>(object_id_, dir_, default_speed_, coords_);
 		dog->score_ = score_;
 		dog->speed_ = speed_;
 		dog->idle_time_ = std::chrono::duration<int64_t, std::milli>(idle_time_);
 
 		std::vector<std::shared_ptr<model::Loot>> bag;
+		bag.reserve(bag_.size());
 		for (const auto& l : bag_)
 		{
-			bag.push_back(l.Restore());
+			bag.push_back(l.Restore(ids));
 		}
 		dog->bag_ = std::move(bag);
 		return dog;
 	}
 
+	void model::DogSer::AddElapsed(int64_t elapsed_ms)
+	{
+		if (speed_.speed_x == 0 && speed_.speed_y == 0)
+			idle_time_ += elapsed_ms;
+	}
+
+	save::FlatDog model::DogSer::ToFlat(uint32_t map, save::FlatWriter& writer) const
+	{
+		save::FlatDog dog;
+		dog.map = map;
+		dog.generation_id = generation_id_;
+		dog.object_id = object_id_;
+		dog.score = score_;
+		dog.dir = static_cast<uint8_t>(dir_);
+		dog.idle_time = idle_time_;
+		dog.x = coords_.x;
+		dog.y = coords_.y;
+		dog.speed_x = speed_.speed_x;
+		dog.speed_y = speed_.speed_y;
+		dog.default_speed_x = default_speed_.speed_x;
+		dog.default_speed_y = default_speed_.speed_y;
+		dog.bag_count = static_cast<uint32_t>(bag_.size());
+		for (size_t i = 0; i < bag_.size(); ++i)
+		{
+			uint64_t item = writer.AddBagItem(bag_[i].ToFlat(map));
+			if (i == 0)
+				dog.bag_begin = item;
+		}
+		return dog;
+	}
+
 //PlayerSer
 	model::PlayerSer::PlayerSer() = default;
 	model::PlayerSer::PlayerSer(Player& player)
@@ -65,12 +146,39 @@
 		play_time_(player.GetPlayTime().count())
 	{}
 
-	std::shared_ptr<Player> model::PlayerSer::Restore(std::shared_ptr<model::GameSession> s, std::shared_ptr<model::Dog> d)
+	model::PlayerSer::PlayerSer(const save::FlatPlayer& player, const save::FlatView& view)
+		:
+		generation_id_(player.generation_id),
+		object_id_(player.object_id),
+		dog_id(player.dog_id),
+		token_(view.GetString(player.token)),
+		player_name_(view.GetString(player.name)),
+		play_time_(player.play_time)
+	{}
+
+	std::shared_ptr<Player> model::PlayerSer::Restore(std::shared_ptr<model::GameSession> s, std::shared_ptr<model::Dog> d, IdCounters& ids) const
 	{
-		std::shared_ptr<Player> p_ptr = std::make_shared<Player>(s, d, player_name_);
-		p_ptr->generation_id_ = generation_id_;
-		p_ptr->object_id_ = object_id_;
+		ids.player = std::max(ids.player, generation_id_);
+		std::shared_ptr<Player> p_ptr = std::make_shared<Player>(object_id_, std::move(s), std::move(d), player_name_);
 		p_ptr->token_ = token_;
 		p_ptr->play_time_ = std::chrono::duration<int64_t, std::milli>(play_time_);
 		return p_ptr;
 	}
+
+	void model::PlayerSer::AddElapsed(int64_t elapsed_ms)
+	{
+		play_time_ += elapsed_ms;
+	}
+
+	save::FlatPlayer model::PlayerSer::ToFlat(uint32_t map, save::FlatWriter& writer) const
+	{
+		save::FlatPlayer player;
+		player.map = map;
+		player.generation_id = generation_id_;
+		player.object_id = object_id_;
+		player.dog_id = dog_id;
+		player.token = writer.AddString(token_);
+		player.name = writer.AddString(player_name_);
+		player.play_time = play_time_;
+		return player;
+	}
@@ -8,6 +8,9 @@
 #include <boost/serialization/unordered_map.hpp>
 
 #include "model.h"
+#include "save_format.h"
+
+#include <span>
 
 class Player;
 
@@ -61,12 +64,31 @@ namespace model
 		ar& ds.speed_y;
 	}
 
+	//    id. Restore     , 
+	//      ,     
+	struct IdCounters
+	{
+		int loot = -1;
+		int dog = -1;
+		int player = -1;
+
+		void Merge(const IdCounters& other);
+		//    id  
+		void Reserve() const;
+	};
+
 	class LootSer
 	{
 	public:
 		LootSer();
 		explicit LootSer(const model::Loot& loot);
-		std::shared_ptr<model::Loot> Restore() const;
+		explicit LootSer(const save::FlatLoot& loot);
+		std::shared_ptr<model::Loot> Restore(IdCounters& ids) const;
+		save::FlatLoot ToFlat(uint32_t map) const;
+		int GetId() const
+		{
+			return object_id_;
+		}
 
 		template <typename Archive>
 		void serialize(Archive& ar, [[maybe_unused]] const unsigned version) {
@@ -89,7 +111,12 @@ namespace model
 	public:
 		DogSer();
 		explicit DogSer(const model::Dog& dog);
-		[[nodiscard]] std::shared_ptr<model::Dog> Restore() const;
+		DogSer(const save::FlatDog& dog, std::span<const save::FlatLoot> bag);
+		[[nodiscard]] std::shared_ptr<model::Dog> Restore(IdCounters& ids) const;
+		//      writer
+		save::FlatDog ToFlat(uint32_t map, save::FlatWriter& writer) const;
+		//      ,   
+		void AddElapsed(int64_t elapsed_ms);
 
 		template <typename Archive>
 		void serialize(Archive& ar, [[maybe_unused]] const unsigned version) {
@@ -121,7 +148,11 @@ namespace model
 	public:
 		PlayerSer();
 		explicit PlayerSer(Player& player);
-		std::shared_ptr<Player> Restore(std::shared_ptr<model::GameSession> s, std::shared_ptr<model::Dog> d);
+		PlayerSer(const save::FlatPlayer& player, const save::FlatView& view);
+		std::shared_ptr<Player> Restore(std::shared_ptr<model::GameSession> s, std::shared_ptr<model::Dog> d, IdCounters& ids) const;
+		save::FlatPlayer ToFlat(uint32_t map, save::FlatWriter& writer) const;
+		//        ,       
+		void AddElapsed(int64_t elapsed_ms);
 
 		template <typename Archive>
 		void serialize(Archive& ar, [[maybe_unused]] const unsigned version) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <chrono>
 
@@ -16,6 +17,12 @@ public:
 		object_id_ = generation_id_;
 	}
 
+	// Восстановленный игрок с сохранённым id. Счётчик id не меняется
+	Player(int object_id, std::shared_ptr<model::GameSession> session, std::shared_ptr<model::Dog> dog, std::string player_name)
+		: object_id_(object_id), session_(std::move(session)), dog_(std::move(dog)), player_name_(std::move(player_name)), play_time_(0)
+	{
+	}
+
 	const int GetObjectId() const noexcept {
 		return object_id_;
 	}
@@ -60,6 +67,12 @@ public:
 		return play_time_;
 	}
 
+	// Следующий игрок получит id больше last_id
+	static void ReserveIds(int last_id)
+	{
+		generation_id_ = std::max(generation_id_, last_id);
+	}
+
 private:
 	static inline int generation_id_ = -1;
 	int object_id_;
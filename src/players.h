@@ -19,6 +19,16 @@ public:
 		session_to_players_[player->GetSession()->GetObjectId()].push_back(player);
 	}
 
+	// Игроки одной сессии разом, при восстановлении мира
+	void AddSessionPlayers(int session_id, const std::vector<std::shared_ptr<Player>>& players)
+	{
+		for (const auto& player : players)
+			players_.emplace(player->GetObjectId(), player);
+
+		auto& in_session = session_to_players_[session_id];
+		in_session.insert(in_session.end(), players.begin(), players.end());
+	}
+
 	const std::map<int, std::shared_ptr<Player>>& GetPlayers() const
 	{
 		return players_;
@@ -62,6 +62,12 @@ namespace token
             token_to_player_[tok] = player;
         }
 
+        //   count ,      
+        void Reserve(size_t count)
+        {
+            token_to_player_.reserve(count);
+        }
+
         void DeletePlayerByToken(Token token)
         {
             auto it = token_to_player_.find(token);
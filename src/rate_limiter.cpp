@@ -0,0 +1,184 @@
+#include "rate_limiter.h"
+
+#include <algorithm>
+#include <charconv>
+#include <optional>
+#include <stdexcept>
+
+namespace rate_limit
+{
+    namespace
+    {
+        constexpr uint64_t TAT_BITS = 48;
+        constexpr uint64_t TAT_MASK = (uint64_t{ 1 } << TAT_BITS) - 1;
+
+        // Перемешивает биты, чтобы и номер шарда, и метка зависели от всего ключа
+        uint64_t Mix(uint64_t x)
+        {
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ULL;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebULL;
+            x ^= x >> 31;
+            return x;
+        }
+
+        uint64_t HashToken(std::string_view token)
+        {
+            return Mix(std::hash<std::string_view>{}(token));
+        }
+
+        uint64_t HashAddress(const boost::asio::ip::address& ip)
+        {
+            if (ip.is_v4())
+                return Mix(ip.to_v4().to_uint());
+            auto bytes = ip.to_v6().to_bytes();
+            return Mix(std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size())));
+        }
+
+        double ParseNumber(std::string_view str, std::string_view source)
+        {
+            double value = 0;
+            auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+            if (str.empty() || ec != std::errc{} || ptr != str.data() + str.size() || value < 0)
+                throw std::runtime_error("Invalid rate limit: "s + std::string(source));
+            return value;
+        }
+    }
+
+    Limit ParseLimit(std::string_view str)
+    {
+        Limit limit;
+        size_t colon = str.find(':');
+        limit.rate = ParseNumber(str.substr(0, colon), str);
+        // Без явного burst разрешаем всплеск в одну секунду
+        limit.burst = colon == std::string_view::npos ? std::max(1.0, limit.rate) : ParseNumber(str.substr(colon + 1), str);
+        if (limit.burst < 1)
+            throw std::runtime_error("Rate limit burst must be at least 1: "s + std::string(str));
+        return limit;
+    }
+
+    RouteLimit ParseRouteLimit(std::string_view str)
+    {
+        size_t eq = str.find('=');
+        if (eq == std::string_view::npos || eq == 0 || str[0] != '/')
+            throw std::runtime_error("Invalid route rate limit, expected /route=rate:burst: "s + std::string(str));
+        return { std::string(str.substr(0, eq)), ParseLimit(str.substr(eq + 1)) };
+    }
+
+    TokenBucketTable::TokenBucketTable(Limit limit, size_t shard_count, Clock::time_point epoch)
+        : limit_(limit)
+        , epoch_(epoch)
+        , emission_interval_(std::max<uint64_t>(1, static_cast<uint64_t>(1e6 / std::max(limit.rate, 1e-6))))
+        , burst_tolerance_(static_cast<uint64_t>(static_cast<double>(emission_interval_) * (std::max(limit.burst, 1.0) - 1)))
+        , shards_(std::max<size_t>(1, shard_count))
+    {
+    }
+
+    Decision TokenBucketTable::TryAcquire(uint64_t key_hash, Clock::time_point now)
+    {
+        if (!limit_.IsEnabled())
+            return {};
+
+        uint64_t now_us = now <= epoch_ ? 0 : static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(now - epoch_).count()) & TAT_MASK;
+        uint64_t tag = key_hash >> TAT_BITS;
+        if (tag == 0)
+            tag = 1;
+        auto& slots = shards_[key_hash % shards_.size()].slots;
+
+        std::atomic<uint64_t>* slot = nullptr;
+        for (auto& candidate : slots)
+        {
+            if (candidate.load(std::memory_order_relaxed) >> TAT_BITS == tag)
+            {
+                slot = &candidate;
+                break;
+            }
+        }
+        // Своего слова нет - занимаем пустое или то, чья корзина уже полна: его состояние ничего не ограничивает
+        for (size_t i = 0; !slot && i < slots.size(); ++i)
+        {
+            uint64_t value = slots[i].load(std::memory_order_relaxed);
+            if ((value & TAT_MASK) <= now_us
+                && slots[i].compare_exchange_strong(value, (tag << TAT_BITS) | now_us, std::memory_order_relaxed))
+                slot = &slots[i];
+        }
+        if (!slot)
+            slot = &slots[tag % slots.size()];
+
+        uint64_t value = slot->load(std::memory_order_relaxed);
+        while (true)
+        {
+            uint64_t tat = std::max(value & TAT_MASK, now_us);
+            if (tat - now_us > burst_tolerance_)
+            {
+                uint64_t wait_us = tat - now_us - burst_tolerance_;
+                return { false, std::chrono::seconds(std::max<uint64_t>(1, (wait_us + 999'999) / 1'000'000)) };
+            }
+            uint64_t updated = (value & ~TAT_MASK) | ((tat + emission_interval_) & TAT_MASK);
+            if (slot->compare_exchange_weak(value, updated, std::memory_order_relaxed))
+                return {};
+        }
+    }
+
+    RateLimiter::RateLimiter(Options options)
+    {
+        Clock::time_point epoch = Clock::now();
+        if (options.per_ip.IsEnabled())
+            ip_buckets_ = std::make_unique<TokenBucketTable>(options.per_ip, options.shard_count, epoch);
+
+        std::sort(options.routes.begin(), options.routes.end(), [](const RouteLimit& lhs, const RouteLimit& rhs) {
+            return lhs.route.size() > rhs.route.size();
+            });
+        for (auto& route_limit : options.routes)
+            routes_.push_back(std::make_unique<Route>(std::move(route_limit), options.shard_count, epoch));
+    }
+
+    Decision RateLimiter::Check(std::string_view target, std::string_view token, const boost::asio::ip::address& ip,
+        Clock::time_point now)
+    {
+        if (!ip_buckets_ && routes_.empty())
+            return {};
+
+        std::optional<uint64_t> ip_hash;
+        if (ip_buckets_)
+        {
+            ip_hash = HashAddress(ip);
+            if (auto decision = ip_buckets_->TryAcquire(*ip_hash, now); !decision.allowed)
+            {
+                rejected_by_ip_.fetch_add(1, std::memory_order_relaxed);
+                return decision;
+            }
+        }
+
+        Route* route = FindRoute(target);
+        if (!route)
+            return {};
+
+        uint64_t key = token.empty() ? (ip_hash ? *ip_hash : HashAddress(ip)) : HashToken(token);
+        auto decision = route->buckets.TryAcquire(key, now);
+        (decision.allowed ? route->allowed : route->rejected).fetch_add(1, std::memory_order_relaxed);
+        return decision;
+    }
+
+    std::vector<RouteStats> RateLimiter::GetRouteStats() const
+    {
+        std::vector<RouteStats> stats;
+        stats.reserve(routes_.size());
+        for (const auto& route : routes_)
+            stats.push_back({ route->route, route->allowed.load(std::memory_order_relaxed), route->rejected.load(std::memory_order_relaxed) });
+        return stats;
+    }
+
+    RateLimiter::Route* RateLimiter::FindRoute(std::string_view target) const
+    {
+        target = target.substr(0, target.find('?'));
+        for (const auto& route : routes_)
+        {
+            if (target.starts_with(route->route))
+                return route.get();
+        }
+        return nullptr;
+    }
+}
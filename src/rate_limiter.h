@@ -0,0 +1,135 @@
+#pragma once
+#include <boost/asio/ip/address.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rate_limit
+{
+    using namespace std::literals;
+    using Clock = std::chrono::steady_clock;
+
+    // rate - запросов в секунду в среднем, burst - сколько запросов можно сделать подряд после паузы
+    struct Limit
+    {
+        double rate = 0;
+        double burst = 1;
+
+        bool IsEnabled() const noexcept
+        {
+            return rate > 0;
+        }
+    };
+
+    // Лимит для запросов, target которых начинается с route
+    struct RouteLimit
+    {
+        std::string route;
+        Limit limit;
+    };
+
+    // "rate" или "rate:burst"
+    Limit ParseLimit(std::string_view str);
+    // "route=rate" или "route=rate:burst"
+    RouteLimit ParseRouteLimit(std::string_view str);
+
+    struct Decision
+    {
+        bool allowed = true;
+        // Через сколько секунд в корзине появится токен
+        std::chrono::seconds retry_after{ 0 };
+    };
+
+    // Таблица корзин токенов без блокировок. Корзина хранится в одном 64-битном слове по алгоритму GCRA:
+    // 16 бит - метка ключа, 48 бит - "теоретическое время прибытия" следующего запроса в микросекундах.
+    // Ключ попадает в шард из 8 слов размером в кэш-линию, поэтому потоки с разными ключами не мешают друг другу.
+    // Если в шарде нет свободного слова, ключи делят одно слово - такой клиент ограничивается строже, но не пропускается.
+    class TokenBucketTable
+    {
+    public:
+        TokenBucketTable(Limit limit, size_t shard_count, Clock::time_point epoch = Clock::now());
+
+        Decision TryAcquire(uint64_t key_hash, Clock::time_point now);
+
+        const Limit& GetLimit() const noexcept
+        {
+            return limit_;
+        }
+
+    private:
+        static constexpr size_t SLOTS_PER_SHARD = 8;
+
+        struct alignas(64) Shard
+        {
+            std::array<std::atomic<uint64_t>, SLOTS_PER_SHARD> slots{};
+        };
+
+        Limit limit_;
+        Clock::time_point epoch_;
+        // Интервал между запросами и допустимое опережение, в микросекундах
+        uint64_t emission_interval_;
+        uint64_t burst_tolerance_;
+        std::vector<Shard> shards_;
+    };
+
+    struct Options
+    {
+        std::vector<RouteLimit> routes;
+        // Общий лимит на все API-запросы с одного адреса
+        Limit per_ip;
+        // Число шардов в каждой таблице корзин
+        size_t shard_count = 1024;
+    };
+
+    struct RouteStats
+    {
+        std::string route;
+        uint64_t allowed = 0;
+        uint64_t rejected = 0;
+    };
+
+    // Проверяет запрос до постановки в api_strand: сначала лимит адреса, затем лимит маршрута.
+    // Лимит маршрута считается по токену, а для запросов без токена - по адресу
+    class RateLimiter
+    {
+    public:
+        explicit RateLimiter(Options options);
+        RateLimiter(const RateLimiter&) = delete;
+        RateLimiter& operator=(const RateLimiter&) = delete;
+
+        Decision Check(std::string_view target, std::string_view token, const boost::asio::ip::address& ip,
+            Clock::time_point now = Clock::now());
+
+        uint64_t GetRejectedByIp() const noexcept
+        {
+            return rejected_by_ip_.load(std::memory_order_relaxed);
+        }
+
+        std::vector<RouteStats> GetRouteStats() const;
+
+    private:
+        struct Route
+        {
+            Route(RouteLimit route_limit, size_t shard_count, Clock::time_point epoch)
+                : route(std::move(route_limit.route)), buckets(route_limit.limit, shard_count, epoch) {}
+
+            std::string route;
+            TokenBucketTable buckets;
+            std::atomic<uint64_t> allowed{ 0 };
+            std::atomic<uint64_t> rejected{ 0 };
+        };
+
+        std::unique_ptr<TokenBucketTable> ip_buckets_;
+        // Отсортированы по убыванию длины, чтобы первым совпадал самый точный маршрут
+        std::vector<std::unique_ptr<Route>> routes_;
+        std::atomic<uint64_t> rejected_by_ip_{ 0 };
+
+        Route* FindRoute(std::string_view target) const;
+    };
+}
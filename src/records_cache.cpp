@@ -0,0 +1,121 @@
+#include "records_cache.h"
+
+#include <algorithm>
+#include <charconv>
+#include <tuple>
+
+namespace records
+{
+    namespace
+    {
+        constexpr char HEX[] = "0123456789abcdef";
+
+        std::optional<int64_t> ParseInt(std::string_view str)
+        {
+            int64_t value = 0;
+            auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+            if (str.empty() || ec != std::errc{} || ptr != str.data() + str.size())
+                return std::nullopt;
+            return value;
+        }
+    }
+
+    bool IsRankedHigher(const storage::RetiredPlayer& lhs, const storage::RetiredPlayer& rhs)
+    {
+        return std::tie(rhs.score, lhs.play_time_ms, lhs.name, lhs.id) < std::tie(lhs.score, rhs.play_time_ms, rhs.name, rhs.id);
+    }
+
+    std::string EncodeCursor(const storage::RetiredPlayer& last)
+    {
+        // score:play_time:id:name в hex - курсор не требует экранирования в URL
+        std::string key = std::to_string(last.score) + ':' + std::to_string(last.play_time_ms) + ':' + last.id + ':' + last.name;
+        std::string cursor;
+        cursor.reserve(key.size() * 2);
+        for (unsigned char c : key)
+        {
+            cursor.push_back(HEX[c >> 4]);
+            cursor.push_back(HEX[c & 0xF]);
+        }
+        return cursor;
+    }
+
+    std::optional<storage::RetiredPlayer> DecodeCursor(std::string_view cursor)
+    {
+        if (cursor.size() % 2 != 0)
+            return std::nullopt;
+
+        std::string key;
+        key.reserve(cursor.size() / 2);
+        for (size_t i = 0; i < cursor.size(); i += 2)
+        {
+            unsigned value = 0;
+            auto [ptr, ec] = std::from_chars(cursor.data() + i, cursor.data() + i + 2, value, 16);
+            if (ec != std::errc{} || ptr != cursor.data() + i + 2)
+                return std::nullopt;
+            key.push_back(static_cast<char>(value));
+        }
+
+        std::string_view rest = key;
+        std::string_view parts[3];
+        for (auto& part : parts)
+        {
+            size_t colon = rest.find(':');
+            if (colon == std::string_view::npos)
+                return std::nullopt;
+            part = rest.substr(0, colon);
+            rest.remove_prefix(colon + 1);
+        }
+
+        auto score = ParseInt(parts[0]);
+        auto play_time = ParseInt(parts[1]);
+        // id - UUID в текстовом виде, его проверит Postgres, здесь достаточно длины
+        if (!score || !play_time || parts[2].size() != 36)
+            return std::nullopt;
+        return storage::RetiredPlayer{ std::string(parts[2]), std::string(rest), static_cast<int>(*score), *play_time };
+    }
+
+    void RecordsCache::Reset(std::vector<storage::RetiredPlayer> rows)
+    {
+        std::sort(rows.begin(), rows.end(), IsRankedHigher);
+        std::unique_lock lock{ mutex_ };
+        complete_ = rows.size() < capacity_;
+        if (rows.size() > capacity_)
+            rows.resize(capacity_);
+        rows_ = std::move(rows);
+    }
+
+    void RecordsCache::Add(const std::vector<storage::RetiredPlayer>& players)
+    {
+        std::unique_lock lock{ mutex_ };
+        for (const auto& player : players)
+        {
+            auto it = std::upper_bound(rows_.begin(), rows_.end(), player, IsRankedHigher);
+            if (it == rows_.end() && rows_.size() >= capacity_)
+            {
+                // В первые capacity строк игрок не попал, он есть только в БД
+                complete_ = false;
+                continue;
+            }
+            rows_.insert(it, player);
+            if (rows_.size() > capacity_)
+            {
+                rows_.pop_back();
+                complete_ = false;
+            }
+        }
+    }
+
+    std::optional<std::vector<storage::RetiredPlayer>> RecordsCache::TryGetPage(const storage::RetiredPlayer* after, size_t offset, size_t limit) const
+    {
+        std::shared_lock lock{ mutex_ };
+        size_t begin = after
+            ? static_cast<size_t>(std::upper_bound(rows_.begin(), rows_.end(), *after, IsRankedHigher) - rows_.begin())
+            : offset;
+        if (!complete_ && (begin > rows_.size() || rows_.size() - begin < limit))
+            return std::nullopt;
+
+        begin = std::min(begin, rows_.size());
+        size_t end = std::min(rows_.size(), begin + limit);
+        return std::vector<storage::RetiredPlayer>(rows_.begin() + begin, rows_.begin() + end);
+    }
+}
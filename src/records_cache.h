@@ -0,0 +1,56 @@
+#pragma once
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "records_storage.h"
+
+namespace records
+{
+    // Порядок зала славы: больше очков, меньше время игры, имя и id побайтово - как в retired_players_rank_idx
+    bool IsRankedHigher(const storage::RetiredPlayer& lhs, const storage::RetiredPlayer& rhs);
+
+    // Курсор - закодированный ключ последней строки страницы. Клиент передаёт его без изменений
+    std::string EncodeCursor(const storage::RetiredPlayer& last);
+    // nullopt, если курсор повреждён
+    std::optional<storage::RetiredPlayer> DecodeCursor(std::string_view cursor);
+
+    struct RecordsPage
+    {
+        std::vector<storage::RetiredPlayer> rows;
+        // Пустой, если страница последняя
+        std::string next_cursor;
+    };
+
+    // Первые capacity строк зала славы в памяти. Загружается из БД при старте и дополняется
+    // при уходе игроков, поэтому первые страницы /records не обращаются к БД
+    class RecordsCache
+    {
+    public:
+        explicit RecordsCache(size_t capacity) : capacity_(capacity) {}
+        RecordsCache(const RecordsCache&) = delete;
+        RecordsCache& operator=(const RecordsCache&) = delete;
+
+        // rows - первые строки таблицы в порядке зала славы, не больше capacity
+        void Reset(std::vector<storage::RetiredPlayer> rows);
+        void Add(const std::vector<storage::RetiredPlayer>& players);
+
+        // Страница после after (или со смещения offset), если она целиком есть в кэше
+        std::optional<std::vector<storage::RetiredPlayer>> TryGetPage(const storage::RetiredPlayer* after, size_t offset, size_t limit) const;
+
+        size_t GetCapacity() const noexcept
+        {
+            return capacity_;
+        }
+
+    private:
+        size_t capacity_;
+        mutable std::shared_mutex mutex_;
+        std::vector<storage::RetiredPlayer> rows_;
+        // Кэш содержит всю таблицу: страницы за его концом пусты, а не лежат в БД
+        bool complete_ = true;
+    };
+}
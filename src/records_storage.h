@@ -0,0 +1,33 @@
+#pragma once
+#include <boost/json/object.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace storage
+{
+    // Результат ушедшего игрока. Копируется из Player, потому что сам Player удаляется сразу после ухода
+    struct RetiredPlayer
+    {
+        // UUID в текстовом виде. Пустой - сгенерируется при записи
+        std::string id;
+        std::string name;
+        int score = 0;
+        int64_t play_time_ms = 0;
+    };
+
+    // Хранилище зала славы. Порядок страниц: больше очков, меньше время игры, имя побайтово, id.
+    // Запись вызывается из потока RetirementWriter, чтение - из пула БД, реализации должны это допускать
+    class RecordsStorage
+    {
+    public:
+        virtual ~RecordsStorage() = default;
+
+        virtual void AddRetiredPlayers(const std::vector<RetiredPlayer>& players) = 0;
+        // Строки после after (по ключу порядка) или со смещения offset
+        virtual std::vector<RetiredPlayer> GetRetiredPlayersPage(const RetiredPlayer* after, size_t offset, size_t limit) = 0;
+        // Счётчики для /api/v1/admin/stats
+        virtual boost::json::object GetStats() const = 0;
+    };
+}
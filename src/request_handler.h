@@ -6,6 +6,12 @@
 #include "http_server.h"
 #include "request_handler_api.h"
 #include "request_handler_static.h"
+#include "compression.h"
+#include "admission_control.h"
+#include "rate_limiter.h"
+#include "api_executor.h"
+#include "state_snapshot.h"
+#include "connection_pool.h"
 
 
 namespace http_handler {
@@ -23,22 +29,34 @@ namespace http_handler {
     {
         AllowedRequests() = delete;
         constexpr static std::string_view API = "/api/"sv;
+        constexpr static std::string_view ADMIN = "/api/v1/admin/"sv;
+        constexpr static std::string_view ADMIN_STATS = "/api/v1/admin/stats"sv;
+        constexpr static std::string_view ADMIN_TICK_PROFILE = "/api/v1/admin/tick-profile"sv;
     };
 
     class RequestHandler : public std::enable_shared_from_this<RequestHandler> {
     public:
-        explicit RequestHandler(Application& app, fs::path game_data, Strand& api_strand) 
+        // executor разводит запросы по strand симуляции, IO-потокам и пулу БД,
+        // snapshots - снимки состояния для state/players вне strand.
+        // admin_token открывает /api/v1/admin/* не с loopback, пустой - только loopback
+        explicit RequestHandler(Application& app, std::shared_ptr<const static_cache::StaticCache> static_files,
+            api_executor::ApiExecutor& executor, std::shared_ptr<state_snapshot::SnapshotPublisher> snapshots,
+            admission::Options admission_options = {}, rate_limit::Options rate_limit_options = {}, std::string admin_token = {})
             : app_(app), 
               req_api_{ app }, 
-              req_static_{ game_data }, 
-              api_strand_(api_strand) 
+              req_static_{ std::move(static_files) }, 
+              executor_(executor),
+              snapshots_(std::move(snapshots)),
+              admission_(admission_options),
+              rate_limiter_(std::move(rate_limit_options)),
+              admin_token_(std::move(admin_token))
               {}
 
         RequestHandler(const RequestHandler&) = delete;
         RequestHandler& operator=(const RequestHandler&) = delete;
 
         template <typename Body, typename Allocator, typename Send>
-        void operator()(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
+        void operator()(const net::ip::tcp::endpoint& endp, http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
             //Обработать запрос request и отправить ответ, используя send
             std::string request = std::string(req.target());
             auto version = req.version();
@@ -46,19 +64,83 @@ namespace http_handler {
 
                 try
                 {
+                    // Счётчики атомарные, поэтому отвечаем сразу на IO-потоке, не занимая api_strand
+                    if (request.starts_with(AllowedRequests::ADMIN) && !IsAdminAllowed(endp, req[http::field::authorization]))
+                        return send(GetForbiddenResponse(version, keep_alive));
+                    if (request == AllowedRequests::ADMIN_STATS)
+                        return send(GetAdminResponse(req.method(), version, keep_alive, [this] { return CollectAdminStats(); }));
+                    if (request == AllowedRequests::ADMIN_TICK_PROFILE)
+                        return send(GetAdminResponse(req.method(), version, keep_alive, [this] { return app_.GetTickProfiler().MakeJSON(); }));
+
                     if (IsAPIRequest(request))
                     {
-                        auto handle = [self = shared_from_this(), send,
-                            req = std::forward<decltype(req)>(req), version, keep_alive] {
+                        // Лимиты проверяются на IO-потоке: отклонённый запрос не тратит время api_strand
+                        auto limited = rate_limiter_.Check(request, GetBearerToken(req[http::field::authorization]), endp.address());
+                        if (!limited.allowed)
+                            return send(GetTooManyRequestsResponse(limited.retry_after, version, keep_alive));
+
+                        // Запись ушедших игроков в БД отстаёт: новых игроков не принимаем, пока очередь не разберётся
+                        if (request == "/api/v1/game/join"sv && app_.GetRetirementWriter().IsBacklogged())
+                            return send(GetServiceUnavailableResponse(version, keep_alive));
+
+                        // state и players читаются из снимка, если он актуален и в нём уже есть игрок,
+                        // иначе выполняются на strand симуляции: только что вошедший игрок не получит отказ по токену
+                        auto work_class = api_executor::GetWorkClass(request);
+                        std::shared_ptr<const state_snapshot::Snapshot> snapshot;
+                        if (work_class == api_executor::WorkClass::READ && IsSnapshotRequest(request))
+                        {
+                            snapshot = snapshots_->GetCurrent();
+                            if (snapshot && !snapshot->Find(GetBearerToken(req[http::field::authorization])))
+                                snapshot = nullptr;
+                            if (!snapshot)
+                                work_class = api_executor::WorkClass::SIMULATION;
+                        }
+
+                        // Решение о допуске принимается до постановки в очередь, отказ стоит дёшево.
+                        // Запросы, меняющие игру, идут в срочную очередь потока симуляции
+                        auto request_class = admission::Classify(request);
+                        auto ticket = admission_.TryAdmit(request_class, work_class == api_executor::WorkClass::SIMULATION);
+                        if (!ticket)
+                            return send(GetServiceUnavailableResponse(version, keep_alive));
+                        auto priority = request_class == admission::RequestClass::CRITICAL
+                            ? api_executor::Priority::URGENT : api_executor::Priority::NORMAL;
+
+                        auto encoding = compression::ChooseEncoding(req[http::field::accept_encoding]);
+                        auto handle = [self = shared_from_this(), send, admitted = std::move(*ticket), work_class, snapshot = std::move(snapshot),
+                            req = std::forward<decltype(req)>(req), version, keep_alive, encoding]() mutable {
+                            admitted.Started();
                             try {
-                                assert(self->api_strand_.running_in_this_thread());
-                                return send(self->req_api_.operator()(req));
+                                auto response = snapshot ? self->req_api_.GetSnapshotResponse(req, *snapshot) : self->req_api_.operator()(req);
+                                if (work_class == api_executor::WorkClass::SIMULATION)
+                                {
+                                    assert(self->executor_.GetSimulationStrand().running_in_this_thread());
+                                    self->snapshots_->Schedule();
+                                }
+                                if (encoding == compression::Encoding::IDENTITY
+                                    || response.body().size() < compression::DYNAMIC_COMPRESSION_THRESHOLD)
+                                    return send(std::move(response));
+
+                                // Сжатие выполняется на одном из IO-потоков, не занимая поток симуляции и пул БД
+                                return net::post(self->executor_.GetReadExecutor(),
+                                    [send, response = std::move(response), encoding]() mutable {
+                                        try {
+                                            compression::CompressResponse(response, encoding);
+                                        }
+                                        catch (...) {
+                                            // Ответ остаётся несжатым, но всё равно отправляется
+                                        }
+                                        send(std::move(response));
+                                    });
+                            }
+                            catch (const ConnectionPool::AcquireTimeout&) {
+                                // БД не успевает: клиент повторит запрос, поток пула БД не висит бесконечно
+                                send(self->GetServiceUnavailableResponse(version, keep_alive));
                             }
                             catch (...) {
                                 send(self->ReportServerError(version, keep_alive));
                             }
                             };
-                        return net::dispatch(api_strand_, handle);
+                        return executor_.Execute(work_class, std::move(handle), priority);
                     }
 
                     return std::visit(
@@ -76,7 +158,11 @@ namespace http_handler {
         http_handler_api::RequestHandlerAPI req_api_;
         http_handler_static::RequestHandlerStatic req_static_;
         Application& app_;
-        Strand& api_strand_;
+        api_executor::ApiExecutor& executor_;
+        std::shared_ptr<state_snapshot::SnapshotPublisher> snapshots_;
+        admission::AdmissionController admission_;
+        rate_limit::RateLimiter rate_limiter_;
+        std::string admin_token_;
 
         http::response<http::string_body> ReportServerError(unsigned int version, bool keep_alive)
         {
@@ -90,9 +176,178 @@ namespace http_handler {
             return response;
         }
 
+        http::response<http::string_body> GetServiceUnavailableResponse(unsigned int version, bool keep_alive)
+        {
+            http::response<http::string_body> response(http::status::service_unavailable, version);
+            response.set(http::field::content_type, ContentType::JSON_APP);
+            response.set(http::field::cache_control, "no-cache"sv);
+            response.set(http::field::retry_after, std::to_string(admission_.GetOptions().retry_after_seconds));
+            response.body() = json::serialize(json_support::GetJSONServiceUnavailable());
+            response.content_length(response.body().size());
+            response.keep_alive(keep_alive);
+            return response;
+        }
+
+        http::response<http::string_body> GetTooManyRequestsResponse(std::chrono::seconds retry_after, unsigned int version, bool keep_alive)
+        {
+            http::response<http::string_body> response(http::status::too_many_requests, version);
+            response.set(http::field::content_type, ContentType::JSON_APP);
+            response.set(http::field::cache_control, "no-cache"sv);
+            response.set(http::field::retry_after, std::to_string(retry_after.count()));
+            response.body() = json::serialize(json_support::GetJSONTooManyRequests());
+            response.content_length(response.body().size());
+            response.keep_alive(keep_alive);
+            return response;
+        }
+
+        static std::string_view GetBearerToken(std::string_view authorization)
+        {
+            constexpr auto prefix = "Bearer "sv;
+            return authorization.starts_with(prefix) ? authorization.substr(prefix.size()) : ""sv;
+        }
+
+        // Статистика раскрывает нагрузку и устройство сервера: с loopback всегда, снаружи - только с admin_token_
+        bool IsAdminAllowed(const net::ip::tcp::endpoint& endp, std::string_view authorization) const
+        {
+            net::ip::address address = endp.address();
+            if (address.is_v6() && address.to_v6().is_v4_mapped())
+                address = net::ip::make_address_v4(net::ip::v4_mapped, address.to_v6());
+            if (address.is_loopback())
+                return true;
+            return !admin_token_.empty() && GetBearerToken(authorization) == admin_token_;
+        }
+
+        http::response<http::string_body> GetForbiddenResponse(unsigned int version, bool keep_alive)
+        {
+            http::response<http::string_body> response(http::status::forbidden, version);
+            response.set(http::field::content_type, ContentType::JSON_APP);
+            response.set(http::field::cache_control, "no-cache"sv);
+            response.body() = json::serialize(json_support::GetJSONForbidden());
+            response.content_length(response.body().size());
+            response.keep_alive(keep_alive);
+            return response;
+        }
+
+        json::object CollectAdminStats() const
+        {
+            const auto& allocations = http_server::GetSessionStats();
+            uint64_t requests = allocations.requests.load(std::memory_order_relaxed);
+            uint64_t upstream_allocations = allocations.upstream_allocations.load(std::memory_order_relaxed);
+
+            json::object stats;
+            stats["sessions"] = json::object{
+                {"opened", allocations.sessions_opened.load(std::memory_order_relaxed)},
+                {"active", allocations.sessions_active.load(std::memory_order_relaxed)},
+                {"rejected", allocations.sessions_rejected.load(std::memory_order_relaxed)},
+                {"timeouts", allocations.timeouts.load(std::memory_order_relaxed)}
+            };
+            stats["requests"] = requests;
+            stats["requestsTooLarge"] = allocations.requests_too_large.load(std::memory_order_relaxed);
+            stats["allocations"] = json::object{
+                {"upstreamAllocations", upstream_allocations},
+                {"upstreamDeallocations", allocations.upstream_deallocations.load(std::memory_order_relaxed)},
+                {"upstreamBytes", allocations.upstream_bytes.load(std::memory_order_relaxed)},
+                {"perRequest", requests == 0 ? 0.0 : static_cast<double>(upstream_allocations) / static_cast<double>(requests)}
+            };
+
+            json::object admission_stats;
+            admission_stats["simulationDepth"] = admission_.GetSimulationDepth();
+            for (auto request_class : { admission::RequestClass::CRITICAL, admission::RequestClass::STATE, admission::RequestClass::READ })
+            {
+                const auto& class_stats = admission_.GetStats(request_class);
+                admission_stats[admission::GetClassName(request_class)] = json::object{
+                    {"admitted", class_stats.admitted.load(std::memory_order_relaxed)},
+                    {"rejected", class_stats.rejected.load(std::memory_order_relaxed)},
+                    {"inFlight", class_stats.in_flight.load(std::memory_order_relaxed)}
+                };
+            }
+            stats["admission"] = std::move(admission_stats);
+
+            json::object executor_stats;
+            for (auto work_class : { api_executor::WorkClass::SIMULATION, api_executor::WorkClass::READ, api_executor::WorkClass::DATABASE })
+                executor_stats[api_executor::GetWorkClassName(work_class)] = executor_.GetSubmitted(work_class);
+            executor_stats["urgent"] = executor_.GetUrgentSubmitted();
+            executor_stats["snapshotsPublished"] = snapshots_->GetPublishedCount();
+            stats["executor"] = std::move(executor_stats);
+
+            const auto& writer = app_.GetRetirementWriter();
+            const auto& retirements = writer.GetStats();
+            stats["retirements"] = json::object{
+                {"pending", writer.GetPending()},
+                {"backlogged", writer.IsBacklogged()},
+                {"written", retirements.written.load(std::memory_order_relaxed)},
+                {"batches", retirements.batches.load(std::memory_order_relaxed)},
+                {"failures", retirements.failures.load(std::memory_order_relaxed)},
+                {"dropped", retirements.dropped.load(std::memory_order_relaxed)}
+            };
+
+            const auto& serializator = app_.GetSerializator();
+            const auto& saves = serializator.GetWriter().GetStats();
+            stats["saves"] = json::object{
+                {"queueDepth", serializator.GetWriter().GetQueueDepth()},
+                {"bases", saves.bases.load(std::memory_order_relaxed)},
+                {"deltas", saves.deltas.load(std::memory_order_relaxed)},
+                {"failures", saves.failures.load(std::memory_order_relaxed)},
+                {"superseded", saves.superseded.load(std::memory_order_relaxed)},
+                {"bytesWritten", saves.bytes_written.load(std::memory_order_relaxed)},
+                {"lastSaveUs", saves.last_save_us.load(std::memory_order_relaxed)},
+                {"maxSaveUs", saves.max_save_us.load(std::memory_order_relaxed)},
+                {"totalSaveUs", saves.total_save_us.load(std::memory_order_relaxed)},
+                {"lastCaptureUs", serializator.GetLastCaptureUs()},
+                {"maxCaptureUs", serializator.GetMaxCaptureUs()}
+            };
+
+            if (const wal::WriteAheadLog* wal = app_.GetWal())
+            {
+                const auto& log = wal->GetStats();
+                stats["wal"] = json::object{
+                    {"pending", wal->GetPending()},
+                    {"records", log.records.load(std::memory_order_relaxed)},
+                    {"bytes", log.bytes.load(std::memory_order_relaxed)},
+                    {"groups", log.groups.load(std::memory_order_relaxed)},
+                    {"maxGroupRecords", log.max_group_records.load(std::memory_order_relaxed)},
+                    {"fsyncs", log.fsyncs.load(std::memory_order_relaxed)},
+                    {"failures", log.failures.load(std::memory_order_relaxed)},
+                    {"segmentsDropped", log.segments_dropped.load(std::memory_order_relaxed)}
+                };
+            }
+
+            stats["storage"] = app_.GetRecordsStorage().GetStats();
+
+            json::object route_limits;
+            for (const auto& route : rate_limiter_.GetRouteStats())
+                route_limits[route.route] = json::object{ {"allowed", route.allowed}, {"rejected", route.rejected} };
+            stats["rateLimit"] = json::object{
+                {"rejectedByIp", rate_limiter_.GetRejectedByIp()},
+                {"routes", std::move(route_limits)}
+            };
+            return stats;
+        }
+
+        template <typename Collect>
+        http::response<http::string_body> GetAdminResponse(http::verb method, unsigned int version, bool keep_alive, Collect&& collect)
+        {
+            bool is_allowed = method == http::verb::get || method == http::verb::head;
+            http::response<http::string_body> response(is_allowed ? http::status::ok : http::status::method_not_allowed, version);
+            response.set(http::field::content_type, ContentType::JSON_APP);
+            response.set(http::field::cache_control, "no-cache"sv);
+            if (is_allowed)
+                response.body() = json::serialize(collect());
+            else
+                response.set(http::field::allow, "GET, HEAD"sv);
+            response.content_length(response.body().size());
+            response.keep_alive(keep_alive);
+            return response;
+        }
+
         bool IsAPIRequest(const std::string& req)
         {
             return req.substr(0, 4) == "/api";
         }
+
+        static bool IsSnapshotRequest(std::string_view target)
+        {
+            return target == "/api/v1/game/state"sv || target == "/api/v1/game/players"sv;
+        }
     };
 } // namespace http_handler
@@ -10,6 +10,8 @@
 #include "json_support.h"
 #include "content_type.h"
 #include "request_handler_game.h"
+#include "maps_cache.h"
+#include "etag.h"
 
 namespace http = boost::beast::http;
 namespace json = boost::json;
@@ -47,14 +49,15 @@ namespace http_handler_api
             {"/api/v1/game/state"sv},
             {"/api/v1/game/player/action"sv},
             {"/api/v1/game/tick"sv},
-            {"/api/v1/game/records"}
+            {"/api/v1/game/records"},
+            {"/api/v1/game/player/rank"sv}
         }
     );
 
 	class RequestHandlerAPI
 	{
 	public:
-        explicit RequestHandlerAPI(Application& app) : app_(app), req_game_(app) {}
+        explicit RequestHandlerAPI(Application& app) : app_(app), req_game_(app), maps_cache_(app.GetGame()) {}
         RequestHandlerAPI(const RequestHandlerAPI&) = delete;
         RequestHandlerAPI& operator=(const RequestHandlerAPI&) = delete;
         
@@ -65,13 +68,22 @@ namespace http_handler_api
                 return req_game_.operator()(std::forward<decltype(req)>(req));
             else if (req.target().substr(0, records_size_no_args) == "/api/v1/game/records")
                 return req_game_.operator()(std::forward<decltype(req)>(req));
+            else if (req.target().substr(0, leaderboard_size_no_args) == "/api/v1/game/leaderboard")
+                return req_game_.operator()(std::forward<decltype(req)>(req));
             else
                 return GetMapAPIResponse(req);
         }
 
+        template <typename Body>
+        StringResponse GetSnapshotResponse(Body&& req, const state_snapshot::Snapshot& snapshot)
+        {
+            return req_game_.GetSnapshotResponse(std::forward<decltype(req)>(req), snapshot);
+        }
+
 	private:
         Application& app_;
         http_handler_game::RequestHandlerGame req_game_;
+        maps_cache::MapsCache maps_cache_;
 
         // API functions returns API requests
         template <typename Body>
@@ -79,14 +91,16 @@ namespace http_handler_api
         {
             if (req.method() != http::verb::get && req.method() != http::verb::head)
                 return GetNotAllowedMethodAPIResponse(req.version());
-            std::string request = std::string(req.target());
+            std::string_view request = req.target();
+            std::string_view if_none_match = req[http::field::if_none_match];
+            compression::Encoding encoding = compression::ChooseEncoding(req[http::field::accept_encoding]);
             if (request == SupportedAPIRequests::ALL_MAPS)
-                return GetAllMapsAPIResponse(req.version(), req.keep_alive());
+                return GetCachedMapAPIResponse(maps_cache_.GetMapsList(), encoding, if_none_match, req.version(), req.keep_alive());
             else if (request.substr(0, required_map_size_request) == SupportedAPIRequests::REQUIRED_MAP)
             {
-                std::string map_id = request.substr(required_map_size_request);
-                if (IsMapFound(map_id))
-                    return GetRequiredMapAPIResponse(map_id, req.version(), req.keep_alive());
+                const maps_cache::CachedDocument* document = maps_cache_.FindMap(request.substr(required_map_size_request));
+                if (document)
+                    return GetCachedMapAPIResponse(*document, encoding, if_none_match, req.version(), req.keep_alive());
                 else
                     return GetMapNotFoundAPIResponse(req.version(), req.keep_alive());
             }
@@ -94,36 +108,26 @@ namespace http_handler_api
                 return GetBadRequestAPIResponse(req.version());
         }
 
-        StringResponse GetAllMapsAPIResponse(const unsigned int version, const bool keep_alive)
-        {
-            json::array JSONMaps = json_support::GetJSONAllMaps(app_.GetGame().GetMaps());
-            std::string body = json_support::GetFormattedJSONStr(JSONMaps);
-
-            http::response<http::string_body> response(http::status::ok, version);
-            std::string_view content_type = ContentType::JSON_APP;
-            response.set(http::field::content_type, content_type);
-            response.set(http::field::cache_control, "no-cache"sv);
-            response.body() = body;
-            response.content_length(body.size());
-            response.keep_alive(keep_alive);
-            return response;
-        }
-
-        StringResponse GetRequiredMapAPIResponse(const std::string_view id, const unsigned int version, const bool keep_alive)
+        // Тело берётся из заранее сериализованного документа, при совпадении ETag отдаём 304 без тела
+        StringResponse GetCachedMapAPIResponse(const maps_cache::CachedDocument& document, compression::Encoding encoding,
+            std::string_view if_none_match, const unsigned int version, const bool keep_alive)
         {
-            json::object JSONMap = 
-                json_support::GetJSONRequiredMap(
-                    app_.GetGame().FindMap(model::Map::Id(std::string(id))), 
-                    app_.GetGame().GetExtraData().GetJSONLootType());
-
-            std::string body = json_support::GetFormattedJSONStr(JSONMap);
+            const maps_cache::Representation& representation = document.Select(encoding);
+            bool not_modified = !if_none_match.empty() && etag::IsNoneMatchSatisfied(if_none_match, representation.etag);
 
-            http::response<http::string_body> response(http::status::ok, version);
+            http::response<http::string_body> response(not_modified ? http::status::not_modified : http::status::ok, version);
             std::string_view content_type = ContentType::JSON_APP;
             response.set(http::field::content_type, content_type);
             response.set(http::field::cache_control, "no-cache"sv);
-            response.body() = body;
-            response.content_length(body.size());
+            response.set(http::field::etag, representation.etag);
+            response.set(http::field::vary, "Accept-Encoding"sv);
+            if (encoding != compression::Encoding::IDENTITY)
+                response.set(http::field::content_encoding, compression::GetEncodingName(encoding));
+            if (!not_modified)
+            {
+                response.body() = *representation.body;
+                response.content_length(representation.body->size());
+            }
             response.keep_alive(keep_alive);
             return response;
         }
@@ -170,12 +174,5 @@ namespace http_handler_api
             response.keep_alive(false);
             return response;
         }
-
-        bool IsMapFound(const std::string_view id)
-        {
-            if (app_.GetGame().FindMap(model::Map::Id(std::string(id))) == nullptr)
-                return false;
-            return true;
-        }
 	};
 }
\ No newline at end of file
@@ -4,16 +4,19 @@
 #include <memory>
 #include <optional>
 #include <boost/url.hpp>
-#include <fstream>
 
 #include "application.h"
 #include "json_loader.h"
 #include "json_support.h"
 #include "content_type.h"
 #include "extra_data.h"
+#include "state_snapshot.h"
 
 
 constexpr int records_size_no_args = 20;
+constexpr int leaderboard_size_no_args = 24;
+// Столбец name в зале славы - varchar(100)
+constexpr size_t max_user_name_size = 100;
 
 namespace http = boost::beast::http;
 namespace json = boost::json;
@@ -26,8 +29,7 @@ namespace http_handler_game
     {
     public:
         explicit RequestHandlerGame(Application& app) : 
-            app_(app),
-            out_("C:\\Users\\impro\\Desktop\\fall_logs\\test_log.txt")
+            app_(app)
         {}
 
         RequestHandlerGame(const RequestHandlerGame&) = delete;
@@ -56,13 +58,40 @@ namespace http_handler_game
                     return GetBadRequestAPIResponse(req.version());
                 return GetRecordsResponse(req.keep_alive(), req.version(), params);
             }
+            else if (target == "/api/v1/game/player/rank")
+                return GetPlayerRankResponse(req);
+            else if (target.substr(0, leaderboard_size_no_args) == "/api/v1/game/leaderboard")
+                return GetLeaderboardResponse(req, target);
             else
                 return GetBadRequestAPIResponse(req.version());
         }
 
+        // state и players по опубликованному снимку, без обращения к модели. Можно вызывать с любого потока
+        template <typename Body>
+        StringResponse GetSnapshotResponse(Body&& req, const state_snapshot::Snapshot& snapshot)
+        {
+            if (req.method() != http::verb::get && req.method() != http::verb::head)
+                return PostNotAllowed(req.keep_alive(), req.version());
+            if (!IsAuthHeaderCorrect(req))
+                return GetUnauthorizedInvalidToken(req.keep_alive(), req.version());
+
+            const state_snapshot::SessionView* view = snapshot.Find(GetToken(req));
+            if (!view)
+                return GetUnauthorizedUnknownToken(req.keep_alive(), req.version());
+
+            const std::string& body = req.target() == "/api/v1/game/state" ? view->state : view->players;
+            http::response<http::string_body> response(http::status::ok, req.version());
+            std::string_view content_type = ContentType::JSON_APP;
+            response.set(http::field::content_type, content_type);
+            response.set(http::field::cache_control, "no-cache"sv);
+            response.body() = body;
+            response.content_length(body.size());
+            response.keep_alive(req.keep_alive());
+            return response;
+        }
+
     private:
         Application& app_;
-        std::fstream out_;
 
         template<typename Body>
         StringResponse GetStateResponse(Body&& req)
@@ -90,6 +119,54 @@ namespace http_handler_game
             return BadAuthorization(correctness.first, req.keep_alive(), req.version());
         }
 
+        template<typename Body>
+        StringResponse GetPlayerRankResponse(Body&& req)
+        {
+            if (req.method() != http::verb::get && req.method() != http::verb::head)
+                return PostNotAllowed(req.keep_alive(), req.version());
+
+            std::pair<std::pair<bool, bool>, bool> correctness = AuthorizationChecks(req);
+            if (!correctness.second)
+                return BadAuthorization(correctness.first, req.keep_alive(), req.version());
+
+            PlayerRank rank = app_.GetPlayerRank(app_.FindPlayerByToken(Token(GetToken(req))));
+            // Места в ответе считаются с единицы
+            json::object body;
+            body["mapId"] = rank.map_id;
+            body["score"] = rank.score;
+            body["liveRank"] = rank.live_rank + 1;
+            body["livePlayers"] = rank.live_players;
+            body["hallOfFameRank"] = rank.hall_of_fame_rank + 1;
+            body["hallOfFamePlayers"] = rank.hall_of_fame_players;
+            return GetJSONResponse(req.keep_alive(), req.version(), json::serialize(body));
+        }
+
+        // /api/v1/game/leaderboard?map=<id>&start=0&maxItems=100 - живые игроки карты по местам
+        template<typename Body>
+        StringResponse GetLeaderboardResponse(Body&& req, std::string_view target)
+        {
+            if (req.method() != http::verb::get && req.method() != http::verb::head)
+                return PostNotAllowed(req.keep_alive(), req.version());
+
+            RecordsParams params = GetParametres(target);
+            if (params.maxItems > 100)
+                return GetBadRequestAPIResponse(req.version());
+
+            urls::url_view base_url(target);
+            auto url_params = base_url.params();
+            auto map_param = url_params.find("map");
+            if (map_param == url_params.end() || !(*map_param).has_value)
+                return GetBadRequestAPIResponse(req.version());
+            std::string map_id = (*map_param).value;
+            if (!IsMapFound(map_id))
+                return GetMapNotFound(req.keep_alive(), req.version());
+
+            std::vector<std::tuple<std::string, int, int>> players;
+            for (const auto& entry : app_.GetLiveLeaderboard(map_id, params.start, params.maxItems))
+                players.emplace_back(entry.name, entry.score, static_cast<int>(entry.play_time_ms));
+            return GetJSONResponse(req.keep_alive(), req.version(), json_support::GetFormattedJSONStr(json_support::MakeJSONRetiredPlayers(players)));
+        }
+
         template<typename Body>
         StringResponse GetActionResponse(Body&& req)
         {
@@ -115,17 +192,7 @@ namespace http_handler_game
                 if (ec)
                     return GetBadJSONInput(req.keep_alive(), req.version());
 
-                std::string is_stop = std::string(data.at("move").as_string());
-
-                player->GetDog()->ClearIdleTime();
-                if (is_stop == "")
-                    player->GetDog()->StopDog();
-                else
-                {
-                    model::Direction move_pattern = static_cast<model::Direction>(is_stop.back());
-                    player->GetDog()->SetInGameDirection(move_pattern);
-                    player->GetDog()->SetInGameSpeed();
-                }
+                app_.MovePlayer(player, std::string(data.at("move").as_string()));
                 return GetActionGame(req.keep_alive(), req.version());
             }
             return BadAuthorization(correctness.first, req.keep_alive(), req.version());
@@ -163,38 +230,10 @@ namespace http_handler_game
 
             std::string userName = std::string(data.as_object().at("userName").as_string());
 
-            std::shared_ptr<model::GameSession> session_ptr_shared;
-            std::shared_ptr<model::Map> map_ptr_shared;
-            bool is_session_exist = app_.GetGame().IsSessionExist(mapId);
-
-            if (is_session_exist)
-            {
-                session_ptr_shared = app_.GetGame().GetSession(mapId);
-                map_ptr_shared = session_ptr_shared->GetMap();
-            }
-            else
-            {
-                map_ptr_shared = app_.GetGame().FindMap(model::Map::Id(mapId));
-                session_ptr_shared = std::make_shared<model::GameSession>(map_ptr_shared);
-            }
-
-            int player_id;
-            std::string token;
-            model::DogCoord start_coords;
-            app_.GetSettings().randomize_spawn_points ? start_coords = map_ptr_shared->GetRandomPosDog() : start_coords = map_ptr_shared->GetStartPosDog();
-            std::shared_ptr<model::Dog> dog_ptr_shared = std::make_shared<model::Dog>(model::Direction::UP, map_ptr_shared->GetDogSpeed(), start_coords);
-            session_ptr_shared->AddDog(dog_ptr_shared);
-            std::shared_ptr<Player>player_shared_ptr = std::make_shared<Player>(session_ptr_shared, dog_ptr_shared, userName);
-            app_.AddPlayer(player_shared_ptr);
-            token = *(app_.SetTokenForPlayer(player_shared_ptr));
-            player_shared_ptr->SetToken(token);
+            std::shared_ptr<Player> player_shared_ptr = app_.JoinGame(mapId, userName);
+            std::string token = player_shared_ptr->GetPlayerToken();
             std::cout << token << std::endl;
-            player_id = player_shared_ptr->GetObjectId();
-
-            if (is_session_exist)
-                app_.GetGame().UpdateSession(session_ptr_shared, mapId);
-            else
-                app_.GetGame().AddSession(session_ptr_shared, mapId);
+            int player_id = player_shared_ptr->GetObjectId();
 
             return GetTokenForClient(keep_alive, version, token, player_id);
         }
@@ -224,37 +263,36 @@ namespace http_handler_game
             if (!data.as_object().at("timeDelta").is_int64())
                 return GetBadJSONInput(req.keep_alive(), req.version());
 
-            if (!out_.is_open())
-            {
-                out_.open("/tmp/volume/log.txt", std::ios::out | std::ios::app);
-            }
-
-            //"/tmp/volume/log.txt"
-            //"C:\\Users\\impro\\Desktop\\fall_logs\\test_log.txt"
-
             int64_t time_value = data.as_object().at("timeDelta").get_int64();
             std::chrono::milliseconds deltaTime(time_value);
-            out_ << "START ON TICK" << std::endl;
-            app_.OnTick(deltaTime);
-            //out_ << "END ON TICK" << std::endl;
-            //out_ << "START DELETE UNUSED INFO" << std::endl;
-            app_.DeleteUnusedInfo(deltaTime);
-            //out_ << "END DELETE UNUSED INFO" << std::endl;
-            //out_ << "START SERIALIZE ON TICK" << std::endl;
-            app_.SerializeOnTick(deltaTime);
-            //out_ << "END SERIALIZE ON TICK" << std::endl;
-            out_.close();
+            app_.Tick(deltaTime);
             return GetGameTick(req.keep_alive(), req.version());
         }
         
         StringResponse GetRecordsResponse(bool keep_alive, unsigned int version, RecordsParams& params)
         {
-            auto retired_players = app_.GetRetiredPlayersInfo(params);
+            records::RecordsPage page;
+            try
+            {
+                page = app_.GetRetiredPlayersInfo(params);
+            }
+            catch (const std::invalid_argument&)
+            {
+                return GetBadRequestAPIResponse(version);
+            }
+
+            std::vector<std::tuple<std::string, int, int>> retired_players;
+            retired_players.reserve(page.rows.size());
+            for (const auto& row : page.rows)
+                retired_players.emplace_back(row.name, row.score, static_cast<int>(row.play_time_ms));
             std::string body = json_support::GetFormattedJSONStr(json_support::MakeJSONRetiredPlayers(retired_players));
             http::response<http::string_body> response(http::status::ok, version);
             std::string_view content_type = ContentType::JSON_APP;
             response.set(http::field::content_type, content_type);
             response.set(http::field::cache_control, "no-cache"sv);
+            // Следующая страница запрашивается с ?cursor=<значение>, без OFFSET в БД
+            if (!page.next_cursor.empty())
+                response.set("X-Records-Cursor"sv, page.next_cursor);
             response.body() = body;
             response.content_length(body.size());
             response.keep_alive(keep_alive);
@@ -276,6 +314,18 @@ namespace http_handler_game
             return response;
         }
 
+        StringResponse GetJSONResponse(bool keep_alive, unsigned int version, std::string body)
+        {
+            http::response<http::string_body> response(http::status::ok, version);
+            std::string_view content_type = ContentType::JSON_APP;
+            response.set(http::field::content_type, content_type);
+            response.set(http::field::cache_control, "no-cache"sv);
+            response.content_length(body.size());
+            response.body() = std::move(body);
+            response.keep_alive(keep_alive);
+            return response;
+        }
+
         StringResponse GetMapNotFound(bool keep_alive, unsigned int version)
         {
             std::string body = json_support::GetFormattedJSONStr(json_support::MakeJSONNotFoundMap());
@@ -498,7 +548,7 @@ namespace http_handler_game
             if (data.as_object().contains("userName"))
             {
                 userName = std::string(data.as_object().at("userName").as_string());
-                return userName.size() != 0;
+                return userName.size() != 0 && userName.size() <= max_user_name_size;
             }
             else
                 return false;
@@ -602,6 +652,9 @@ namespace http_handler_game
                     params.maxItems = static_cast<size_t>(std::stoi(maxItems));
                 }
             }
+
+            if (auto it = p.find("cursor"); it != p.end() && (*it).has_value)
+                params.cursor = std::string((*it).value);
             return params;
         }
     };
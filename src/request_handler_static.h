@@ -3,8 +3,14 @@
 #include <string_view>
 #include <filesystem>
 #include <variant>
+#include <fstream>
+#include <memory>
+#include <sstream>
 
 #include "content_type.h"
+#include "compression.h"
+#include "etag.h"
+#include "static_cache.h"
 
 int constexpr hex_size = 2;
 
@@ -18,36 +24,12 @@ namespace http_handler_static
     using StringResponse = http::response<http::string_body>;
     using FileResponse = http::response<http::file_body>;
     using FileResponseResult = std::variant<StringResponse, FileResponse>;
-
-    const std::unordered_map<std::string, std::string_view> supported_extensions = {
-        { ".json", ContentType::TEXT_JSON },
-        { ".htm",  ContentType::TEXT_HTML },
-        { ".html",  ContentType::TEXT_HTML },
-        { ".css",  ContentType::TEXT_CSS },
-        { ".txt",  ContentType::TEXT_TXT },
-        { ".js",  ContentType::TEXT_JS },
-        { ".xml",  ContentType::TEXT_XML },
-        { ".png",  ContentType::TEXT_PNG },
-        { ".jpg",  ContentType::TEXT_JPG },
-        { ".jpe",  ContentType::TEXT_JPG },
-        { ".jpeg",  ContentType::TEXT_JPG },
-        { ".gif",  ContentType::TEXT_GIF },
-        { ".bmp",  ContentType::TEXT_BMP },
-        { ".ico",  ContentType::TEXT_ICO },
-        { ".tiff",  ContentType::TEXT_TIF },
-        { ".tif",  ContentType::TEXT_TIF },
-        { ".svg",  ContentType::TEXT_SVG },
-        { ".svgz",  ContentType::TEXT_SVG },
-        { ".mp3",  ContentType::TEXT_MP3 },
-        { ".fbx", ContentType::TEXT_UNKNOWN },
-        { ".obj", ContentType::TEXT_UNKNOWN},
-        { ".webmanifest", ContentType::TEXT_UNKNOWN}
-    };
+    using static_cache::supported_extensions;
 
     class RequestHandlerStatic
     {
     public:
-        explicit RequestHandlerStatic(fs::path game_data) : game_data_(game_data) {}
+        explicit RequestHandlerStatic(std::shared_ptr<const static_cache::StaticCache> cache) : cache_(std::move(cache)) {}
         RequestHandlerStatic(const RequestHandlerStatic&) = delete;
         RequestHandlerStatic& operator=(const RequestHandlerStatic&) = delete;
 
@@ -58,38 +40,112 @@ namespace http_handler_static
         }
 
     private:
-        fs::path game_data_;
+        std::shared_ptr<const static_cache::StaticCache> cache_;
 
         template <typename Body>
         FileResponseResult GetStaticResponse(Body&& req)
         {
-            std::string request = std::string(req.target());
-            std::string decoded_uri = URIDecoding(request);
-            fs::path request_path = game_data_.string() + decoded_uri;
-            bool is_correct = IsCorrectPath(request_path, game_data_);
+            std::string_view target = req.target();
+            target = target.substr(0, target.find('?'));
+            std::string decoded_uri = URIDecoding(std::string(target));
+
+            auto normalized = static_cache::NormalizePath(decoded_uri);
+            if (!normalized)
+                return GetBadRequestStaticDataResponse(req.version(), req.keep_alive());
+            if (*normalized == "/"sv)
+                *normalized = "/index.html"s;
 
-            if (request == "/"s)
+            auto asset = cache_->Find(*normalized);
+            if (!asset)
             {
-                fs::path request_path = game_data_.string() + "/index.html";
-                fs::path ext = ".html";
-                return GetFileStaticDataResponse(request_path, ext);
+                if (!supported_extensions.contains(fs::path(*normalized).extension().string()))
+                    return GetWrongExtensionStaticDataResponse(req.version(), req.keep_alive());
+                return GetNotFoundStaticDataResponse(req.version(), req.keep_alive());
             }
-            else if (is_correct)
-            {
-                auto extension = request_path.extension();
 
-                if (!supported_extensions.contains(extension.string()))
-                    return GetWrongExtensionStaticDataResponse(req.version(), req.keep_alive());
-                else
+            if (IsNotModified(req, *asset))
+                return GetNotModifiedStaticDataResponse(*asset, req.version(), req.keep_alive());
+
+            // If-Range:  ,        
+            auto if_range = req[http::field::if_range];
+            if (req.count(http::field::range) && (if_range.empty() || if_range == asset->etag || if_range == asset->last_modified))
+            {
+                static_cache::ByteRange range;
+                switch (static_cache::ParseRange(req[http::field::range], asset->size, range))
                 {
-                    if (fs::exists(request_path))
-                        return GetFileStaticDataResponse(request_path, extension);
-                    else
-                        return GetNotFoundStaticDataResponse(req.version(), req.keep_alive());
+                case static_cache::RangeStatus::UNSATISFIABLE:
+                    return GetRangeNotSatisfiableResponse(*asset, req.version(), req.keep_alive());
+                case static_cache::RangeStatus::SATISFIABLE:
+#ifdef __linux__
+                    //        sendfile,     IO-
+                    if (!asset->body)
+                        return GetPartialFileStaticDataResponse(*asset, range, req.version(), req.keep_alive());
+#else
+                    //      ,      
+                    if (!asset->body && range.last - range.first >= cache_->GetOptions().max_in_memory_file_size)
+                        break;
+#endif
+                    return GetPartialStaticDataResponse(*asset, range, req.version(), req.keep_alive());
+                case static_cache::RangeStatus::NONE:
+                    break;
                 }
             }
+
+            if (asset->body)
+            {
+                auto encoding = compression::ChooseEncoding(req[http::field::accept_encoding]);
+                return GetCachedStaticDataResponse(*asset, encoding, req.version(), req.keep_alive());
+            }
+            return GetFileStaticDataResponse(*asset, req.version(), req.keep_alive());
+        }
+
+        template <typename Request>
+        bool IsNotModified(const Request& req, const static_cache::Asset& asset) const
+        {
+            // If-None-Match    If-Modified-Since
+            if (auto if_none_match = req[http::field::if_none_match]; !if_none_match.empty())
+                return etag::IsNoneMatchSatisfied(if_none_match, asset.etag)
+                    || IsEncodedETagMatched(if_none_match, asset);
+
+            if (auto if_modified_since = req[http::field::if_modified_since]; !if_modified_since.empty())
+            {
+                auto since = static_cache::ParseHttpDate(if_modified_since);
+                return since && asset.modified <= *since;
+            }
+            return false;
+        }
+
+        //     ETag  "<hash>-gzip",    
+        bool IsEncodedETagMatched(std::string_view if_none_match, const static_cache::Asset& asset) const
+        {
+            for (auto encoding : { compression::Encoding::GZIP, compression::Encoding::BROTLI })
+            {
+                if (etag::IsNoneMatchSatisfied(if_none_match, GetEncodedETag(asset.etag, encoding)))
+                    return true;
+            }
+            return false;
+        }
+
+        static std::string GetEncodedETag(const std::string& etag, compression::Encoding encoding)
+        {
+            if (encoding == compression::Encoding::IDENTITY)
+                return etag;
+            std::string encoded = etag;
+            encoded.insert(encoded.size() - 1, "-"s.append(compression::GetEncodingName(encoding)));
+            return encoded;
+        }
+
+        template <typename Response>
+        void SetCacheHeaders(Response& response, const static_cache::Asset& asset, const std::string& etag) const
+        {
+            unsigned max_age = cache_->GetOptions().max_age_seconds;
+            if (max_age == 0)
+                response.set(http::field::cache_control, "no-cache"sv);
             else
-                return GetBadRequestStaticDataResponse(req.version(), req.keep_alive());
+                response.set(http::field::cache_control, "public, max-age="s + std::to_string(max_age));
+            response.set(http::field::etag, etag);
+            response.set(http::field::last_modified, asset.last_modified);
+            response.set(http::field::accept_ranges, "bytes"sv);
         }
 
         StringResponse GetBadRequestStaticDataResponse(const unsigned int version, const bool keep_alive)
@@ -114,24 +170,125 @@ namespace http_handler_static
             return response;
         }
 
-        FileResponse GetFileStaticDataResponse(fs::path& request_path, fs::path& extension)
+        StringResponse GetNotModifiedStaticDataResponse(const static_cache::Asset& asset, const unsigned int version, const bool keep_alive)
         {
-            FileResponse response;
-            response.version(11);
-            response.result(http::status::ok);
-            std::string_view content_type = supported_extensions.at(extension.string());
-            response.insert(http::field::content_type, content_type);
-            http::file_body::value_type body;
+            StringResponse response(http::status::not_modified, version);
+            response.set(http::field::content_type, asset.content_type);
+            SetCacheHeaders(response, asset, asset.etag);
+            response.keep_alive(keep_alive);
+            return response;
+        }
+
+        StringResponse GetRangeNotSatisfiableResponse(const static_cache::Asset& asset, const unsigned int version, const bool keep_alive)
+        {
+            StringResponse response(http::status::range_not_satisfiable, version);
+            response.set(http::field::content_type, ContentType::TEXT_TXT);
+            response.set(http::field::content_range, "bytes */"s + std::to_string(asset.size));
+            response.set(http::field::cache_control, "no-cache"sv);
+            response.body() = "Requested range not satisfiable";
+            response.content_length(response.body().size());
+            response.keep_alive(keep_alive);
+            return response;
+        }
 
-            if (sys::error_code ec; body.open(request_path.string().c_str(), boost::beast::file_mode::read, ec), ec) {
-                std::cout << ec.message() + request_path.string() << std::endl;
+        //      ,    -   
+        StringResponse GetCachedStaticDataResponse(const static_cache::Asset& asset, compression::Encoding encoding,
+            const unsigned int version, const bool keep_alive)
+        {
+            const std::string* body = asset.body.get();
+            if (encoding == compression::Encoding::BROTLI && asset.brotli)
+                body = asset.brotli.get();
+            else if (encoding != compression::Encoding::IDENTITY && asset.gzip)
+            {
+                encoding = compression::Encoding::GZIP;
+                body = asset.gzip.get();
+            }
+            else
+                encoding = compression::Encoding::IDENTITY;
+
+            StringResponse response(http::status::ok, version);
+            response.set(http::field::content_type, asset.content_type);
+            SetCacheHeaders(response, asset, GetEncodedETag(asset.etag, encoding));
+            if (asset.gzip || asset.brotli)
+                response.set(http::field::vary, "Accept-Encoding"sv);
+            if (encoding != compression::Encoding::IDENTITY)
+                response.set(http::field::content_encoding, compression::GetEncodingName(encoding));
+            response.body() = *body;
+            response.content_length(body->size());
+            response.keep_alive(keep_alive);
+            return response;
+        }
+
+        StringResponse GetPartialStaticDataResponse(const static_cache::Asset& asset, const static_cache::ByteRange& range,
+            const unsigned int version, const bool keep_alive)
+        {
+            size_t length = static_cast<size_t>(range.last - range.first + 1);
+            StringResponse response(http::status::partial_content, version);
+            response.set(http::field::content_type, asset.content_type);
+            SetCacheHeaders(response, asset, asset.etag);
+            response.set(http::field::content_range, GetContentRange(asset, range));
+
+            if (asset.body)
+                response.body() = asset.body->substr(static_cast<size_t>(range.first), length);
+            else
+            {
+                std::ifstream input(asset.file_path, std::ios::binary);
+                input.seekg(static_cast<std::streamoff>(range.first));
+                response.body().resize(length);
+                if (!input.read(response.body().data(), length))
+                    throw std::runtime_error("Can't read range of "s + asset.file_path.string());
+            }
+            response.content_length(length);
+            response.keep_alive(keep_alive);
+            return response;
+        }
+
+        //    :         Content-Length 
+        FileResponse GetPartialFileStaticDataResponse(const static_cache::Asset& asset, const static_cache::ByteRange& range,
+            const unsigned int version, const bool keep_alive)
+        {
+            FileResponse response(http::status::partial_content, version);
+            response.set(http::field::content_type, asset.content_type);
+            SetCacheHeaders(response, asset, asset.etag);
+            response.set(http::field::content_range, GetContentRange(asset, range));
+            http::file_body::value_type body = OpenFileBody(asset);
+
+            if (sys::error_code ec; body.file().seek(range.first, ec), ec) {
+                throw std::runtime_error(ec.message() + asset.file_path.string());
             }
 
             response.body() = std::move(body);
+            response.content_length(range.last - range.first + 1);
+            response.keep_alive(keep_alive);
+            return response;
+        }
+
+        //      ,  Linux     sendfile
+        FileResponse GetFileStaticDataResponse(const static_cache::Asset& asset, const unsigned int version, const bool keep_alive)
+        {
+            FileResponse response(http::status::ok, version);
+            response.set(http::field::content_type, asset.content_type);
+            SetCacheHeaders(response, asset, asset.etag);
+            response.body() = OpenFileBody(asset);
             response.prepare_payload();
+            response.keep_alive(keep_alive);
             return response;
         }
 
+        http::file_body::value_type OpenFileBody(const static_cache::Asset& asset)
+        {
+            http::file_body::value_type body;
+
+            if (sys::error_code ec; body.open(asset.file_path.string().c_str(), boost::beast::file_mode::read, ec), ec) {
+                throw std::runtime_error(ec.message() + asset.file_path.string());
+            }
+            return body;
+        }
+
+        std::string GetContentRange(const static_cache::Asset& asset, const static_cache::ByteRange& range)
+        {
+            return "bytes "s + std::to_string(range.first) + "-"s + std::to_string(range.last) + "/"s + std::to_string(asset.size);
+        }
 
         StringResponse GetWrongExtensionStaticDataResponse(const unsigned int version, const bool keep_alive)
         {
@@ -180,20 +337,5 @@ namespace http_handler_static
             }
             return decoding_str;
         }
-
-        bool IsCorrectPath(fs::path path, fs::path base)
-        {
-            //       ( .  ..)
-            path = fs::weakly_canonical(path);
-            base = fs::weakly_canonical(base);
-
-            // ,    base   path
-            for (auto b = base.begin(), p = path.begin(); b != base.end(); ++b, ++p) {
-                if (p == path.end() || *p != *b) {
-                    return false;
-                }
-            }
-            return true;
-        }
     };
 }
\ No newline at end of file
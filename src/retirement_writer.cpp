@@ -0,0 +1,135 @@
+#include "retirement_writer.h"
+#include "log_data.h"
+
+#include <algorithm>
+
+namespace retirement
+{
+    RetirementWriter::RetirementWriter(WriteFn write, Options options)
+        : write_(std::move(write))
+        , options_(options)
+    {
+        options_.max_batch = std::max<size_t>(1, options_.max_batch);
+        worker_ = std::jthread([this](std::stop_token stop) {
+            Run(stop);
+            });
+    }
+
+    RetirementWriter::~RetirementWriter()
+    {
+        Stop();
+    }
+
+    void RetirementWriter::Enqueue(std::vector<storage::RetiredPlayer> players)
+    {
+        if (players.empty())
+            return;
+
+        size_t dropped = 0;
+        {
+            std::lock_guard lock{ mutex_ };
+            size_t free = stopped_ ? 0 : options_.capacity - std::min(options_.capacity, pending_.load(std::memory_order_relaxed));
+            size_t accepted = std::min(free, players.size());
+            dropped = players.size() - accepted;
+            std::move(players.begin(), players.begin() + accepted, std::back_inserter(queue_));
+            pending_.fetch_add(accepted, std::memory_order_relaxed);
+        }
+        cond_var_.notify_one();
+
+        if (dropped != 0)
+        {
+            stats_.dropped.fetch_add(dropped, std::memory_order_relaxed);
+            BOOST_LOG_TRIVIAL(warning) << boost::log::add_value(data, boost::json::object{
+                {"message", "retirement queue is full"},
+                {"data", boost::json::object{ {"dropped", dropped} }}
+                });
+        }
+    }
+
+    void RetirementWriter::Stop()
+    {
+        {
+            std::lock_guard lock{ mutex_ };
+            stopped_ = true;
+        }
+        if (worker_.joinable())
+        {
+            worker_.request_stop();
+            worker_.join();
+        }
+    }
+
+    void RetirementWriter::Run(std::stop_token stop)
+    {
+        std::vector<storage::RetiredPlayer> batch;
+        batch.reserve(options_.max_batch);
+        unsigned attempt = 0;
+
+        while (true)
+        {
+            if (batch.empty())
+            {
+                std::unique_lock lock{ mutex_ };
+                // При запросе остановки ожидание прерывается, но очередь дописывается до конца
+                if (!cond_var_.wait(lock, stop, [this] { return !queue_.empty(); }) && queue_.empty())
+                    break;
+                if (queue_.size() < options_.max_batch && !stop.stop_requested())
+                    cond_var_.wait_for(lock, stop, options_.flush_interval, [this] { return queue_.size() >= options_.max_batch; });
+
+                size_t count = std::min(queue_.size(), options_.max_batch);
+                std::move(queue_.begin(), queue_.begin() + count, std::back_inserter(batch));
+                queue_.erase(queue_.begin(), queue_.begin() + count);
+            }
+
+            if (TryWrite(batch))
+            {
+                pending_.fetch_sub(batch.size(), std::memory_order_relaxed);
+                batch.clear();
+                attempt = 0;
+                continue;
+            }
+
+            ++attempt;
+            if (stop.stop_requested())
+            {
+                if (attempt > options_.shutdown_retries)
+                {
+                    BOOST_LOG_TRIVIAL(error) << boost::log::add_value(data, boost::json::object{
+                        {"message", "retired players dropped on shutdown"},
+                        {"data", boost::json::object{ {"dropped", batch.size()} }}
+                        });
+                    stats_.dropped.fetch_add(batch.size(), std::memory_order_relaxed);
+                    pending_.fetch_sub(batch.size(), std::memory_order_relaxed);
+                    batch.clear();
+                    attempt = 0;
+                }
+                continue;
+            }
+
+            // 100 мс, 200 мс, 400 мс... но не больше max_retry_delay
+            auto delay = std::min<std::chrono::milliseconds>(options_.max_retry_delay, 100ms * (1u << std::min(attempt - 1, 16u)));
+            std::unique_lock lock{ mutex_ };
+            cond_var_.wait_for(lock, stop, delay, [] { return false; });
+        }
+    }
+
+    bool RetirementWriter::TryWrite(const std::vector<storage::RetiredPlayer>& batch)
+    {
+        try
+        {
+            write_(batch);
+            stats_.written.fetch_add(batch.size(), std::memory_order_relaxed);
+            stats_.batches.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        catch (const std::exception& ex)
+        {
+            stats_.failures.fetch_add(1, std::memory_order_relaxed);
+            BOOST_LOG_TRIVIAL(error) << boost::log::add_value(data, boost::json::object{
+                {"message", "retired players write failed"},
+                {"data", boost::json::object{ {"error", ex.what()} }}
+                });
+            return false;
+        }
+    }
+}
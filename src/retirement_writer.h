@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "records_storage.h"
+
+namespace retirement
+{
+    using namespace std::literals;
+
+    struct Options
+    {
+        // Сколько незаписанных строк может ждать в памяти. Сверх этого строки отбрасываются
+        size_t capacity = 100'000;
+        size_t max_batch = 1000;
+        // Сколько ждать, пока наберётся пачка: строки нескольких тиков уходят одним запросом
+        std::chrono::milliseconds flush_interval = 200ms;
+        std::chrono::milliseconds max_retry_delay = 5s;
+        // При остановке неудачная пачка повторяется столько раз, а затем отбрасывается
+        unsigned shutdown_retries = 3;
+    };
+
+    struct Stats
+    {
+        std::atomic<uint64_t> written{ 0 };
+        std::atomic<uint64_t> batches{ 0 };
+        std::atomic<uint64_t> failures{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+    };
+
+    // Отложенная запись ушедших игроков в БД на отдельном потоке.
+    // Enqueue вызывается из тика и не ждёт ни Postgres, ни свободного соединения пула.
+    // Ошибки записи повторяются с экспоненциальной задержкой, строки остаются в очереди
+    class RetirementWriter
+    {
+    public:
+        using WriteFn = std::function<void(const std::vector<storage::RetiredPlayer>&)>;
+
+        explicit RetirementWriter(WriteFn write, Options options = {});
+        RetirementWriter(const RetirementWriter&) = delete;
+        RetirementWriter& operator=(const RetirementWriter&) = delete;
+        ~RetirementWriter();
+
+        void Enqueue(std::vector<storage::RetiredPlayer> players);
+
+        // Записывает оставшиеся строки и останавливает поток. Повторный вызов ничего не делает
+        void Stop();
+
+        // Очередь заполнена больше чем наполовину: БД не успевает, новых игроков лучше не принимать
+        bool IsBacklogged() const noexcept
+        {
+            return pending_.load(std::memory_order_relaxed) * 2 > options_.capacity;
+        }
+
+        // Строки в очереди и в пачке, которая сейчас пишется
+        size_t GetPending() const noexcept
+        {
+            return pending_.load(std::memory_order_relaxed);
+        }
+
+        const Stats& GetStats() const noexcept
+        {
+            return stats_;
+        }
+
+    private:
+        WriteFn write_;
+        Options options_;
+        std::mutex mutex_;
+        std::condition_variable_any cond_var_;
+        std::deque<storage::RetiredPlayer> queue_;
+        std::atomic<size_t> pending_{ 0 };
+        bool stopped_ = false;
+        Stats stats_;
+        std::jthread worker_;
+
+        void Run(std::stop_token stop);
+        bool TryWrite(const std::vector<storage::RetiredPlayer>& batch);
+    };
+}
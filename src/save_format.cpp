@@ -0,0 +1,235 @@
+#include "save_format.h"
+#include "binary_codec.h"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std::string_literals;
+
+namespace save
+{
+    namespace
+    {
+        constexpr size_t ALIGNMENT = 8;
+
+        size_t AlignUp(size_t size)
+        {
+            return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        }
+
+        template <typename T>
+        void AppendSection(std::string& out, const std::vector<T>& records)
+        {
+            out.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+            out.resize(AlignUp(out.size()), '\0');
+        }
+
+        [[noreturn]] void Invalid(const std::string& what)
+        {
+            throw std::runtime_error("Invalid save file: "s + what);
+        }
+
+        // Секция из count записей по смещению offset. Сдвигает offset за секцию
+        template <typename T>
+        std::span<const T> TakeSection(std::string_view data, size_t& offset, uint64_t count, const char* name)
+        {
+            // Выравнивание после прошлой секции могло увести offset за конец файла
+            if (offset > data.size() || count > (data.size() - offset) / sizeof(T))
+                Invalid("section "s + name + " is out of the file");
+            std::span<const T> section(reinterpret_cast<const T*>(data.data() + offset), static_cast<size_t>(count));
+            offset = AlignUp(offset + section.size_bytes());
+            return section;
+        }
+
+        void CheckString(FlatString value, size_t strings_size, const char* name)
+        {
+            if (value.offset > strings_size || value.size > strings_size - value.offset)
+                Invalid("string "s + name + " is out of the string table");
+        }
+
+        bool IsDirection(uint8_t dir)
+        {
+            return dir == 'U' || dir == 'D' || dir == 'L' || dir == 'R';
+        }
+    }
+
+    uint32_t FlatWriter::AddMap(std::string_view id)
+    {
+        auto [it, inserted] = map_ids_.try_emplace(std::string(id), static_cast<uint32_t>(maps_.size()));
+        if (inserted)
+            maps_.push_back(AddString(id));
+        return it->second;
+    }
+
+    FlatString FlatWriter::AddString(std::string_view value)
+    {
+        FlatString result{ static_cast<uint32_t>(strings_.size()), static_cast<uint32_t>(value.size()) };
+        strings_ += value;
+        return result;
+    }
+
+    void FlatWriter::AddLoot(const FlatLoot& loot)
+    {
+        loot_.push_back(loot);
+    }
+
+    uint64_t FlatWriter::AddBagItem(const FlatLoot& loot)
+    {
+        bag_.push_back(loot);
+        return bag_.size() - 1;
+    }
+
+    void FlatWriter::AddDog(const FlatDog& dog)
+    {
+        dogs_.push_back(dog);
+    }
+
+    void FlatWriter::AddPlayer(const FlatPlayer& player)
+    {
+        players_.push_back(player);
+    }
+
+    std::string FlatWriter::Finish(uint64_t generation, uint64_t checkpoint) const
+    {
+        if (strings_.size() > UINT32_MAX)
+            throw std::length_error("Save file string table is too large");
+
+        FlatHeader header;
+        std::memcpy(header.magic, FLAT_MAGIC, sizeof(FLAT_MAGIC));
+        header.generation = generation;
+        header.checkpoint = checkpoint;
+        header.maps = maps_.size();
+        header.loot = loot_.size();
+        header.dogs = dogs_.size();
+        header.bag = bag_.size();
+        header.players = players_.size();
+        header.strings_size = strings_.size();
+
+        std::string out(sizeof(FlatHeader), '\0');
+        out.reserve(sizeof(FlatHeader) + maps_.size() * sizeof(FlatString) + (loot_.size() + bag_.size()) * sizeof(FlatLoot)
+            + dogs_.size() * sizeof(FlatDog) + players_.size() * sizeof(FlatPlayer) + strings_.size());
+        AppendSection(out, maps_);
+        AppendSection(out, loot_);
+        AppendSection(out, bag_);
+        AppendSection(out, dogs_);
+        AppendSection(out, players_);
+        out += strings_;
+
+        header.crc = codec::Checksum(std::string_view(out).substr(sizeof(FlatHeader)));
+        std::memcpy(out.data(), &header, sizeof(header));
+        return out;
+    }
+
+    FlatView::FlatView(std::string_view data)
+    {
+        if (!IsFlat(data) || data.size() < sizeof(FlatHeader))
+            Invalid("no header");
+        if (reinterpret_cast<uintptr_t>(data.data()) % ALIGNMENT != 0)
+            throw std::invalid_argument("Save file buffer is not aligned");
+        std::memcpy(&header_, data.data(), sizeof(header_));
+        if (header_.version != FLAT_VERSION)
+            Invalid("unsupported version "s + std::to_string(header_.version));
+        if (header_.header_size != sizeof(FlatHeader))
+            Invalid("wrong header size");
+
+        if (codec::Checksum(data.substr(sizeof(FlatHeader))) != header_.crc)
+            Invalid("checksum mismatch");
+
+        size_t offset = sizeof(FlatHeader);
+        maps_ = TakeSection<FlatString>(data, offset, header_.maps, "maps");
+        loot_ = TakeSection<FlatLoot>(data, offset, header_.loot, "loot");
+        bag_ = TakeSection<FlatLoot>(data, offset, header_.bag, "bag");
+        dogs_ = TakeSection<FlatDog>(data, offset, header_.dogs, "dogs");
+        players_ = TakeSection<FlatPlayer>(data, offset, header_.players, "players");
+        if (offset > data.size() || data.size() - offset != header_.strings_size)
+            Invalid("wrong string table size");
+        strings_ = data.substr(offset);
+
+        // Дальше записи читаются без проверок: все номера и смещения проверены здесь
+        for (const auto& map : maps_)
+            CheckString(map, strings_.size(), "map id");
+        for (const auto& loot : loot_)
+        {
+            if (loot.map >= maps_.size())
+                Invalid("loot refers to a missing map");
+        }
+        if (players_.size() != dogs_.size())
+            Invalid("dogs and players don't pair up");
+        for (size_t i = 0; i < dogs_.size(); ++i)
+        {
+            const FlatDog& dog = dogs_[i];
+            const FlatPlayer& player = players_[i];
+            if (dog.map >= maps_.size() || player.map != dog.map)
+                Invalid("dog refers to a missing map");
+            if (dog.bag_begin > bag_.size() || dog.bag_count > bag_.size() - dog.bag_begin)
+                Invalid("dog bag is out of the bag section");
+            if (!IsDirection(dog.dir))
+                Invalid("wrong dog direction");
+            if (player.dog_id != dog.object_id)
+                Invalid("player doesn't match its dog");
+            CheckString(player.token, strings_.size(), "token");
+            CheckString(player.name, strings_.size(), "player name");
+        }
+    }
+
+    bool IsFlat(std::string_view data) noexcept
+    {
+        return data.size() >= sizeof(FLAT_MAGIC) && std::memcmp(data.data(), FLAT_MAGIC, sizeof(FLAT_MAGIC)) == 0;
+    }
+
+    MappedFile::MappedFile(const std::filesystem::path& path)
+    {
+#ifdef __linux__
+        int fd = ::open(path.string().c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Can't open the file: "s + path.string());
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Can't read the file: "s + path.string());
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        if (size != 0)
+        {
+            void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("Can't map the file: "s + path.string());
+            }
+            // Снимок читается один раз подряд
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+            mapping_ = mapping;
+            data_ = std::string_view(static_cast<const char*>(mapping), size);
+        }
+        ::close(fd);
+#else
+        std::FILE* file = std::fopen(path.string().c_str(), "rb");
+        if (!file)
+            throw std::runtime_error("Can't open the file: "s + path.string());
+        char chunk[1 << 16];
+        size_t read;
+        while ((read = std::fread(chunk, 1, sizeof(chunk), file)) != 0)
+            buffer_.append(chunk, read);
+        std::fclose(file);
+        data_ = buffer_;
+#endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+#ifdef __linux__
+        if (mapping_)
+            ::munmap(mapping_, data_.size());
+#endif
+    }
+}
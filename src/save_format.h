@@ -0,0 +1,198 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace save
+{
+    // Плоский снимок мира: заголовок, секции записей фиксированного размера и таблица строк.
+    // Снимок проверяется и читается прямо в отображённом в память файле, без разбора во временные контейнеры.
+    // Числа - в порядке байт машины, каждая секция выровнена на 8 байт
+    inline constexpr char FLAT_MAGIC[8] = { 'G', 'S', 'A', 'V', 'F', 'L', 'A', 'T' };
+    inline constexpr uint32_t FLAT_VERSION = 1;
+
+    // Строка в таблице строк
+    struct FlatString
+    {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    struct FlatHeader
+    {
+        char magic[8];
+        uint32_t version = FLAT_VERSION;
+        uint32_t header_size = sizeof(FlatHeader);
+        uint64_t generation = 0;
+        uint64_t checkpoint = 0;
+        uint64_t maps = 0;
+        uint64_t loot = 0;
+        uint64_t dogs = 0;
+        uint64_t bag = 0;
+        uint64_t players = 0;
+        uint64_t strings_size = 0;
+        // CRC32 всего, что идёт после заголовка
+        uint32_t crc = 0;
+        uint32_t reserved = 0;
+    };
+
+    // map - номер карты в секции карт
+    struct FlatLoot
+    {
+        uint32_t map = 0;
+        int32_t generation_id = 0;
+        int32_t object_id = 0;
+        int32_t type = 0;
+        int32_t value = 0;
+        int32_t reserved = 0;
+        double x = 0;
+        double y = 0;
+    };
+
+    // Содержимое рюкзака - bag_count записей секции рюкзаков начиная с bag_begin
+    struct FlatDog
+    {
+        uint32_t map = 0;
+        int32_t generation_id = 0;
+        int32_t object_id = 0;
+        int32_t score = 0;
+        uint8_t dir = 0;
+        uint8_t reserved[3] = {};
+        uint32_t bag_count = 0;
+        uint64_t bag_begin = 0;
+        int64_t idle_time = 0;
+        double x = 0;
+        double y = 0;
+        double speed_x = 0;
+        double speed_y = 0;
+        double default_speed_x = 0;
+        double default_speed_y = 0;
+    };
+
+    // Игрок i принадлежит собаке i: секции собак и игроков идут парами
+    struct FlatPlayer
+    {
+        uint32_t map = 0;
+        int32_t generation_id = 0;
+        int32_t object_id = 0;
+        int32_t dog_id = 0;
+        FlatString token;
+        FlatString name;
+        int64_t play_time = 0;
+    };
+
+    static_assert(std::is_trivially_copyable_v<FlatHeader> && sizeof(FlatHeader) == 88);
+    static_assert(std::is_trivially_copyable_v<FlatLoot> && sizeof(FlatLoot) == 40);
+    static_assert(std::is_trivially_copyable_v<FlatDog> && sizeof(FlatDog) == 88);
+    static_assert(std::is_trivially_copyable_v<FlatPlayer> && sizeof(FlatPlayer) == 40);
+
+    // Собирает плоский снимок
+    class FlatWriter
+    {
+    public:
+        // Номер карты. Повторный вызов с тем же id возвращает прежний номер
+        uint32_t AddMap(std::string_view id);
+        FlatString AddString(std::string_view value);
+        void AddLoot(const FlatLoot& loot);
+        // Кладёт предмет в секцию рюкзаков, возвращает его номер
+        uint64_t AddBagItem(const FlatLoot& loot);
+        void AddDog(const FlatDog& dog);
+        void AddPlayer(const FlatPlayer& player);
+
+        std::string Finish(uint64_t generation, uint64_t checkpoint) const;
+
+    private:
+        std::vector<FlatString> maps_;
+        std::unordered_map<std::string, uint32_t> map_ids_;
+        std::vector<FlatLoot> loot_;
+        std::vector<FlatLoot> bag_;
+        std::vector<FlatDog> dogs_;
+        std::vector<FlatPlayer> players_;
+        std::string strings_;
+    };
+
+    // Проверенный плоский снимок поверх чужого буфера. Буфер должен жить дольше и быть выровнен на 8 байт
+    class FlatView
+    {
+    public:
+        // Проверяет заголовок, размеры секций, CRC и все ссылки записей. Ошибка - std::runtime_error
+        explicit FlatView(std::string_view data);
+
+        const FlatHeader& GetHeader() const noexcept
+        {
+            return header_;
+        }
+
+        size_t GetMapCount() const noexcept
+        {
+            return maps_.size();
+        }
+
+        std::string_view GetMapId(uint32_t map) const
+        {
+            return GetString(maps_[map]);
+        }
+
+        std::string_view GetString(FlatString value) const
+        {
+            return strings_.substr(value.offset, value.size);
+        }
+
+        std::span<const FlatLoot> GetLoot() const noexcept
+        {
+            return loot_;
+        }
+
+        std::span<const FlatDog> GetDogs() const noexcept
+        {
+            return dogs_;
+        }
+
+        std::span<const FlatPlayer> GetPlayers() const noexcept
+        {
+            return players_;
+        }
+
+        std::span<const FlatLoot> GetBag(const FlatDog& dog) const
+        {
+            return bag_.subspan(dog.bag_begin, dog.bag_count);
+        }
+
+    private:
+        FlatHeader header_;
+        std::span<const FlatString> maps_;
+        std::span<const FlatLoot> loot_;
+        std::span<const FlatLoot> bag_;
+        std::span<const FlatDog> dogs_;
+        std::span<const FlatPlayer> players_;
+        std::string_view strings_;
+    };
+
+    // Начинается ли data с заголовка плоского снимка. Иначе это архив Boost.Serialization прежних версий
+    bool IsFlat(std::string_view data) noexcept;
+
+    // Файл, отображённый в память только для чтения. На платформах без mmap читается целиком
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::filesystem::path& path);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        std::string_view GetData() const noexcept
+        {
+            return data_;
+        }
+
+    private:
+        std::string_view data_;
+        void* mapping_ = nullptr;
+        std::string buffer_;
+    };
+}
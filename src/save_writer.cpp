@@ -0,0 +1,106 @@
+#include "save_writer.h"
+#include "log_data.h"
+
+#include <algorithm>
+
+namespace save
+{
+    SaveWriter::SaveWriter(size_t max_pending)
+        : max_pending_(std::max<size_t>(1, max_pending))
+    {
+        worker_ = std::jthread([this](std::stop_token stop) {
+            Run(stop);
+            });
+    }
+
+    SaveWriter::~SaveWriter()
+    {
+        if (worker_.joinable())
+        {
+            worker_.request_stop();
+            worker_.join();
+        }
+    }
+
+    void SaveWriter::Enqueue(Job job)
+    {
+        {
+            std::lock_guard lock{ mutex_ };
+            if (job.is_base && !queue_.empty())
+            {
+                stats_.superseded.fetch_add(queue_.size(), std::memory_order_relaxed);
+                pending_.fetch_sub(queue_.size(), std::memory_order_relaxed);
+                queue_.clear();
+            }
+            queue_.push_back(std::move(job));
+            pending_.fetch_add(1, std::memory_order_relaxed);
+        }
+        cond_var_.notify_one();
+    }
+
+    void SaveWriter::Flush()
+    {
+        std::unique_lock lock{ mutex_ };
+        idle_cond_var_.wait(lock, [this] { return pending_.load(std::memory_order_relaxed) == 0; });
+    }
+
+    void SaveWriter::Run(std::stop_token stop)
+    {
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock lock{ mutex_ };
+                // При запросе остановки очередь дописывается до конца
+                if (!cond_var_.wait(lock, stop, [this] { return !queue_.empty(); }) && queue_.empty())
+                    break;
+                job = std::move(queue_.front());
+                queue_.pop_front();
+            }
+
+            Write(job);
+
+            {
+                std::lock_guard lock{ mutex_ };
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+            }
+            idle_cond_var_.notify_all();
+        }
+    }
+
+    void SaveWriter::Write(Job& job)
+    {
+        if (!job.is_base && broken_.load(std::memory_order_relaxed))
+        {
+            stats_.superseded.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        try
+        {
+            uint64_t bytes = job.write();
+            stats_.bytes_written.fetch_add(bytes, std::memory_order_relaxed);
+            (job.is_base ? stats_.bases : stats_.deltas).fetch_add(1, std::memory_order_relaxed);
+            if (job.is_base)
+                broken_.store(false, std::memory_order_release);
+        }
+        catch (const std::exception& ex)
+        {
+            stats_.failures.fetch_add(1, std::memory_order_relaxed);
+            broken_.store(true, std::memory_order_release);
+            BOOST_LOG_TRIVIAL(error) << boost::log::add_value(data, boost::json::object{
+                {"message", "game state save failed"},
+                {"data", boost::json::object{ {"error", ex.what()} }}
+                });
+        }
+
+        uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        stats_.last_save_us.store(us, std::memory_order_relaxed);
+        stats_.total_save_us.fetch_add(us, std::memory_order_relaxed);
+        uint64_t max = stats_.max_save_us.load(std::memory_order_relaxed);
+        while (us > max && !stats_.max_save_us.compare_exchange_weak(max, us, std::memory_order_relaxed))
+        {
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+namespace save
+{
+    struct Stats
+    {
+        std::atomic<uint64_t> bases{ 0 };
+        std::atomic<uint64_t> deltas{ 0 };
+        std::atomic<uint64_t> failures{ 0 };
+        // Задачи, отменённые более новым базовым снимком или пропущенные после сбоя
+        std::atomic<uint64_t> superseded{ 0 };
+        std::atomic<uint64_t> bytes_written{ 0 };
+        std::atomic<uint64_t> last_save_us{ 0 };
+        std::atomic<uint64_t> max_save_us{ 0 };
+        std::atomic<uint64_t> total_save_us{ 0 };
+    };
+
+    // Задача записи: копия состояния, снятая на тике, и функция, которая её сериализует и пишет.
+    // Возвращает число записанных байт
+    struct Job
+    {
+        bool is_base = false;
+        std::function<uint64_t()> write;
+    };
+
+    // Запись сохранений на отдельном потоке: тик только снимает копию состояния.
+    // Задачи выполняются по порядку. Базовый снимок отменяет ещё не начатые задачи - он их покрывает.
+    // После сбоя записи изменения пропускаются до следующего базового снимка, иначе журнал разойдётся с миром
+    class SaveWriter
+    {
+    public:
+        explicit SaveWriter(size_t max_pending = 4);
+        SaveWriter(const SaveWriter&) = delete;
+        SaveWriter& operator=(const SaveWriter&) = delete;
+        ~SaveWriter();
+
+        void Enqueue(Job job);
+        // Ждёт, пока запишутся все поставленные задачи
+        void Flush();
+
+        // Задачи в очереди и та, что сейчас пишется
+        size_t GetQueueDepth() const noexcept
+        {
+            return pending_.load(std::memory_order_relaxed);
+        }
+
+        // Диск не успевает за контрольными точками: следующую лучше сделать базовой
+        bool IsBacklogged() const noexcept
+        {
+            return GetQueueDepth() >= max_pending_;
+        }
+
+        // Последняя запись не удалась, журнал на диске неполон до следующего базового снимка
+        bool NeedsBase() const noexcept
+        {
+            return broken_.load(std::memory_order_acquire);
+        }
+
+        const Stats& GetStats() const noexcept
+        {
+            return stats_;
+        }
+
+    private:
+        size_t max_pending_;
+        std::mutex mutex_;
+        std::condition_variable_any cond_var_;
+        std::condition_variable idle_cond_var_;
+        std::deque<Job> queue_;
+        std::atomic<size_t> pending_{ 0 };
+        std::atomic<bool> broken_{ false };
+        Stats stats_;
+        std::jthread worker_;
+
+        void Run(std::stop_token stop);
+        void Write(Job& job);
+    };
+}
@@ -1,161 +1,656 @@
 #include "serializator.h"
-#include "application.h"
+#include "player.h"
+#include "binary_codec.h"
+
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using namespace std::chrono_literals;
 using namespace std::string_literals;
 
-	Serializator::Serializator
-	(bool is_auto_save, 
-	 const std::chrono::milliseconds save_period, 
-	 const std::filesystem::path save_path)
-		:
-		is_auto_save_(is_auto_save),
-		save_period_(save_period),
-		save_path_(save_path),
-		temp_path_("temp"s),
-		time_since_save_(0ms)
-	{}
+namespace
+{
+	using AllLoot = std::unordered_map<std::string, std::vector<model::LootSer>>;
+	using AllDogs = std::unordered_map<std::string, std::unordered_map<int, model::DogSer>>;
+	using AllPlayers = std::unordered_map<std::string, std::unordered_map<int, model::PlayerSer>>;
+	using codec::Checksum;
 
-	void Serializator::SerializeData
-	(const std::unordered_map<std::string, std::shared_ptr<model::GameSession>>& sessions,
-		std::unordered_map<int, std::vector<std::shared_ptr<Player>>> players_to_session)
+	//  : , CRC32,   
+	constexpr size_t DELTA_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+	//  ,      
+	struct WorldSer
+	{
+		uint64_t generation = 0;
+		uint64_t checkpoint = 0;
+		AllLoot loot;
+		AllDogs dogs;
+		AllPlayers players;
+	};
+
+	//  data    ,     
+	void WriteFileSynced(const std::filesystem::path& path, const char* mode, const std::string& data)
+	{
+		std::FILE* file = std::fopen(path.string().c_str(), mode);
+		if (!file)
+			throw std::logic_error("Can't open the file: "s + path.string());
+		bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size() && std::fflush(file) == 0;
+#ifdef __linux__
+		ok = ok && ::fsync(::fileno(file)) == 0;
+#endif
+		ok = std::fclose(file) == 0 && ok;
+		if (!ok)
+			throw std::logic_error("Can't write the file: "s + path.string());
+	}
+
+	//  rename       ,      
+	void SyncDirectory([[maybe_unused]] const std::filesystem::path& dir)
+	{
+#ifdef __linux__
+		int fd = ::open(dir.empty() ? "." : dir.string().c_str(), O_RDONLY | O_DIRECTORY);
+		if (fd < 0)
+			return;
+		::fsync(fd);
+		::close(fd);
+#endif
+	}
+
+	std::string EncodeWorld(const WorldSer& world)
+	{
+		save::FlatWriter writer;
+		for (const auto& [map_id, loot] : world.loot)
+		{
+			uint32_t map = writer.AddMap(map_id);
+			for (const auto& l : loot)
+				writer.AddLoot(l.ToFlat(map));
+		}
+		for (const auto& [map_id, dogs] : world.dogs)
+		{
+			auto players_it = world.players.find(map_id);
+			if (players_it == world.players.end())
+				continue;
+			uint32_t map = writer.AddMap(map_id);
+			//     ,      
+			for (const auto& [id, dog] : dogs)
+			{
+				auto player_it = players_it->second.find(id);
+				if (player_it == players_it->second.end())
+					continue;
+				writer.AddDog(dog.ToFlat(map, writer));
+				writer.AddPlayer(player_it->second.ToFlat(map, writer));
+			}
+		}
+		return writer.Finish(world.generation, world.checkpoint);
+	}
+
+	//    -  Boost.Serialization
+	WorldSer ReadArchive(const std::filesystem::path& save_path)
+	{
+		WorldSer world;
+		std::ifstream in(save_path, std::ios::in | std::ios::binary);
+		boost::archive::binary_iarchive ia{ in };
+		ia >> world.loot;
+		ia >> world.dogs;
+		ia >> world.players;
+		try
+		{
+			ia >> world.generation;
+			ia >> world.checkpoint;
+		}
+		catch (const boost::archive::archive_exception&)
+		{
+			//   ,    
+		}
+		return world;
+	}
+
+	uint64_t WriteBase(const std::filesystem::path& save_path, const std::filesystem::path& delta_path, const WorldSer& world)
 	{
 		using namespace std::filesystem;
-		//         -      
-		// .   .
-		//       
+		std::string data = EncodeWorld(world);
 
-		bool is_target_file_exists = std::filesystem::exists(save_path_); // 28-30  .
-		std::filesystem::path t;
-		is_target_file_exists ? t = temp_path_ : t = save_path_;
+		//          :       
+		path temp_path = save_path;
+		temp_path += ".tmp"s;
+		WriteFileSynced(temp_path, "wb", data);
+		permissions(temp_path, perms::owner_exec | perms::group_exec | perms::group_write | perms::others_write, perm_options::add); // 
+		rename(temp_path, save_path);
+		SyncDirectory(save_path.parent_path());
 
-		std::fstream out(t, std::ios::out | std::ios::binary | std::ios::trunc);
-		out.open(t);
-		if (!out.is_open())
+		//     .    ,     
+		remove(delta_path);
+		return data.size();
+	}
+
+	uint64_t AppendDelta(const std::filesystem::path& delta_path, const CheckpointDelta& delta)
+	{
+		std::ostringstream body_stream;
 		{
-			std::string err_mes = "Can't open the file: "s + save_path_.string();
-			throw std::logic_error(err_mes);
+			boost::archive::binary_oarchive oa{ body_stream, boost::archive::no_header };
+			oa << delta;
 		}
-		boost::archive::binary_oarchive oa{ out };
+		std::string body = body_stream.str();
+		uint32_t header[] = { static_cast<uint32_t>(body.size()), Checksum(body) };
 
-		std::unordered_map<std::string, std::vector<model::LootSer>> all_serialized_loot;
-		std::unordered_map<std::string, std::unordered_map<int, model::DogSer>> all_serialized_dogs;
-		std::unordered_map<std::string, std::unordered_map<int, model::PlayerSer>> all_serialized_players;
+		std::string record(reinterpret_cast<const char*>(header), DELTA_HEADER_SIZE);
+		record += body;
+		WriteFileSynced(delta_path, "ab", record);
+		return record.size();
+	}
 
-		for (const auto& session : sessions)
+	//  ,   :       .
+	// written_at -        
+	struct FoldedDeltas
+	{
+		struct Dog
 		{
-			auto players = players_to_session[session.second->GetObjectId()];
-			auto map = session.second->GetMap();
+			std::string map_id;
+			model::DogSer dog;
+			int64_t written_at = 0;
+		};
 
-			for (const auto& l : map->GetMapLoot())
+		struct Player
+		{
+			model::PlayerSer player;
+			int64_t written_at = 0;
+		};
+
+		uint64_t checkpoint = 0;
+		int64_t clock_ms = 0;
+		AllLoot added_loot;
+		std::unordered_set<int> removed_loot;
+		std::unordered_map<int, Dog> dogs;
+		std::unordered_map<int, Player> players;
+		std::unordered_set<int> removed_dogs;
+	};
+
+	// id  ,        
+	FoldedDeltas FoldDeltas(std::vector<CheckpointDelta> deltas)
+	{
+		FoldedDeltas folded;
+		for (auto& delta : deltas)
+		{
+			for (const auto& [map_id, ids] : delta.removed_dogs)
 			{
-				auto serialized_loot = model::LootSer(*l);
-				all_serialized_loot[*map->GetId()].push_back(serialized_loot);
+				for (int id : ids)
+				{
+					folded.removed_dogs.insert(id);
+					folded.dogs.erase(id);
+					folded.players.erase(id);
+				}
 			}
-
-			for (const auto& dog : session.second->GetDogs())
+			for (const auto& [map_id, ids] : delta.removed_loot)
+				folded.removed_loot.insert(ids.begin(), ids.end());
+			for (auto& [map_id, added] : delta.added_loot)
+			{
+				auto& loot = folded.added_loot[map_id];
+				loot.insert(loot.end(), added.begin(), added.end());
+			}
+			for (auto& [map_id, map_dogs] : delta.dogs)
+			{
+				for (auto& [id, dog] : map_dogs)
+					folded.dogs.insert_or_assign(id, FoldedDeltas::Dog{ map_id, std::move(dog), delta.clock_ms });
+			}
+			for (auto& [map_id, map_players] : delta.players)
 			{
-				auto serialized_dog = model::DogSer(*dog.second);
-				all_serialized_dogs[*map->GetId()][dog.first] = serialized_dog;
+				for (auto& [id, player] : map_players)
+					folded.players.insert_or_assign(id, FoldedDeltas::Player{ std::move(player), delta.clock_ms });
 			}
+			folded.clock_ms = delta.clock_ms;
+			folded.checkpoint = std::max(folded.checkpoint, delta.checkpoint);
+		}
+		return folded;
+	}
 
-			for (const auto& player : players)
+	//        
+	constexpr size_t RESTORE_CHUNK = 16384;
+
+	// fn(i)   i  [0, count)     .    
+	template <typename Fn>
+	void ParallelFor(size_t count, Fn&& fn)
+	{
+		std::atomic<size_t> next = 0;
+		std::exception_ptr error;
+		std::mutex error_mutex;
+		auto work = [&] {
+			for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
 			{
-				auto serialized_player = model::PlayerSer(*player);
-				all_serialized_players[*map->GetId()][player->GetObjectId()] = serialized_player;
+				try
+				{
+					fn(i);
+				}
+				catch (...)
+				{
+					std::lock_guard lock(error_mutex);
+					if (!error)
+						error = std::current_exception();
+					next.store(count);
+				}
 			}
+			};
+
+		const size_t threads = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+		{
+			std::vector<std::jthread> workers;
+			for (size_t i = 1; i < threads; ++i)
+				workers.emplace_back(work);
+			work();
 		}
+		if (error)
+			std::rethrow_exception(error);
+	}
 
-		permissions(t, perms::owner_exec | perms::group_exec | perms::group_write | perms::others_write, perm_options::add); // 
+	template <typename Map>
+	size_t CountNested(const Map& by_map)
+	{
+		size_t count = 0;
+		for (const auto& [map_id, entities] : by_map)
+			count += entities.size();
+		return count;
+	}
+}
 
-		oa << all_serialized_loot;
-		oa << all_serialized_dogs;
-		oa << all_serialized_players;
-		out.close();
+	Serializator::Serializator
+	(bool is_auto_save,
+	 const std::chrono::milliseconds save_period,
+	 const std::filesystem::path save_path)
+		:
+		is_auto_save_(is_auto_save),
+		save_period_(save_period),
+		save_path_(save_path),
+		delta_path_(save_path.string() + ".delta"s),
+		time_since_save_(0ms)
+	{}
 
-		if (is_target_file_exists)
-			std::filesystem::rename(temp_path_, save_path_);
+	void Serializator::SerializeData
+	(const std::unordered_map<std::string, std::shared_ptr<model::GameSession>>& sessions,
+		const std::unordered_map<int, std::vector<std::shared_ptr<Player>>>& players_to_session)
+	{
+		writer_.Enqueue(CaptureBase(sessions, players_to_session));
+		writer_.Flush();
+		if (writer_.NeedsBase())
+			throw std::logic_error("Can't save the game state to "s + save_path_.string());
 	}
 
-	void Serializator::DeserializeData(Application& app)
+	RestoredWorld Serializator::DeserializeData(const model::Game& game)
 	{
+		RestoredWorld restored;
 		if (!std::filesystem::exists(save_path_))
-			return;
+			return restored;
+
+		save::MappedFile file(save_path_);
+		std::string converted;
+		std::string_view data = file.GetData();
+		if (!save::IsFlat(data))
+		{
+			//         ,      
+			converted = EncodeWorld(ReadArchive(save_path_));
+			data = converted;
+		}
+		save::FlatView base(data);
+		uint64_t generation = base.GetHeader().generation;
+		FoldedDeltas changes = FoldDeltas(ReadDeltas(generation));
 
-		std::unordered_map<std::string, std::vector<model::LootSer>> all_serialized_loot;
-		std::unordered_map<std::string, std::unordered_map<int, model::DogSer>> all_serialized_dogs;
-		std::unordered_map<std::string, std::unordered_map<int, model::PlayerSer>> all_serialized_players;
+		//    ,       
+		struct RestoredMap
+		{
+			std::shared_ptr<model::Map> map;
+			std::shared_ptr<model::GameSession> session;
+			std::vector<size_t> base_dogs;
+			std::vector<std::pair<int, const FoldedDeltas::Dog*>> changed_dogs;
+			std::vector<size_t> base_loot;
+			std::vector<const model::LootSer*> added_loot;
+			std::vector<std::shared_ptr<Player>> players;
+			std::vector<std::shared_ptr<model::Loot>> loot;
+		};
+		std::unordered_map<std::string, RestoredMap> maps;
+		auto find_map = [&](std::string_view map_id) -> RestoredMap* {
+			auto it = maps.find(std::string(map_id));
+			if (it == maps.end())
+			{
+				auto map = game.FindMap(model::Map::Id(std::string(map_id)));
+				if (!map)
+					return nullptr;
+				it = maps.emplace(std::string(map_id), RestoredMap{ std::move(map) }).first;
+			}
+			return &it->second;
+		};
+		std::vector<RestoredMap*> base_maps(base.GetMapCount());
+		for (uint32_t i = 0; i < base_maps.size(); ++i)
+			base_maps[i] = find_map(base.GetMapId(i));
+
+		auto dogs = base.GetDogs();
+		auto players = base.GetPlayers();
+		for (size_t i = 0; i < dogs.size(); ++i)
+		{
+			const save::FlatDog& dog = dogs[i];
+			if (changes.removed_dogs.contains(dog.object_id))
+				continue;
+			if (changes.dogs.contains(dog.object_id))
+			{
+				//         ,      
+				changes.players.try_emplace(dog.object_id, FoldedDeltas::Player{ model::PlayerSer(players[i], base), 0 });
+				continue;
+			}
+			if (base_maps[dog.map])
+				base_maps[dog.map]->base_dogs.push_back(i);
+		}
+		for (const auto& [id, changed] : changes.dogs)
+		{
+			RestoredMap* map = find_map(changed.map_id);
+			if (map && changes.players.contains(id))
+				map->changed_dogs.emplace_back(id, &changed);
+		}
 
-		std::fstream in;
-		in.open(save_path_, std::ios::in | std::ios::binary);
-		if (in.is_open())
+		//     ,   .     
+		std::vector<RestoredMap*> session_maps;
+		for (auto& [map_id, map] : maps)
+		{
+			if (map.base_dogs.empty() && map.changed_dogs.empty())
+				continue;
+			map.session = std::make_shared<model::GameSession>(map.map);
+			map.players.resize(map.base_dogs.size() + map.changed_dogs.size());
+			session_maps.push_back(&map);
+		}
+		const auto& loot_section = base.GetLoot();
+		for (size_t i = 0; i < loot_section.size(); ++i)
+		{
+			RestoredMap* map = base_maps[loot_section[i].map];
+			if (map && map->session && !changes.removed_loot.contains(loot_section[i].object_id))
+				map->base_loot.push_back(i);
+		}
+		for (const auto& [map_id, added] : changes.added_loot)
 		{
+			RestoredMap* map = find_map(map_id);
+			if (!map || !map->session)
+				continue;
+			for (const auto& loot : added)
 			{
-				boost::archive::binary_iarchive ia{ in };
-				ia >> all_serialized_loot;
-				ia >> all_serialized_dogs;
-				ia >> all_serialized_players;
+				if (!changes.removed_loot.contains(loot.GetId()))
+					map->added_loot.push_back(&loot);
 			}
+		}
+
+		//     ,   .   id    
+		struct Chunk
+		{
+			RestoredMap* map;
+			bool players;
+			size_t begin;
+			size_t end;
+		};
+		std::vector<Chunk> chunks;
+		for (RestoredMap* map : session_maps)
+		{
+			map->loot.resize(map->base_loot.size() + map->added_loot.size());
+			for (size_t begin = 0; begin < map->players.size(); begin += RESTORE_CHUNK)
+				chunks.push_back({ map, true, begin, std::min(begin + RESTORE_CHUNK, map->players.size()) });
+			for (size_t begin = 0; begin < map->loot.size(); begin += RESTORE_CHUNK)
+				chunks.push_back({ map, false, begin, std::min(begin + RESTORE_CHUNK, map->loot.size()) });
+		}
 
-			if (all_serialized_dogs.empty() || all_serialized_players.empty())
+		//            
+		const int64_t clock_ms = changes.clock_ms;
+		std::vector<model::IdCounters> chunk_ids(chunks.size());
+		ParallelFor(chunks.size(), [&](size_t c) {
+			const Chunk& chunk = chunks[c];
+			RestoredMap& map = *chunk.map;
+			model::IdCounters& ids = chunk_ids[c];
+			for (size_t slot = chunk.begin; slot < chunk.end; ++slot)
 			{
-				in.close();
-				std::filesystem::remove(save_path_);
-				return;
+				if (!chunk.players)
+				{
+					map.loot[slot] = slot < map.base_loot.size()
+						? model::LootSer(loot_section[map.base_loot[slot]]).Restore(ids)
+						: map.added_loot[slot - map.base_loot.size()]->Restore(ids);
+					continue;
+				}
+
+				model::DogSer dog_ser;
+				model::PlayerSer player_ser;
+				if (slot < map.base_dogs.size())
+				{
+					size_t i = map.base_dogs[slot];
+					dog_ser = model::DogSer(dogs[i], base.GetBag(dogs[i]));
+					player_ser = model::PlayerSer(players[i], base);
+					dog_ser.AddElapsed(clock_ms);
+					player_ser.AddElapsed(clock_ms);
+				}
+				else
+				{
+					const auto& [id, changed] = map.changed_dogs[slot - map.base_dogs.size()];
+					const FoldedDeltas::Player& changed_player = changes.players.at(id);
+					dog_ser = changed->dog;
+					player_ser = changed_player.player;
+					dog_ser.AddElapsed(clock_ms - changed->written_at);
+					player_ser.AddElapsed(clock_ms - changed_player.written_at);
+				}
+				map.players[slot] = player_ser.Restore(map.session, dog_ser.Restore(ids), ids);
 			}
+			});
+
+		//        ,      
+		ParallelFor(session_maps.size(), [&](size_t m) {
+			RestoredMap& map = *session_maps[m];
+			map.session->ReserveDogs(map.players.size());
+			for (const auto& player : map.players)
+				map.session->AddDog(player->GetDog());
+			for (auto& loot : map.loot)
+				map.map->AddLoot(std::move(loot));
+			});
+
+		model::IdCounters ids;
+		for (const auto& chunk : chunk_ids)
+			ids.Merge(chunk);
+		ids.Reserve();
+		for (RestoredMap* map : session_maps)
+		{
+			restored.sessions.push_back(map->session);
+			restored.players.push_back(std::move(map->players));
 		}
-		in.close();
-		DataReconstruction(
-			app,
-			all_serialized_loot,
-			all_serialized_dogs,
-			all_serialized_players);
-		std::filesystem::remove(save_path_);
+
+		generation_ = generation;
+		checkpoint_ = restored_checkpoint_ = std::max(base.GetHeader().checkpoint, changes.checkpoint);
+		return restored;
 	}
 
 	void Serializator::SerializeOnTick
 	(std::chrono::milliseconds delta,
 		const std::unordered_map<std::string, std::shared_ptr<model::GameSession>>& sessions,
-		std::unordered_map<int, std::vector<std::shared_ptr<Player>>> players_to_session)
+		const std::unordered_map<int, std::vector<std::shared_ptr<Player>>>& players_to_session)
 	{
 		if (is_auto_save_ == false)
 			return;
 
+		clock_ += delta;
 		time_since_save_ += delta;
-		if (time_since_save_ >= save_period_)
+		if (time_since_save_ < save_period_)
+			return;
+		time_since_save_ = 0ms;
+
+		auto start = std::chrono::steady_clock::now();
+		//   ,    ,       :
+		//     
+		if (!has_base_ || delta_entities_ >= base_entities_ || writer_.NeedsBase() || writer_.IsBacklogged())
+			writer_.Enqueue(CaptureBase(sessions, players_to_session));
+		else
+			writer_.Enqueue(CaptureDelta(sessions, players_to_session));
+
+		uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		last_capture_us_.store(us, std::memory_order_relaxed);
+		if (us > max_capture_us_.load(std::memory_order_relaxed))
+			max_capture_us_.store(us, std::memory_order_relaxed);
+	}
+
+	save::Job Serializator::CaptureBase
+	(const std::unordered_map<std::string, std::shared_ptr<model::GameSession>>& sessions,
+		const std::unordered_map<int, std::vector<std::shared_ptr<Player>>>& players_to_session)
+	{
+		auto world = std::make_shared<WorldSer>();
+		world->generation = ++generation_;
+		world->checkpoint = ++checkpoint_;
+		//         
+		if (wal_)
+			wal_->StartSegment(checkpoint_);
+
+		//     :    
+		++pass_;
+		saved_dogs_.clear();
+		saved_loot_.clear();
+
+		for (const auto& session : sessions)
 		{
-			SerializeData(sessions, players_to_session);
-			time_since_save_ = 0ms;
+			auto players_it = players_to_session.find(session.second->GetObjectId());
+			auto map = session.second->GetMap();
+			const std::string& map_id = *map->GetId();
+
+			auto& saved_loot = saved_loot_[map_id];
+			for (const auto& l : map->GetMapLoot())
+			{
+				world->loot[map_id].push_back(model::LootSer(*l));
+				saved_loot.insert(l->GetId());
+			}
+
+			for (const auto& dog : session.second->GetDogs())
+			{
+				world->dogs[map_id][dog.first] = model::DogSer(*dog.second);
+				saved_dogs_[dog.first] = { map_id, dog.second->GetVersion(), pass_ };
+			}
+
+			if (players_it == players_to_session.end())
+				continue;
+			for (const auto& player : players_it->second)
+				world->players[map_id][player->GetObjectId()] = model::PlayerSer(*player);
 		}
+
+		has_base_ = true;
+		clock_ = 0ms;
+		base_entities_ = CountNested(world->loot) + CountNested(world->dogs) + CountNested(world->players);
+		delta_entities_ = 0;
+
+		return { true, [save_path = save_path_, delta_path = delta_path_, wal = wal_, world = std::move(world)] {
+			uint64_t bytes = WriteBase(save_path, delta_path, *world);
+			if (wal)
+				wal->DropSegmentsBefore(world->checkpoint);
+			return bytes;
+			} };
 	}
 
-	void Serializator::DataReconstruction(Application& app,
-		std::unordered_map<std::string, std::vector<model::LootSer>> all_serialized_loot,
-		std::unordered_map<std::string, std::unordered_map<int, model::DogSer>> all_serialized_dogs,
-		std::unordered_map<std::string, std::unordered_map<int, model::PlayerSer>> all_serialized_players)
+	save::Job Serializator::CaptureDelta
+	(const std::unordered_map<std::string, std::shared_ptr<model::GameSession>>& sessions,
+		const std::unordered_map<int, std::vector<std::shared_ptr<Player>>>& players_to_session)
 	{
-		for (const auto& [map_id, dogs] : all_serialized_dogs)
+		//      .      id  
+		auto delta = std::make_shared<CheckpointDelta>();
+		delta->generation = generation_;
+		delta->checkpoint = ++checkpoint_;
+		if (wal_)
+			wal_->StartSegment(checkpoint_);
+		delta->clock_ms = clock_.count();
+		++pass_;
+		size_t dogs_seen = 0;
+
+		for (const auto& [key, session] : sessions)
 		{
-			// 
-			auto map_ptr_shared = app.GetGame().FindMap(model::Map::Id(map_id));
-			std::shared_ptr<model::GameSession> session_ptr_shared = std::make_shared<model::GameSession>(map_ptr_shared);
-			//    
-			for (const auto& loot : all_serialized_loot[*map_ptr_shared->GetId()])
+			auto map = session->GetMap();
+			const std::string& map_id = *map->GetId();
+
+			auto& saved_loot = saved_loot_[map_id];
+			const auto& map_loot = map->GetMapLoot();
+			for (const auto& l : map_loot)
 			{
-				std::shared_ptr<model::Loot> l = loot.Restore();
-				map_ptr_shared->AddLoot(l);
+				if (saved_loot.insert(l->GetId()).second)
+					delta->added_loot[map_id].push_back(model::LootSer(*l));
+			}
+			//       .   ,  ,  
+			if (saved_loot.size() > map_loot.size())
+			{
+				std::unordered_set<int> current;
+				for (const auto& l : map_loot)
+					current.insert(l->GetId());
+				std::erase_if(saved_loot, [&](int id) {
+					if (current.contains(id))
+						return false;
+					delta->removed_loot[map_id].push_back(id);
+					return true;
+					});
 			}
 
-			//    ,  . object_id  = object_id 
-			for (const auto& dog : dogs)
+			auto players_it = players_to_session.find(session->GetObjectId());
+			if (players_it == players_to_session.end())
+				continue;
+			for (const auto& player : players_it->second)
 			{
-				std::shared_ptr<model::Dog> d = dog.second.Restore();
-				auto ser_player = all_serialized_players[*map_ptr_shared->GetId()][d->GetObjectId()];
-				std::shared_ptr<Player> pl = ser_player.Restore(session_ptr_shared, d);
-				session_ptr_shared->AddDog(d);
-				app.RestoreToken(Token(pl->GetPlayerToken()), pl);
-				app.AddPlayer(pl);
+				const auto& dog = player->GetDog();
+				auto [it, inserted] = saved_dogs_.try_emplace(dog->GetObjectId());
+				if (inserted)
+				{
+					it->second.map_id = map_id;
+					delta->players[map_id].emplace(player->GetObjectId(), model::PlayerSer(*player));
+				}
+				if (inserted || it->second.version != dog->GetVersion())
+				{
+					delta->dogs[map_id].emplace(dog->GetObjectId(), model::DogSer(*dog));
+					it->second.version = dog->GetVersion();
+				}
+				it->second.pass = pass_;
+				++dogs_seen;
 			}
-			app.GetGame().AddSession(session_ptr_shared, *map_ptr_shared->GetId());
 		}
+
+		if (dogs_seen < saved_dogs_.size())
+		{
+			std::erase_if(saved_dogs_, [&](const auto& saved) {
+				if (saved.second.pass == pass_)
+					return false;
+				delta->removed_dogs[saved.second.map_id].push_back(saved.first);
+				return true;
+				});
+		}
+
+		delta_entities_ += CountNested(delta->added_loot) + CountNested(delta->removed_loot) + CountNested(delta->dogs)
+			+ CountNested(delta->players) + CountNested(delta->removed_dogs);
+
+		//     :   ,    
+		return { false, [delta_path = delta_path_, wal = wal_, delta = std::move(delta)] {
+			uint64_t bytes = AppendDelta(delta_path, *delta);
+			if (wal)
+				wal->DropSegmentsBefore(delta->checkpoint);
+			return bytes;
+			} };
+	}
+
+	std::vector<CheckpointDelta> Serializator::ReadDeltas(uint64_t generation) const
+	{
+		std::vector<CheckpointDelta> deltas;
+		std::ifstream in(delta_path_, std::ios::in | std::ios::binary);
+		if (!in.is_open())
+			return deltas;
+
+		//      ,     
+		uint32_t header[2] = { 0, 0 };
+		std::string body;
+		while (in.read(reinterpret_cast<char*>(header), DELTA_HEADER_SIZE))
+		{
+			body.resize(header[0]);
+			if (!in.read(body.data(), static_cast<std::streamsize>(body.size())) || Checksum(body) != header[1])
+				break;
+
+			std::istringstream body_stream(body);
+			boost::archive::binary_iarchive ia{ body_stream, boost::archive::no_header };
+			CheckpointDelta delta;
+			ia >> delta;
+			if (delta.generation == generation)
+				deltas.push_back(std::move(delta));
+		}
+		return deltas;
 	}
\ No newline at end of file
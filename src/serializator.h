@@ -1,39 +1,155 @@
 #pragma once
 
 #include "model_serialization.h"
+#include "save_writer.h"
+#include "wal.h"
+#include <boost/serialization/version.hpp>
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <chrono>
 #include <filesystem>
+#include <unordered_set>
 
 using namespace std::chrono_literals;
 using namespace std::string_literals;
 
-class Application;
+//  :           
+struct RestoredWorld
+{
+	std::vector<std::shared_ptr<model::GameSession>> sessions;
+	// players[i] -   sessions[i]
+	std::vector<std::vector<std::shared_ptr<Player>>> players;
+};
+
+//    :     .
+// id   id  ,     
+struct CheckpointDelta
+{
+	//   ,    .      
+	uint64_t generation = 0;
+	//   .       
+	uint64_t checkpoint = 0;
+	//    .             
+	int64_t clock_ms = 0;
+	std::unordered_map<std::string, std::vector<model::LootSer>> added_loot;
+	std::unordered_map<std::string, std::vector<int>> removed_loot;
+	std::unordered_map<std::string, std::unordered_map<int, model::DogSer>> dogs;
+	std::unordered_map<std::string, std::unordered_map<int, model::PlayerSer>> players;
+	std::unordered_map<std::string, std::vector<int>> removed_dogs;
+
+	template <typename Archive>
+	void serialize(Archive& ar, const unsigned version) {
+		ar& generation;
+		if (version >= 1)
+			ar& checkpoint;
+		ar& clock_ms;
+		ar& added_loot;
+		ar& removed_loot;
+		ar& dogs;
+		ar& players;
+		ar& removed_dogs;
+	}
+};
 
+BOOST_CLASS_VERSION(CheckpointDelta, 1)
+
+//  :   save_path    save_format.h    save_path.delta.
+//          ,
+//      ,   ,   .
+//     , , fsync  rename    SaveWriter
 class Serializator
 {
 public:
 
 	Serializator() = default;
 	Serializator(bool is_auto_save, const std::chrono::milliseconds save_period, const std::filesystem::path save_path);
+	//   .    ,    std::logic_error
 	void SerializeData
 		(const std::unordered_map<std::string, std::shared_ptr<model::GameSession>>& sessions,
-		std::unordered_map<int, std::vector<std::shared_ptr<Player>>> players_to_session);
-	void DeserializeData(Application& app);
+		const std::unordered_map<int, std::vector<std::shared_ptr<Player>>>& players_to_session);
+	//    .           ,
+	//        .       .
+	//     ,  game    
+	RestoredWorld DeserializeData(const model::Game& game);
 	void SerializeOnTick
 		(std::chrono::milliseconds delta,
 		const std::unordered_map<std::string, std::shared_ptr<model::GameSession>>& sessions,
-		std::unordered_map<int, std::vector<std::shared_ptr<Player>>> players_to_session);
+		const std::unordered_map<int, std::vector<std::shared_ptr<Player>>>& players_to_session);
+
+	//  :        ,     -  
+	void SetWal(wal::WriteAheadLog* wal) noexcept
+	{
+		wal_ = wal;
+	}
+
+	// ,    .       
+	uint64_t GetRestoredCheckpoint() const noexcept
+	{
+		return restored_checkpoint_;
+	}
+
+	//      last:  ,   ,   
+	void ReserveCheckpoints(uint64_t last) noexcept
+	{
+		checkpoint_ = std::max(checkpoint_, last);
+	}
+
+	const save::SaveWriter& GetWriter() const noexcept
+	{
+		return writer_;
+	}
+
+	// ,      
+	uint64_t GetLastCaptureUs() const noexcept
+	{
+		return last_capture_us_.load(std::memory_order_relaxed);
+	}
+
+	uint64_t GetMaxCaptureUs() const noexcept
+	{
+		return max_capture_us_.load(std::memory_order_relaxed);
+	}
 
 private:
+	//     :   . pass -   ,      
+	struct SavedDog
+	{
+		std::string map_id;
+		uint64_t version = 0;
+		uint64_t pass = 0;
+	};
+
 	bool is_auto_save_;
 	const std::chrono::milliseconds save_period_;
 	std::filesystem::path save_path_;
-	std::filesystem::path temp_path_;
+	std::filesystem::path delta_path_;
 	std::chrono::milliseconds time_since_save_;
 
-	void DataReconstruction(Application& app,
-		std::unordered_map<std::string, std::vector<model::LootSer>> all_serialized_loot,
-		std::unordered_map<std::string, std::unordered_map<int, model::DogSer>> all_serialized_dogs,
-		std::unordered_map<std::string, std::unordered_map<int, model::PlayerSer>> all_serialized_players);
+	// ,   :   .    
+	bool has_base_ = false;
+	uint64_t generation_ = 0;
+	uint64_t checkpoint_ = 0;
+	uint64_t restored_checkpoint_ = 0;
+	wal::WriteAheadLog* wal_ = nullptr;
+	std::chrono::milliseconds clock_{ 0 };
+	uint64_t pass_ = 0;
+	//         . ,  ,   
+	size_t base_entities_ = 0;
+	size_t delta_entities_ = 0;
+	std::unordered_map<int, SavedDog> saved_dogs_;
+	std::unordered_map<std::string, std::unordered_set<int>> saved_loot_;
+
+	std::atomic<uint64_t> last_capture_us_{ 0 };
+	std::atomic<uint64_t> max_capture_us_{ 0 };
+	//  :     
+	save::SaveWriter writer_;
+
+	save::Job CaptureBase
+		(const std::unordered_map<std::string, std::shared_ptr<model::GameSession>>& sessions,
+		const std::unordered_map<int, std::vector<std::shared_ptr<Player>>>& players_to_session);
+	save::Job CaptureDelta
+		(const std::unordered_map<std::string, std::shared_ptr<model::GameSession>>& sessions,
+		const std::unordered_map<int, std::vector<std::shared_ptr<Player>>>& players_to_session);
+	std::vector<CheckpointDelta> ReadDeltas(uint64_t generation) const;
 };
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+
+namespace http_server
+{
+    // Глобальные счётчики сессий. По upstream_* видно, сколько раз сессии обращались к куче:
+    // в установившемся режиме keep-alive upstream_allocations почти не растёт вместе с requests
+    struct SessionStats
+    {
+        std::atomic<uint64_t> upstream_allocations{ 0 };
+        std::atomic<uint64_t> upstream_deallocations{ 0 };
+        std::atomic<uint64_t> upstream_bytes{ 0 };
+        std::atomic<uint64_t> requests{ 0 };
+        std::atomic<uint64_t> sessions_opened{ 0 };
+        std::atomic<int64_t> sessions_active{ 0 };
+        // Соединения, закрытые сразу после accept из-за предела max_connections
+        std::atomic<uint64_t> sessions_rejected{ 0 };
+        // Запросы, отклонённые из-за превышения header_limit/body_limit
+        std::atomic<uint64_t> requests_too_large{ 0 };
+        std::atomic<uint64_t> timeouts{ 0 };
+    };
+
+    inline SessionStats& GetSessionStats()
+    {
+        static SessionStats stats;
+        return stats;
+    }
+
+    // Передаёт запросы памяти в new/delete и считает их
+    class CountingResource : public std::pmr::memory_resource
+    {
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            auto& stats = GetSessionStats();
+            stats.upstream_allocations.fetch_add(1, std::memory_order_relaxed);
+            stats.upstream_bytes.fetch_add(bytes, std::memory_order_relaxed);
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override
+        {
+            GetSessionStats().upstream_deallocations.fetch_add(1, std::memory_order_relaxed);
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    // Память одного соединения: заголовки и тело запроса, объекты ответов.
+    // Освобождённые блоки остаются в пулах и переиспользуются следующими запросами.
+    // Пул синхронизированный - ответ API собирается на api_strand, пока сессия читает сокет
+    class SessionArena : public std::pmr::memory_resource
+    {
+    public:
+        SessionArena() : pool_(std::pmr::pool_options{ .max_blocks_per_chunk = 16, .largest_required_pool_block = 64 * 1024 }, &upstream_) {}
+        SessionArena(const SessionArena&) = delete;
+        SessionArena& operator=(const SessionArena&) = delete;
+
+    private:
+        CountingResource upstream_;
+        std::pmr::synchronized_pool_resource pool_;
+
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            return pool_.allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override
+        {
+            pool_.deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    // Аналог std::pmr::polymorphic_allocator, но с присваиванием (этого требует beast::http::basic_fields)
+    // и с владением ареной: запрос может пережить сессию, если его уничтожает обработчик на другом потоке
+    template <typename T>
+    class ArenaAllocator
+    {
+    public:
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        // Без арены память берётся из ресурса по умолчанию, владения нет
+        ArenaAllocator() noexcept : resource_(std::shared_ptr<void>{}, std::pmr::get_default_resource()) {}
+        explicit ArenaAllocator(std::shared_ptr<std::pmr::memory_resource> resource) noexcept : resource_(std::move(resource)) {}
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) noexcept : resource_(other.GetResource()) {}
+
+        T* allocate(size_t n)
+        {
+            return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* p, size_t n) noexcept
+        {
+            resource_->deallocate(p, n * sizeof(T), alignof(T));
+        }
+
+        const std::shared_ptr<std::pmr::memory_resource>& GetResource() const noexcept
+        {
+            return resource_;
+        }
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U>& other) const noexcept
+        {
+            return resource_ == other.GetResource() || resource_->is_equal(*other.GetResource());
+        }
+
+    private:
+        std::shared_ptr<std::pmr::memory_resource> resource_;
+    };
+}
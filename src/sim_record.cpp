@@ -0,0 +1,218 @@
+#include "sim_record.h"
+#include "binary_codec.h"
+
+#include <boost/crc.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace sim_record
+{
+    namespace
+    {
+        using codec::Get;
+        using codec::GetInt;
+        using codec::GetString;
+        using codec::Put;
+        using codec::PutString;
+
+        // Заголовок: метка, версия, флаги, CRC конфига, резерв, зерно
+        constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 4 * sizeof(uint32_t) + sizeof(uint64_t);
+        constexpr uint32_t FLAG_RANDOMIZE_SPAWN_POINTS = 1;
+        constexpr size_t BUFFER_SIZE = 64 << 10;
+
+        enum class RecordType : uint8_t
+        {
+            JOIN = 1,
+            ACTION = 2,
+            TICK = 3
+        };
+
+        void EncodeBody(const Join& r, std::string& out)
+        {
+            Put(out, RecordType::JOIN);
+            Put<int32_t>(out, r.dog_id);
+            PutString(out, r.map_id);
+            PutString(out, r.name);
+        }
+
+        void EncodeBody(const Action& r, std::string& out)
+        {
+            Put(out, RecordType::ACTION);
+            Put<int32_t>(out, r.dog_id);
+            Put(out, r.move);
+        }
+
+        void EncodeBody(const Tick& r, std::string& out)
+        {
+            Put(out, RecordType::TICK);
+            Put<int64_t>(out, r.delta_ms);
+            Put<uint64_t>(out, r.digest);
+        }
+
+        bool DecodeBody(std::string_view& in, Join& r)
+        {
+            return GetInt(in, r.dog_id) && GetString(in, r.map_id) && GetString(in, r.name);
+        }
+
+        bool DecodeBody(std::string_view& in, Action& r)
+        {
+            return GetInt(in, r.dog_id) && Get(in, r.move);
+        }
+
+        bool DecodeBody(std::string_view& in, Tick& r)
+        {
+            return Get(in, r.delta_ms) && Get(in, r.digest);
+        }
+
+        template <typename T>
+        bool DecodeAs(std::string_view& in, Record& record)
+        {
+            T r;
+            if (!DecodeBody(in, r))
+                return false;
+            record = std::move(r);
+            return true;
+        }
+
+        // false, если запись не поместилась в in целиком
+        bool Decode(std::string_view& in, Record& record)
+        {
+            RecordType type;
+            if (!Get(in, type))
+                return false;
+            switch (type)
+            {
+            case RecordType::JOIN:
+                return DecodeAs<Join>(in, record);
+            case RecordType::ACTION:
+                return DecodeAs<Action>(in, record);
+            case RecordType::TICK:
+                return DecodeAs<Tick>(in, record);
+            }
+            throw std::runtime_error("Unknown record type in the simulation journal");
+        }
+    }
+
+    uint32_t HashConfig(const std::filesystem::path& config_path)
+    {
+        std::FILE* file = std::fopen(config_path.string().c_str(), "rb");
+        if (!file)
+            throw std::runtime_error("Can't open the config file: "s + config_path.string());
+        boost::crc_32_type crc;
+        char chunk[1 << 14];
+        size_t read;
+        while ((read = std::fread(chunk, 1, sizeof(chunk), file)) != 0)
+            crc.process_bytes(chunk, read);
+        std::fclose(file);
+        return crc.checksum();
+    }
+
+    Recorder::Recorder(const std::filesystem::path& path, const Header& header)
+    {
+        if (path.has_parent_path())
+            std::filesystem::create_directories(path.parent_path());
+        file_ = std::fopen(path.string().c_str(), "wb");
+        if (!file_)
+            throw std::runtime_error("Can't open the simulation journal: "s + path.string());
+
+        buffer_.reserve(BUFFER_SIZE);
+        buffer_.append(MAGIC, sizeof(MAGIC));
+        Put<uint32_t>(buffer_, VERSION);
+        Put<uint32_t>(buffer_, header.randomize_spawn_points ? FLAG_RANDOMIZE_SPAWN_POINTS : 0);
+        Put<uint32_t>(buffer_, header.config_crc);
+        Put<uint32_t>(buffer_, 0);
+        Put<uint64_t>(buffer_, header.seed);
+        if (!WriteBuffer())
+        {
+            std::fclose(file_);
+            throw std::runtime_error("Can't write the simulation journal: "s + path.string());
+        }
+    }
+
+    Recorder::~Recorder()
+    {
+        WriteBuffer();
+        std::fclose(file_);
+    }
+
+    void Recorder::Append(const Record& record)
+    {
+        std::visit([this](const auto& r) { EncodeBody(r, buffer_); }, record);
+        ++records_;
+        if (buffer_.size() >= BUFFER_SIZE && !WriteBuffer())
+            throw std::runtime_error("Can't write the simulation journal");
+    }
+
+    bool Recorder::WriteBuffer()
+    {
+        bool ok = std::fwrite(buffer_.data(), 1, buffer_.size(), file_) == buffer_.size() && std::fflush(file_) == 0;
+        buffer_.clear();
+        return ok;
+    }
+
+    Reader::Reader(const std::filesystem::path& path)
+    {
+        file_ = std::fopen(path.string().c_str(), "rb");
+        if (!file_)
+            throw std::runtime_error("Can't open the simulation journal: "s + path.string());
+
+        while (buffer_.size() < HEADER_SIZE && Fill())
+            ;
+        std::string_view in = buffer_;
+        uint32_t version = 0;
+        uint32_t flags = 0;
+        uint32_t reserved = 0;
+        if (in.size() < HEADER_SIZE || std::memcmp(in.data(), MAGIC, sizeof(MAGIC)) != 0)
+        {
+            std::fclose(file_);
+            throw std::runtime_error("Not a simulation journal: "s + path.string());
+        }
+        in.remove_prefix(sizeof(MAGIC));
+        Get(in, version);
+        Get(in, flags);
+        Get(in, header_.config_crc);
+        Get(in, reserved);
+        Get(in, header_.seed);
+        if (version != VERSION)
+        {
+            std::fclose(file_);
+            throw std::runtime_error("Unsupported simulation journal version "s + std::to_string(version));
+        }
+        header_.randomize_spawn_points = (flags & FLAG_RANDOMIZE_SPAWN_POINTS) != 0;
+        pos_ = HEADER_SIZE;
+    }
+
+    Reader::~Reader()
+    {
+        std::fclose(file_);
+    }
+
+    bool Reader::Next(Record& record)
+    {
+        while (true)
+        {
+            std::string_view in(buffer_.data() + pos_, buffer_.size() - pos_);
+            if (Decode(in, record))
+            {
+                pos_ = buffer_.size() - in.size();
+                return true;
+            }
+            if (!Fill())
+                return false;
+        }
+    }
+
+    bool Reader::Fill()
+    {
+        buffer_.erase(0, pos_);
+        pos_ = 0;
+        size_t size = buffer_.size();
+        buffer_.resize(size + BUFFER_SIZE);
+        size_t read = std::fread(buffer_.data() + size, 1, BUFFER_SIZE, file_);
+        buffer_.resize(size + read);
+        return read != 0;
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <variant>
+
+namespace sim_record
+{
+    // Запись симуляции: конфиг, зерно генераторов и все команды, менявшие мир, начиная с пустого мира.
+    // Те же команды с тем же конфигом и зерном на той же сборке повторяют мир бит в бит
+    inline constexpr char MAGIC[8] = { 'G', 'S', 'R', 'E', 'C', 'O', 'R', 'D' };
+    inline constexpr uint32_t VERSION = 1;
+
+    struct Header
+    {
+        // CRC32 файла конфигурации
+        uint32_t config_crc = 0;
+        uint64_t seed = 0;
+        bool randomize_spawn_points = false;
+    };
+
+    // По dog_id повтор проверяет, что собака получила тот же id, и находит её в следующих командах
+    struct Join
+    {
+        int dog_id = 0;
+        std::string map_id;
+        std::string name;
+    };
+
+    // move - направление или 0 для остановки
+    struct Action
+    {
+        int dog_id = 0;
+        char move = 0;
+    };
+
+    // digest - Game::GetStateDigest после тика и ухода простаивающих игроков
+    struct Tick
+    {
+        int64_t delta_ms = 0;
+        uint64_t digest = 0;
+    };
+
+    using Record = std::variant<Join, Action, Tick>;
+
+    uint32_t HashConfig(const std::filesystem::path& config_path);
+
+    // Пишет журнал через буфер. Вызывается на strand симуляции
+    class Recorder
+    {
+    public:
+        Recorder(const std::filesystem::path& path, const Header& header);
+        Recorder(const Recorder&) = delete;
+        Recorder& operator=(const Recorder&) = delete;
+        // Дописывает буфер
+        ~Recorder();
+
+        void Append(const Record& record);
+
+        uint64_t GetRecords() const noexcept
+        {
+            return records_;
+        }
+
+    private:
+        // false при ошибке записи. Буфер очищается в любом случае
+        bool WriteBuffer();
+
+        std::FILE* file_ = nullptr;
+        std::string buffer_;
+        uint64_t records_ = 0;
+    };
+
+    // Читает журнал по записи. Оборванная при падении последняя запись считается концом журнала
+    class Reader
+    {
+    public:
+        // Чужой файл или другая версия - std::runtime_error
+        explicit Reader(const std::filesystem::path& path);
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        ~Reader();
+
+        const Header& GetHeader() const noexcept
+        {
+            return header_;
+        }
+
+        // false в конце журнала
+        bool Next(Record& record);
+
+    private:
+        bool Fill();
+
+        std::FILE* file_ = nullptr;
+        Header header_;
+        std::string buffer_;
+        size_t pos_ = 0;
+    };
+}
@@ -0,0 +1,61 @@
+#include "state_snapshot.h"
+#include "json_support.h"
+
+#include <boost/asio/post.hpp>
+
+#include <cassert>
+
+namespace state_snapshot
+{
+    const SessionView* Snapshot::Find(std::string_view token) const
+    {
+        if (auto it = by_token.find(token); it != by_token.end())
+            return it->second.get();
+        return nullptr;
+    }
+
+    void SnapshotPublisher::Schedule()
+    {
+        if (GetCurrent() || scheduled_.exchange(true))
+            return;
+        net::post(strand_, [self = shared_from_this()] {
+            self->scheduled_ = false;
+            self->Publish();
+            });
+    }
+
+    std::shared_ptr<const Snapshot> SnapshotPublisher::GetCurrent() const
+    {
+        std::shared_lock lock{ mutex_ };
+        if (!snapshot_)
+            return nullptr;
+        if (snapshot_->version == app_.GetStateVersion())
+            return snapshot_;
+        if (options_.max_age.count() > 0 && std::chrono::steady_clock::now() - snapshot_->published_at <= options_.max_age)
+            return snapshot_;
+        return nullptr;
+    }
+
+    void SnapshotPublisher::Publish()
+    {
+        assert(strand_.running_in_this_thread());
+        auto snapshot = std::make_shared<Snapshot>();
+        snapshot->version = app_.GetStateVersion();
+        snapshot->published_at = std::chrono::steady_clock::now();
+
+        for (const auto& [session_id, players] : app_.GetAllPlayersBySessions())
+        {
+            if (players.empty())
+                continue;
+            auto view = std::make_shared<SessionView>();
+            view->state = json_support::GetFormattedJSONStr(json_support::MakeJSONStateGame(players.front()->GetSession(), players));
+            view->players = json_support::GetFormattedJSONStr(json_support::MakeJSONPlayerList(players));
+            for (const auto& player : players)
+                snapshot->by_token.emplace(player->GetPlayerToken(), view);
+        }
+
+        std::unique_lock lock{ mutex_ };
+        snapshot_ = std::move(snapshot);
+        published_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
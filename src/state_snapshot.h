@@ -0,0 +1,89 @@
+#pragma once
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "application.h"
+
+namespace state_snapshot
+{
+    namespace net = boost::asio;
+    using Strand = net::strand<net::io_context::executor_type>;
+
+    // Готовые тела ответов state и players для одной игровой сессии
+    struct SessionView
+    {
+        std::string state;
+        std::string players;
+    };
+
+    // Неизменяемый снимок всех сессий на момент version. Доступ к сессии - по токену игрока
+    struct Snapshot
+    {
+        struct StringHasher
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view str) const noexcept
+            {
+                return std::hash<std::string_view>{}(str);
+            }
+        };
+
+        uint64_t version = 0;
+        std::chrono::steady_clock::time_point published_at;
+        std::unordered_map<std::string, std::shared_ptr<const SessionView>, StringHasher, std::equal_to<>> by_token;
+
+        // nullptr, если игрока с таким токеном нет
+        const SessionView* Find(std::string_view token) const;
+    };
+
+    struct Options
+    {
+        // Сколько отдавать последний снимок после изменений модели. Ноль - только снимок текущей версии:
+        // без тикера состояние меняют только запросы, и клиент должен сразу видеть результат своих действий
+        std::chrono::milliseconds max_age{ 0 };
+    };
+
+    // Собирает снимок на strand симуляции и публикует его для чтения с IO-потоков.
+    // С тикером снимок публикуется раз в тик и отдаётся, пока не старше max_age,
+    // иначе запрос выполняется на strand как раньше
+    class SnapshotPublisher : public std::enable_shared_from_this<SnapshotPublisher>
+    {
+    public:
+        SnapshotPublisher(Application& app, Strand& strand, Options options = {})
+            : app_(app), strand_(strand), options_(options) {}
+        SnapshotPublisher(const SnapshotPublisher&) = delete;
+        SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+        // Ставит сборку снимка в конец очереди strand, если действующего снимка нет. Серия изменений подряд даёт одну сборку
+        void Schedule();
+
+        // Собирает и публикует снимок сразу. Вызывается на strand, тикером после каждого тика
+        void Publish();
+
+        // Снимок текущей версии модели, с max_age - достаточно свежий, или nullptr
+        std::shared_ptr<const Snapshot> GetCurrent() const;
+
+        uint64_t GetPublishedCount() const noexcept
+        {
+            return published_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        Application& app_;
+        Strand& strand_;
+        Options options_;
+        mutable std::shared_mutex mutex_;
+        std::shared_ptr<const Snapshot> snapshot_;
+        std::atomic<bool> scheduled_{ false };
+        std::atomic<uint64_t> published_{ 0 };
+    };
+}
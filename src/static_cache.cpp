@@ -0,0 +1,365 @@
+#include "static_cache.h"
+#include "compression.h"
+#include "etag.h"
+#include "log_data.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace static_cache
+{
+    using namespace std::literals;
+
+    namespace
+    {
+        std::time_t ToTimeT(fs::file_time_type time)
+        {
+            auto system_time = std::chrono::file_clock::to_sys(time);
+            return std::chrono::system_clock::to_time_t(
+                std::chrono::time_point_cast<std::chrono::system_clock::duration>(system_time));
+        }
+
+        std::shared_ptr<const std::string> CompressOrNull(const std::string& content, compression::Encoding encoding)
+        {
+            std::string packed = compression::Compress(content, encoding, compression::Level::BEST);
+            if (packed.size() >= content.size())
+                return nullptr;
+            return std::make_shared<const std::string>(std::move(packed));
+        }
+    }
+
+    std::optional<std::string> NormalizePath(std::string_view decoded_path)
+    {
+        std::vector<std::string_view> segments;
+        while (!decoded_path.empty())
+        {
+            size_t slash = decoded_path.find('/');
+            std::string_view segment = decoded_path.substr(0, slash);
+            decoded_path = slash == std::string_view::npos ? ""sv : decoded_path.substr(slash + 1);
+
+            if (segment.empty() || segment == "."sv)
+                continue;
+            if (segment == ".."sv)
+            {
+                // Попытка выйти за пределы --www-root
+                if (segments.empty())
+                    return std::nullopt;
+                segments.pop_back();
+                continue;
+            }
+            segments.push_back(segment);
+        }
+
+        std::string normalized;
+        for (auto segment : segments)
+        {
+            normalized.push_back('/');
+            normalized.append(segment);
+        }
+        if (normalized.empty())
+            normalized.push_back('/');
+        return normalized;
+    }
+
+    std::string FormatHttpDate(std::time_t time)
+    {
+        std::tm tm{};
+#ifdef _WIN32
+        gmtime_s(&tm, &time);
+#else
+        gmtime_r(&time, &tm);
+#endif
+        char buffer[64];
+        size_t size = std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+        return std::string(buffer, size);
+    }
+
+    std::optional<std::time_t> ParseHttpDate(std::string_view date)
+    {
+        std::tm tm{};
+        std::istringstream input{ std::string(date) };
+        input.imbue(std::locale::classic());
+        input >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S");
+        if (input.fail())
+            return std::nullopt;
+#ifdef _WIN32
+        return _mkgmtime(&tm);
+#else
+        return timegm(&tm);
+#endif
+    }
+
+    RangeStatus ParseRange(std::string_view header, uintmax_t size, ByteRange& range)
+    {
+        constexpr auto prefix = "bytes="sv;
+        if (!header.starts_with(prefix))
+            return RangeStatus::NONE;
+        header.remove_prefix(prefix.size());
+        if (header.find(',') != std::string_view::npos)
+            return RangeStatus::NONE;
+
+        size_t dash = header.find('-');
+        if (dash == std::string_view::npos)
+            return RangeStatus::NONE;
+
+        auto parse_number = [](std::string_view str, uintmax_t& value) {
+            auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+            return !str.empty() && ec == std::errc{} && ptr == str.data() + str.size();
+            };
+
+        std::string_view first = header.substr(0, dash);
+        std::string_view last = header.substr(dash + 1);
+        uintmax_t first_value = 0;
+        uintmax_t last_value = 0;
+
+        if (first.empty())
+        {
+            // bytes=-n - последние n байт
+            if (!parse_number(last, last_value))
+                return RangeStatus::NONE;
+            if (last_value == 0 || size == 0)
+                return RangeStatus::UNSATISFIABLE;
+            range.first = last_value >= size ? 0 : size - last_value;
+            range.last = size - 1;
+            return RangeStatus::SATISFIABLE;
+        }
+
+        if (!parse_number(first, first_value))
+            return RangeStatus::NONE;
+        if (last.empty())
+            last_value = size == 0 ? 0 : size - 1;
+        else if (!parse_number(last, last_value) || last_value < first_value)
+            return RangeStatus::NONE;
+
+        if (first_value >= size)
+            return RangeStatus::UNSATISFIABLE;
+        range.first = first_value;
+        range.last = std::min(last_value, size - 1);
+        return RangeStatus::SATISFIABLE;
+    }
+
+    StaticCache::StaticCache(fs::path root, Options options)
+        : root_(fs::weakly_canonical(root))
+        , options_(options)
+    {
+        LoadAll();
+    }
+
+    StaticCache::~StaticCache()
+    {
+#ifdef __linux__
+        if (watcher_.joinable())
+        {
+            watcher_.request_stop();
+            uint64_t value = 1;
+            [[maybe_unused]] auto written = ::write(stop_fd_, &value, sizeof(value));
+            watcher_.join();
+        }
+        if (stop_fd_ >= 0)
+            ::close(stop_fd_);
+#endif
+    }
+
+    std::shared_ptr<const Asset> StaticCache::Find(std::string_view normalized_path) const
+    {
+        std::shared_lock lock{ mutex_ };
+        if (auto it = assets_.find(normalized_path); it != assets_.end())
+            return it->second;
+        return nullptr;
+    }
+
+    const Options& StaticCache::GetOptions() const noexcept
+    {
+        return options_;
+    }
+
+    void StaticCache::LoadAll()
+    {
+        std::unordered_map<std::string, std::shared_ptr<const Asset>, StringHasher, std::equal_to<>> assets;
+        for (const auto& entry : fs::recursive_directory_iterator(root_))
+        {
+            if (!entry.is_regular_file() || !IsUnderRoot(entry.path()))
+                continue;
+            if (auto asset = LoadAsset(entry.path()))
+                assets.emplace(ToRequestPath(entry.path()), std::move(asset));
+        }
+
+        std::unique_lock lock{ mutex_ };
+        assets_ = std::move(assets);
+    }
+
+    void StaticCache::Refresh(const fs::path& file_path)
+    {
+        std::error_code ec;
+        std::shared_ptr<const Asset> asset;
+        if (fs::is_regular_file(file_path, ec) && IsUnderRoot(file_path))
+            asset = LoadAsset(file_path);
+
+        std::string request_path = ToRequestPath(file_path);
+        std::unique_lock lock{ mutex_ };
+        if (asset)
+            assets_.insert_or_assign(std::move(request_path), std::move(asset));
+        else if (auto it = assets_.find(request_path); it != assets_.end())
+            assets_.erase(it);
+    }
+
+    bool StaticCache::IsUnderRoot(const fs::path& file_path) const
+    {
+        // Символическая ссылка внутри корня может вести за его пределы
+        std::error_code ec;
+        fs::path path = fs::weakly_canonical(file_path, ec);
+        if (ec)
+            return false;
+        auto [root_end, path_it] = std::mismatch(root_.begin(), root_.end(), path.begin(), path.end());
+        return root_end == root_.end();
+    }
+
+    std::string StaticCache::ToRequestPath(const fs::path& file_path) const
+    {
+        return "/"s + file_path.lexically_relative(root_).generic_string();
+    }
+
+    std::shared_ptr<const Asset> StaticCache::LoadAsset(const fs::path& file_path) const
+    {
+        auto extension = supported_extensions.find(file_path.extension().string());
+        if (extension == supported_extensions.end())
+            return nullptr;
+
+        std::error_code ec;
+        auto asset = std::make_shared<Asset>();
+        asset->file_path = file_path;
+        asset->content_type = extension->second;
+        asset->size = fs::file_size(file_path, ec);
+        if (ec)
+            return nullptr;
+        auto write_time = fs::last_write_time(file_path, ec);
+        if (ec)
+            return nullptr;
+        asset->modified = ToTimeT(write_time);
+        asset->last_modified = FormatHttpDate(asset->modified);
+
+        if (asset->size > options_.max_in_memory_file_size)
+        {
+            // Большой файл не читаем, ETag строим по размеру и времени изменения
+            std::ostringstream tag;
+            tag << '"' << std::hex << asset->size << '-' << asset->modified << '"';
+            asset->etag = tag.str();
+            return asset;
+        }
+
+        std::ifstream input(file_path, std::ios::binary);
+        std::string content(static_cast<size_t>(asset->size), '\0');
+        if (!input.read(content.data(), content.size()))
+            return nullptr;
+
+        asset->etag = etag::MakeStrongETag(content);
+        if (compression::IsCompressibleContentType(asset->content_type))
+        {
+            asset->gzip = CompressOrNull(content, compression::Encoding::GZIP);
+            asset->brotli = CompressOrNull(content, compression::Encoding::BROTLI);
+        }
+        asset->body = std::make_shared<const std::string>(std::move(content));
+        return asset;
+    }
+
+    void StaticCache::StartWatching()
+    {
+#ifdef __linux__
+        if (watcher_.joinable())
+            return;
+        stop_fd_ = ::eventfd(0, EFD_CLOEXEC);
+        if (stop_fd_ < 0)
+            throw std::runtime_error("Can't create eventfd for static files watcher");
+        watcher_ = std::jthread([this](std::stop_token stop) {
+            WatchLoop(stop);
+            });
+#else
+        BOOST_LOG_TRIVIAL(warning) << boost::log::add_value(data, boost::json::object{
+            {"message", "static files watching is supported only on Linux"}
+            });
+#endif
+    }
+
+    void StaticCache::WatchLoop(std::stop_token stop)
+    {
+#ifdef __linux__
+        int inotify_fd = ::inotify_init1(IN_CLOEXEC);
+        if (inotify_fd < 0)
+        {
+            BOOST_LOG_TRIVIAL(error) << boost::log::add_value(data, boost::json::object{
+                {"message", "static files watcher failed to start"},
+                {"data", boost::json::object{ {"error", std::error_code(errno, std::system_category()).message()} }}
+                });
+            return;
+        }
+
+        constexpr uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+        std::unordered_map<int, fs::path> watched_dirs;
+        auto add_watch = [&](const fs::path& dir) {
+            int wd = ::inotify_add_watch(inotify_fd, dir.c_str(), mask);
+            if (wd >= 0)
+                watched_dirs[wd] = dir;
+            };
+
+        add_watch(root_);
+        for (const auto& entry : fs::recursive_directory_iterator(root_))
+        {
+            if (entry.is_directory())
+                add_watch(entry.path());
+        }
+
+        alignas(inotify_event) char buffer[16 * 1024];
+        while (!stop.stop_requested())
+        {
+            pollfd fds[2] = { { inotify_fd, POLLIN, 0 }, { stop_fd_, POLLIN, 0 } };
+            if (::poll(fds, 2, -1) < 0 || (fds[1].revents & POLLIN))
+                break;
+
+            ssize_t length = ::read(inotify_fd, buffer, sizeof(buffer));
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                auto dir = watched_dirs.find(event->wd);
+                if (dir == watched_dirs.end() || event->len == 0)
+                    continue;
+                fs::path path = dir->second / event->name;
+
+                try
+                {
+                    if (event->mask & IN_ISDIR)
+                    {
+                        if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                            add_watch(path);
+                        continue;
+                    }
+                    // IN_CREATE без IN_CLOSE_WRITE - файл ещё пишется, дождёмся закрытия
+                    if (event->mask & IN_CREATE)
+                        continue;
+                    Refresh(path);
+                }
+                catch (const std::exception& ex)
+                {
+                    BOOST_LOG_TRIVIAL(error) << boost::log::add_value(data, boost::json::object{
+                        {"message", "static file refresh failed"},
+                        {"data", boost::json::object{ {"path", path.string()}, {"error", ex.what()} }}
+                        });
+                }
+            }
+        }
+        ::close(inotify_fd);
+#endif
+    }
+}
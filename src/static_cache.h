@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include "content_type.h"
+
+namespace static_cache
+{
+    namespace fs = std::filesystem;
+
+    inline const std::unordered_map<std::string, std::string_view> supported_extensions = {
+        { ".json", ContentType::TEXT_JSON },
+        { ".htm",  ContentType::TEXT_HTML },
+        { ".html",  ContentType::TEXT_HTML },
+        { ".css",  ContentType::TEXT_CSS },
+        { ".txt",  ContentType::TEXT_TXT },
+        { ".js",  ContentType::TEXT_JS },
+        { ".xml",  ContentType::TEXT_XML },
+        { ".png",  ContentType::TEXT_PNG },
+        { ".jpg",  ContentType::TEXT_JPG },
+        { ".jpe",  ContentType::TEXT_JPG },
+        { ".jpeg",  ContentType::TEXT_JPG },
+        { ".gif",  ContentType::TEXT_GIF },
+        { ".bmp",  ContentType::TEXT_BMP },
+        { ".ico",  ContentType::TEXT_ICO },
+        { ".tiff",  ContentType::TEXT_TIF },
+        { ".tif",  ContentType::TEXT_TIF },
+        { ".svg",  ContentType::TEXT_SVG },
+        { ".svgz",  ContentType::TEXT_SVG },
+        { ".mp3",  ContentType::TEXT_MP3 },
+        { ".fbx", ContentType::TEXT_UNKNOWN },
+        { ".obj", ContentType::TEXT_UNKNOWN},
+        { ".webmanifest", ContentType::TEXT_UNKNOWN}
+    };
+
+    struct Options
+    {
+        // Файлы крупнее этого размера не читаются в память и отдаются с диска (sendfile на Linux)
+        uintmax_t max_in_memory_file_size = 4 * 1024 * 1024;
+        // 0 - клиент обязан перепроверять ресурс (no-cache), иначе public, max-age
+        unsigned max_age_seconds = 0;
+    };
+
+    // Неизменяемое описание файла из --www-root. При изменении файла заменяется целиком
+    struct Asset
+    {
+        fs::path file_path;
+        std::string_view content_type;
+        uintmax_t size = 0;
+        std::time_t modified = 0;
+        std::string etag;
+        std::string last_modified;
+        // nullptr - файл большой и отдаётся с диска
+        std::shared_ptr<const std::string> body;
+        // nullptr - сжатие не дало выигрыша или файл не текстовый
+        std::shared_ptr<const std::string> gzip;
+        std::shared_ptr<const std::string> brotli;
+    };
+
+    // Диапазон байт [first, last] включительно, как в заголовке Content-Range
+    struct ByteRange
+    {
+        uintmax_t first = 0;
+        uintmax_t last = 0;
+    };
+
+    enum class RangeStatus
+    {
+        // Заголовка нет, он некорректен или содержит несколько диапазонов - отдаётся весь файл
+        NONE,
+        SATISFIABLE,
+        UNSATISFIABLE
+    };
+
+    // Путь запроса без . и .., всегда начинается с '/'. nullopt - путь выходит за пределы корня
+    std::optional<std::string> NormalizePath(std::string_view decoded_path);
+    std::string FormatHttpDate(std::time_t time);
+    std::optional<std::time_t> ParseHttpDate(std::string_view date);
+    // Разбирает Range: bytes=a-b, bytes=a-, bytes=-n для файла размером size
+    RangeStatus ParseRange(std::string_view header, uintmax_t size, ByteRange& range);
+
+    // Кэш статических файлов. Все файлы с поддерживаемыми расширениями загружаются при старте,
+    // текстовые сразу сжимаются. Поиск - по нормализованному пути запроса
+    class StaticCache
+    {
+    public:
+        StaticCache(fs::path root, Options options);
+        StaticCache(const StaticCache&) = delete;
+        StaticCache& operator=(const StaticCache&) = delete;
+        ~StaticCache();
+
+        std::shared_ptr<const Asset> Find(std::string_view normalized_path) const;
+        const Options& GetOptions() const noexcept;
+
+        // Запускает фоновый поток, перечитывающий изменённые файлы (inotify, только Linux)
+        void StartWatching();
+
+    private:
+        struct StringHasher
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view str) const noexcept
+            {
+                return std::hash<std::string_view>{}(str);
+            }
+        };
+
+        fs::path root_;
+        Options options_;
+        mutable std::shared_mutex mutex_;
+        std::unordered_map<std::string, std::shared_ptr<const Asset>, StringHasher, std::equal_to<>> assets_;
+
+        std::jthread watcher_;
+        int stop_fd_ = -1;
+
+        void LoadAll();
+        // Перечитывает файл, либо удаляет его из кэша, если файла больше нет
+        void Refresh(const fs::path& file_path);
+        // Файл после разрешения символических ссылок лежит внутри root_
+        bool IsUnderRoot(const fs::path& file_path) const;
+        std::string ToRequestPath(const fs::path& file_path) const;
+        std::shared_ptr<const Asset> LoadAsset(const fs::path& file_path) const;
+        void WatchLoop(std::stop_token stop);
+    };
+}
@@ -0,0 +1,75 @@
+#include "tick_profiler.h"
+
+namespace tick_profile
+{
+    namespace
+    {
+        constexpr std::string_view PHASE_NAMES[] = {
+            "playtime",
+            "loot",
+            "movement",
+            "gather",
+            "commandLog",
+            "retirement",
+            "dbWrite",
+            "serialization",
+            "tick"
+        };
+        static_assert(std::size(PHASE_NAMES) == static_cast<size_t>(Phase::COUNT));
+
+        constexpr Phase FIRST_MAP_PHASE = Phase::LOOT;
+        constexpr Phase LAST_MAP_PHASE = Phase::GATHER;
+
+        uint64_t ToNs(std::chrono::nanoseconds time)
+        {
+            return time.count() < 0 ? 0 : static_cast<uint64_t>(time.count());
+        }
+    }
+
+    std::string_view GetPhaseName(Phase phase)
+    {
+        return PHASE_NAMES[static_cast<size_t>(phase)];
+    }
+
+    TickProfiler::TickProfiler(std::vector<std::string> map_ids)
+        : map_ids_(std::move(map_ids))
+        , maps_(map_ids_.size())
+    {
+        static_assert(static_cast<size_t>(LAST_MAP_PHASE) - static_cast<size_t>(FIRST_MAP_PHASE) + 1 == MAP_PHASES);
+    }
+
+    void TickProfiler::Record(Phase phase, std::chrono::nanoseconds time) noexcept
+    {
+        phases_[static_cast<size_t>(phase)].Record(ToNs(time));
+    }
+
+    void TickProfiler::Record(size_t map_index, Phase phase, std::chrono::nanoseconds time) noexcept
+    {
+        Record(phase, time);
+        if (map_index < maps_.size() && phase >= FIRST_MAP_PHASE && phase <= LAST_MAP_PHASE)
+            maps_[map_index][static_cast<size_t>(phase) - static_cast<size_t>(FIRST_MAP_PHASE)].Record(ToNs(time));
+    }
+
+    boost::json::object TickProfiler::MakeJSON() const
+    {
+        boost::json::object phases;
+        for (size_t i = 0; i < phases_.size(); ++i)
+            phases[PHASE_NAMES[i]] = latency::MakeJSONHistogram(phases_[i].Snapshot());
+
+        boost::json::object maps;
+        for (size_t i = 0; i < maps_.size(); ++i)
+        {
+            boost::json::object map_phases;
+            for (size_t j = 0; j < MAP_PHASES; ++j)
+                map_phases[PHASE_NAMES[static_cast<size_t>(FIRST_MAP_PHASE) + j]] = latency::MakeJSONHistogram(maps_[i][j].Snapshot());
+            maps[map_ids_[i]] = std::move(map_phases);
+        }
+
+        boost::json::object profile;
+        profile["unit"] = "ns";
+        profile["ticks"] = phases_[static_cast<size_t>(Phase::TICK)].Snapshot().GetCount();
+        profile["phases"] = std::move(phases);
+        profile["maps"] = std::move(maps);
+        return profile;
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <boost/json/object.hpp>
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "latency_histogram.h"
+
+namespace tick_profile
+{
+    // Фазы тика. TICK включает все остальные, RETIREMENT включает DB_WRITE.
+    // LOOT, MOVEMENT и GATHER считаются ещё и по каждой карте
+    enum class Phase
+    {
+        PLAYTIME,
+        LOOT,
+        MOVEMENT,
+        GATHER,
+        COMMAND_LOG,
+        RETIREMENT,
+        // Зал славы, кэш рекордов и постановка в очередь. Сама запись в БД идёт в потоке RetirementWriter
+        DB_WRITE,
+        // Снимок мира для потока сохранений
+        SERIALIZATION,
+        TICK,
+        COUNT
+    };
+
+    std::string_view GetPhaseName(Phase phase);
+
+    // Время фаз тика в наносекундах с запуска сервера. Пишет strand симуляции, читать можно с любого потока
+    class TickProfiler
+    {
+    public:
+        // Карта с индексом i - i-я в Game::GetMaps
+        explicit TickProfiler(std::vector<std::string> map_ids);
+        TickProfiler(const TickProfiler&) = delete;
+        TickProfiler& operator=(const TickProfiler&) = delete;
+
+        void Record(Phase phase, std::chrono::nanoseconds time) noexcept;
+        // Фазы карт идут и в общую гистограмму фазы
+        void Record(size_t map_index, Phase phase, std::chrono::nanoseconds time) noexcept;
+
+        boost::json::object MakeJSON() const;
+
+    private:
+        static constexpr size_t MAP_PHASES = 3;
+        using Histograms = std::array<latency::AtomicHistogram, static_cast<size_t>(Phase::COUNT)>;
+        using MapHistograms = std::array<latency::AtomicHistogram, MAP_PHASES>;
+
+        Histograms phases_;
+        std::vector<std::string> map_ids_;
+        std::vector<MapHistograms> maps_;
+    };
+
+    // Пишет в профайлер время своей жизни. Без профайлера не читает часы
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(TickProfiler* profiler, Phase phase) noexcept
+            : ScopedTimer(profiler, NO_MAP, phase)
+        {
+        }
+
+        ScopedTimer(TickProfiler* profiler, size_t map_index, Phase phase) noexcept
+            : profiler_(profiler)
+            , map_index_(map_index)
+            , phase_(phase)
+        {
+            if (profiler_)
+                start_ = Clock::now();
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        ~ScopedTimer()
+        {
+            if (!profiler_)
+                return;
+            auto time = Clock::now() - start_;
+            if (map_index_ == NO_MAP)
+                profiler_->Record(phase_, time);
+            else
+                profiler_->Record(map_index_, phase_, time);
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+        static constexpr size_t NO_MAP = static_cast<size_t>(-1);
+
+        TickProfiler* profiler_;
+        size_t map_index_;
+        Phase phase_;
+        Clock::time_point start_;
+    };
+}
@@ -0,0 +1,460 @@
+#include "wal.h"
+#include "binary_codec.h"
+#include "log_data.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace wal
+{
+    namespace
+    {
+        // Строка сегмента: размер тела, CRC32 тела, тело
+        constexpr size_t HEADER_SIZE = 2 * sizeof(uint32_t);
+        constexpr size_t MAX_RECORD_SIZE = 64 << 20;
+
+        enum class RecordType : uint8_t
+        {
+            JOIN = 1,
+            ACTION = 2,
+            TICK = 3,
+            RETIRE = 4
+        };
+
+        using codec::Checksum;
+        using codec::Get;
+        using codec::GetInt;
+        using codec::GetString;
+        using codec::Put;
+        using codec::PutString;
+
+        void EncodeBody(const JoinRecord& r, std::string& out)
+        {
+            Put(out, RecordType::JOIN);
+            Put<int32_t>(out, r.player_id);
+            PutString(out, r.map_id);
+            PutString(out, r.name);
+            PutString(out, r.token);
+            Put(out, r.coords.x);
+            Put(out, r.coords.y);
+        }
+
+        void EncodeBody(const ActionRecord& r, std::string& out)
+        {
+            Put(out, RecordType::ACTION);
+            PutString(out, r.token);
+            PutString(out, r.move);
+        }
+
+        void EncodeBody(const TickRecord& r, std::string& out)
+        {
+            Put(out, RecordType::TICK);
+            Put<int64_t>(out, r.delta_ms);
+            Put<uint32_t>(out, static_cast<uint32_t>(r.loot.size()));
+            for (const auto& spawn : r.loot)
+            {
+                PutString(out, spawn.map_id);
+                Put<int32_t>(out, spawn.id);
+                Put<int32_t>(out, spawn.type);
+                Put(out, spawn.coord.x);
+                Put(out, spawn.coord.y);
+                Put<int32_t>(out, spawn.value);
+            }
+        }
+
+        void EncodeBody(const RetireRecord& r, std::string& out)
+        {
+            Put(out, RecordType::RETIRE);
+            Put<uint32_t>(out, static_cast<uint32_t>(r.players.size()));
+            for (const auto& player : r.players)
+            {
+                PutString(out, player.id);
+                PutString(out, player.name);
+                Put<int32_t>(out, player.score);
+                Put<int64_t>(out, player.play_time_ms);
+            }
+        }
+
+        bool DecodeBody(std::string_view& in, JoinRecord& r)
+        {
+            return GetInt(in, r.player_id) && GetString(in, r.map_id) && GetString(in, r.name) && GetString(in, r.token)
+                && Get(in, r.coords.x) && Get(in, r.coords.y);
+        }
+
+        bool DecodeBody(std::string_view& in, ActionRecord& r)
+        {
+            return GetString(in, r.token) && GetString(in, r.move);
+        }
+
+        bool DecodeBody(std::string_view& in, TickRecord& r)
+        {
+            uint32_t count = 0;
+            if (!Get(in, r.delta_ms) || !Get(in, count))
+                return false;
+            r.loot.resize(std::min<size_t>(count, in.size()));
+            if (r.loot.size() != count)
+                return false;
+            for (auto& spawn : r.loot)
+            {
+                if (!GetString(in, spawn.map_id) || !GetInt(in, spawn.id) || !GetInt(in, spawn.type)
+                    || !Get(in, spawn.coord.x) || !Get(in, spawn.coord.y) || !GetInt(in, spawn.value))
+                    return false;
+            }
+            return true;
+        }
+
+        bool DecodeBody(std::string_view& in, RetireRecord& r)
+        {
+            uint32_t count = 0;
+            if (!Get(in, count))
+                return false;
+            r.players.resize(std::min<size_t>(count, in.size()));
+            if (r.players.size() != count)
+                return false;
+            for (auto& player : r.players)
+            {
+                int32_t score = 0;
+                if (!GetString(in, player.id) || !GetString(in, player.name) || !Get(in, score) || !Get(in, player.play_time_ms))
+                    return false;
+                player.score = score;
+            }
+            return true;
+        }
+
+        template <typename T>
+        bool DecodeAs(std::string_view& in, Record& record)
+        {
+            T r;
+            if (!DecodeBody(in, r) || !in.empty())
+                return false;
+            record = std::move(r);
+            return true;
+        }
+    }
+
+    void Encode(const Record& record, std::string& out)
+    {
+        std::string body;
+        std::visit([&body](const auto& r) { EncodeBody(r, body); }, record);
+        Put<uint32_t>(out, static_cast<uint32_t>(body.size()));
+        Put<uint32_t>(out, Checksum(body));
+        out += body;
+    }
+
+    bool Decode(std::string_view body, Record& record)
+    {
+        RecordType type{};
+        if (!Get(body, type))
+            return false;
+        switch (type)
+        {
+        case RecordType::JOIN:
+            return DecodeAs<JoinRecord>(body, record);
+        case RecordType::ACTION:
+            return DecodeAs<ActionRecord>(body, record);
+        case RecordType::TICK:
+            return DecodeAs<TickRecord>(body, record);
+        case RecordType::RETIRE:
+            return DecodeAs<RetireRecord>(body, record);
+        }
+        return false;
+    }
+
+    WriteAheadLog::WriteAheadLog(Options options)
+        : options_(std::move(options))
+        , last_sync_(std::chrono::steady_clock::now())
+    {
+        if (options_.path.has_parent_path())
+            std::filesystem::create_directories(options_.path.parent_path());
+        worker_ = std::jthread([this](std::stop_token stop) {
+            Run(stop);
+            });
+    }
+
+    WriteAheadLog::~WriteAheadLog()
+    {
+        if (worker_.joinable())
+        {
+            worker_.request_stop();
+            worker_.join();
+        }
+    }
+
+    void WriteAheadLog::Append(const Record& record)
+    {
+        std::string data;
+        Encode(record, data);
+        {
+            std::lock_guard lock{ mutex_ };
+            if (chunks_.empty() || chunks_.back().segment != segment_)
+                chunks_.push_back({ segment_, {}, 0 });
+            chunks_.back().data += data;
+            ++chunks_.back().records;
+            appended_.fetch_add(1, std::memory_order_relaxed);
+        }
+        cond_var_.notify_one();
+    }
+
+    void WriteAheadLog::StartSegment(uint64_t checkpoint)
+    {
+        std::lock_guard lock{ mutex_ };
+        segment_ = checkpoint;
+    }
+
+    void WriteAheadLog::DropSegmentsBefore(uint64_t checkpoint)
+    {
+        {
+            std::lock_guard lock{ mutex_ };
+            drop_before_ = std::max(drop_before_, checkpoint);
+        }
+        cond_var_.notify_one();
+    }
+
+    void WriteAheadLog::Flush()
+    {
+        std::unique_lock lock{ mutex_ };
+        uint64_t target = appended_.load(std::memory_order_relaxed);
+        flushed_cond_var_.wait(lock, [this, target] { return written_.load(std::memory_order_relaxed) >= target; });
+    }
+
+    void WriteAheadLog::Run(std::stop_token stop)
+    {
+        while (true)
+        {
+            std::deque<Chunk> chunks;
+            uint64_t drop_before = 0;
+            {
+                std::unique_lock lock{ mutex_ };
+                auto has_work = [this] { return !chunks_.empty() || drop_before_ > dropped_before_; };
+                // Несинхронизированные данные ждут fsync не дольше интервала
+                if (dirty_ && options_.fsync == FsyncPolicy::INTERVAL)
+                    cond_var_.wait_until(lock, stop, last_sync_ + options_.fsync_interval, has_work);
+                else
+                    cond_var_.wait(lock, stop, has_work);
+                if (stop.stop_requested() && !has_work())
+                    break;
+                chunks.swap(chunks_);
+                drop_before = dropped_before_ = drop_before_;
+            }
+
+            // Всё, что накопилось, пока писалась прошлая группа, уходит одной группой
+            uint64_t records = 0;
+            for (const auto& chunk : chunks)
+            {
+                WriteChunk(chunk);
+                records += chunk.records;
+            }
+            if (records != 0)
+            {
+                stats_.groups.fetch_add(1, std::memory_order_relaxed);
+                stats_.records.fetch_add(records, std::memory_order_relaxed);
+                uint64_t max = stats_.max_group_records.load(std::memory_order_relaxed);
+                if (records > max)
+                    stats_.max_group_records.store(records, std::memory_order_relaxed);
+            }
+
+            if (dirty_ && (options_.fsync == FsyncPolicy::ALWAYS
+                || (options_.fsync == FsyncPolicy::INTERVAL && std::chrono::steady_clock::now() >= last_sync_ + options_.fsync_interval)))
+                Sync();
+            if (drop_before != 0)
+                DropSegments(drop_before);
+
+            {
+                std::lock_guard lock{ mutex_ };
+                written_.fetch_add(records, std::memory_order_relaxed);
+            }
+            flushed_cond_var_.notify_all();
+        }
+
+        if (options_.fsync != FsyncPolicy::NEVER)
+            Sync();
+        CloseFile();
+    }
+
+    void WriteAheadLog::WriteChunk(const Chunk& chunk)
+    {
+        const std::filesystem::path path = GetSegmentPath(chunk.segment);
+        // Записи после пропуска применились бы к миру без потерянных команд
+        if (torn_ && file_segment_ == chunk.segment)
+        {
+            stats_.failures.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (!file_ || file_segment_ != chunk.segment)
+        {
+            // Прежний сегмент закрывается синхронизированным: его записи уже не догонит следующий fsync
+            if (options_.fsync != FsyncPolicy::NEVER)
+                Sync();
+            CloseFile();
+            torn_ = false;
+            std::error_code ec;
+            uint64_t size = std::filesystem::file_size(path, ec);
+            file_size_ = synced_size_ = ec ? 0 : size;
+            file_ = std::fopen(path.string().c_str(), "ab");
+            file_segment_ = chunk.segment;
+        }
+
+        if (!file_ || std::fwrite(chunk.data.data(), 1, chunk.data.size(), file_) != chunk.data.size() || std::fflush(file_) != 0)
+        {
+            stats_.failures.fetch_add(1, std::memory_order_relaxed);
+            BOOST_LOG_TRIVIAL(error) << boost::log::add_value(data, boost::json::object{
+                {"message", "command log write failed"},
+                {"data", boost::json::object{ {"path", path.string()} }}
+                });
+            MarkGap(path, file_size_);
+            return;
+        }
+        file_size_ += chunk.data.size();
+        stats_.bytes.fetch_add(chunk.data.size(), std::memory_order_relaxed);
+        dirty_ = true;
+    }
+
+    void WriteAheadLog::Sync()
+    {
+        if (file_ && dirty_)
+        {
+            stats_.fsyncs.fetch_add(1, std::memory_order_relaxed);
+#ifdef __linux__
+            if (::fsync(::fileno(file_)) != 0)
+            {
+                std::error_code error(errno, std::system_category());
+                stats_.failures.fetch_add(1, std::memory_order_relaxed);
+                const std::filesystem::path path = GetSegmentPath(file_segment_);
+                BOOST_LOG_TRIVIAL(error) << boost::log::add_value(data, boost::json::object{
+                    {"message", "command log fsync failed"},
+                    {"data", boost::json::object{ {"path", path.string()}, {"error", error.message()} }}
+                    });
+                // Повторный fsync не сообщит об ошибке, а грязные страницы ядро могло уже выбросить:
+                // надёжными считаются только записи до прошлого успешного fsync
+                MarkGap(path, synced_size_);
+            }
+#endif
+        }
+        if (!torn_)
+            synced_size_ = file_size_;
+        dirty_ = false;
+        last_sync_ = std::chrono::steady_clock::now();
+    }
+
+    void WriteAheadLog::MarkGap(const std::filesystem::path& path, uint64_t size)
+    {
+        CloseFile();
+        torn_ = true;
+        // Вместо хвоста после пропуска остаётся один нулевой байт - оборванная запись. На ней повтор остановится
+        // и не перейдёт к следующим сегментам. Удлинение файла не занимает блоков, поэтому проходит и на полном диске
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec))
+            return;
+        std::filesystem::resize_file(path, size + 1, ec);
+        if (ec)
+        {
+            BOOST_LOG_TRIVIAL(error) << boost::log::add_value(data, boost::json::object{
+                {"message", "command log truncation failed"},
+                {"data", boost::json::object{ {"path", path.string()}, {"error", ec.message()} }}
+                });
+        }
+    }
+
+    void WriteAheadLog::CloseFile()
+    {
+        if (file_)
+            std::fclose(file_);
+        file_ = nullptr;
+        dirty_ = false;
+    }
+
+    void WriteAheadLog::DropSegments(uint64_t before)
+    {
+        for (uint64_t segment : ListSegments())
+        {
+            if (segment >= before)
+                break;
+            if (file_ && file_segment_ == segment)
+                CloseFile();
+            std::error_code ec;
+            if (std::filesystem::remove(GetSegmentPath(segment), ec))
+                stats_.segments_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::filesystem::path WriteAheadLog::GetSegmentPath(uint64_t segment) const
+    {
+        std::filesystem::path path = options_.path;
+        path += "." + std::to_string(segment);
+        return path;
+    }
+
+    std::vector<uint64_t> WriteAheadLog::ListSegments() const
+    {
+        std::vector<uint64_t> segments;
+        std::filesystem::path dir = options_.path.has_parent_path() ? options_.path.parent_path() : ".";
+        std::string prefix = options_.path.filename().string() + ".";
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(dir, ec))
+        {
+            std::string name = entry.path().filename().string();
+            if (!name.starts_with(prefix))
+                continue;
+            uint64_t segment = 0;
+            const char* begin = name.data() + prefix.size();
+            const char* end = name.data() + name.size();
+            if (auto [ptr, err] = std::from_chars(begin, end, segment); err == std::errc{} && ptr == end && begin != end)
+                segments.push_back(segment);
+        }
+        std::sort(segments.begin(), segments.end());
+        return segments;
+    }
+
+    std::vector<Record> WriteAheadLog::ReadFrom(uint64_t checkpoint) const
+    {
+        std::vector<Record> records;
+        for (uint64_t segment : ListSegments())
+        {
+            if (segment < checkpoint)
+                continue;
+
+            const std::filesystem::path path = GetSegmentPath(segment);
+            std::FILE* file = std::fopen(path.string().c_str(), "rb");
+            if (!file)
+                break;
+            uint64_t valid = 0;
+            std::string header(HEADER_SIZE, '\0');
+            std::string body;
+            while (std::fread(header.data(), 1, HEADER_SIZE, file) == HEADER_SIZE)
+            {
+                std::string_view in = header;
+                uint32_t size = 0, crc = 0;
+                Get(in, size);
+                Get(in, crc);
+                if (size > MAX_RECORD_SIZE)
+                    break;
+                body.resize(size);
+                Record record;
+                if (std::fread(body.data(), 1, size, file) != size || Checksum(body) != crc || !Decode(body, record))
+                    break;
+                records.push_back(std::move(record));
+                valid += HEADER_SIZE + size;
+            }
+            std::fclose(file);
+
+            // Дальше повреждённой записи повтор не идёт: команды после пропуска применились бы к другому миру
+            std::error_code ec;
+            if (valid != std::filesystem::file_size(path, ec) || ec)
+                break;
+        }
+        return records;
+    }
+
+    uint64_t WriteAheadLog::GetLastSegment() const
+    {
+        auto segments = ListSegments();
+        return segments.empty() ? 0 : segments.back();
+    }
+}
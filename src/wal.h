@@ -0,0 +1,178 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "model.h"
+#include "records_storage.h"
+
+namespace wal
+{
+    using namespace std::literals;
+
+    // Команды, изменившие мир. Повторённые по порядку поверх контрольной точки, они восстанавливают мир после падения
+    struct JoinRecord
+    {
+        int player_id = 0;
+        std::string map_id;
+        std::string name;
+        std::string token;
+        model::DogCoord coords{ 0, 0 };
+    };
+
+    struct ActionRecord
+    {
+        std::string token;
+        // Пустая строка - остановка
+        std::string move;
+    };
+
+    // Тик вместе с уходом простаивающих игроков. Лут записан, потому что генератор случаен
+    struct TickRecord
+    {
+        int64_t delta_ms = 0;
+        std::vector<model::LootSpawn> loot;
+    };
+
+    // Строки зала славы, созданные тиком. При повторе пишутся только те, которых в хранилище ещё нет
+    struct RetireRecord
+    {
+        std::vector<storage::RetiredPlayer> players;
+    };
+
+    using Record = std::variant<JoinRecord, ActionRecord, TickRecord, RetireRecord>;
+
+    enum class FsyncPolicy
+    {
+        // Данные отдаются ОС сразу, но fsync не вызывается: переживают падение процесса, но не ОС
+        NEVER,
+        // fsync не чаще раза в fsync_interval
+        INTERVAL,
+        // fsync после каждой группы записей
+        ALWAYS
+    };
+
+    struct Options
+    {
+        // Сегменты журнала - файлы path.<номер контрольной точки>
+        std::filesystem::path path;
+        FsyncPolicy fsync = FsyncPolicy::INTERVAL;
+        std::chrono::milliseconds fsync_interval = 100ms;
+    };
+
+    struct Stats
+    {
+        std::atomic<uint64_t> records{ 0 };
+        std::atomic<uint64_t> bytes{ 0 };
+        // Записи одной группы уходят на диск одним write и одним fsync
+        std::atomic<uint64_t> groups{ 0 };
+        std::atomic<uint64_t> fsyncs{ 0 };
+        std::atomic<uint64_t> max_group_records{ 0 };
+        std::atomic<uint64_t> failures{ 0 };
+        std::atomic<uint64_t> segments_dropped{ 0 };
+    };
+
+    // Журнал команд с групповой записью. Append вызывается на strand симуляции и только кладёт
+    // закодированную запись в буфер, запись и fsync выполняет отдельный поток.
+    // Журнал делится на сегменты по контрольным точкам Serializator: сегмент N хранит команды после точки N
+    // и удаляется, когда на диск легла более поздняя точка
+    class WriteAheadLog
+    {
+    public:
+        explicit WriteAheadLog(Options options);
+        WriteAheadLog(const WriteAheadLog&) = delete;
+        WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+        // Дописывает буфер и вызывает fsync
+        ~WriteAheadLog();
+
+        void Append(const Record& record);
+        // Следующие записи относятся к контрольной точке checkpoint
+        void StartSegment(uint64_t checkpoint);
+        // Точка checkpoint на диске, более ранние сегменты не нужны. Удаляет их поток записи
+        void DropSegmentsBefore(uint64_t checkpoint);
+        // Ждёт, пока все добавленные записи будут записаны
+        void Flush();
+
+        // Записи сегментов начиная с checkpoint по порядку. Чтение останавливается на первой повреждённой записи,
+        // в том числе оборванном при падении хвосте: следующие сегменты тоже не читаются
+        std::vector<Record> ReadFrom(uint64_t checkpoint) const;
+        // Наибольший номер сегмента на диске
+        uint64_t GetLastSegment() const;
+
+        // Записи, ещё не отданные ОС
+        uint64_t GetPending() const noexcept
+        {
+            return appended_.load(std::memory_order_relaxed) - written_.load(std::memory_order_relaxed);
+        }
+
+        const Stats& GetStats() const noexcept
+        {
+            return stats_;
+        }
+
+        const Options& GetOptions() const noexcept
+        {
+            return options_;
+        }
+
+    private:
+        struct Chunk
+        {
+            uint64_t segment = 0;
+            std::string data;
+            uint64_t records = 0;
+        };
+
+        Options options_;
+        mutable std::mutex mutex_;
+        std::condition_variable_any cond_var_;
+        std::condition_variable flushed_cond_var_;
+        std::deque<Chunk> chunks_;
+        uint64_t segment_ = 0;
+        uint64_t drop_before_ = 0;
+        uint64_t dropped_before_ = 0;
+        std::atomic<uint64_t> appended_{ 0 };
+        std::atomic<uint64_t> written_{ 0 };
+        Stats stats_;
+
+        // Принадлежат потоку записи
+        std::FILE* file_ = nullptr;
+        uint64_t file_segment_ = 0;
+        // Длина файла сегмента по последнюю целиком записанную группу
+        uint64_t file_size_ = 0;
+        // Длина файла сегмента по последний успешный fsync
+        uint64_t synced_size_ = 0;
+        // В сегменте file_segment_ пропуск: новые записи туда не пишутся до следующей контрольной точки
+        bool torn_ = false;
+        bool dirty_ = false;
+        std::chrono::steady_clock::time_point last_sync_;
+
+        std::jthread worker_;
+
+        void Run(std::stop_token stop);
+        void WriteChunk(const Chunk& chunk);
+        void Sync();
+        void CloseFile();
+        // Закрывает сегмент с пропуском после size байт
+        void MarkGap(const std::filesystem::path& path, uint64_t size);
+        void DropSegments(uint64_t before);
+        std::filesystem::path GetSegmentPath(uint64_t segment) const;
+        // Номера сегментов на диске по возрастанию
+        std::vector<uint64_t> ListSegments() const;
+    };
+
+    // Кодирование записей: тип, затем поля. Числа - в порядке байт машины
+    void Encode(const Record& record, std::string& out);
+    // false, если тело повреждено
+    bool Decode(std::string_view body, Record& record);
+}
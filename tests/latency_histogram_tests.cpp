@@ -0,0 +1,71 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/latency_histogram.h"
+
+SCENARIO("Latency histogram") {
+    using latency::Histogram;
+
+    GIVEN("bucket boundaries") {
+        THEN("small values get exact buckets and every value lies inside its bucket") {
+            for (uint64_t value = 0; value < Histogram::SUB_BUCKETS; ++value)
+                CHECK(Histogram::BucketLow(Histogram::BucketIndex(value)) == value);
+            for (uint64_t value : { 33ull, 100ull, 1000ull, 123456789ull, ~0ull })
+            {
+                const size_t index = Histogram::BucketIndex(value);
+                CHECK(index < Histogram::BUCKETS);
+                CHECK(Histogram::BucketLow(index) <= value);
+                CHECK(value <= Histogram::BucketHigh(index));
+                CHECK(Histogram::BucketHigh(index) - Histogram::BucketLow(index) < value / (Histogram::SUB_BUCKETS / 2));
+            }
+        }
+    }
+
+    GIVEN("values from 1 to 1000 recorded in two halves") {
+        Histogram first;
+        Histogram second;
+        for (uint64_t value = 1; value <= 500; ++value)
+            first.Record(value);
+        for (uint64_t value = 501; value <= 1000; ++value)
+            second.Record(value);
+        first.Merge(second);
+
+        THEN("the merged histogram keeps count, extremes and percentiles within a bucket") {
+            CHECK(first.GetCount() == 1000);
+            CHECK(first.GetMin() == 1);
+            CHECK(first.GetMax() == 1000);
+            CHECK(first.GetMean() == 500.5);
+            CHECK(first.Percentile(0.5) >= 500);
+            CHECK(first.Percentile(0.5) <= 500 + 500 / Histogram::SUB_BUCKETS);
+            CHECK(first.Percentile(0.99) >= 990);
+            CHECK(first.Percentile(1.0) == 1000);
+        }
+    }
+
+    GIVEN("an atomic histogram") {
+        latency::AtomicHistogram atomic;
+        Histogram plain;
+        for (uint64_t value : { 7ull, 70ull, 700ull, 7000ull })
+        {
+            atomic.Record(value);
+            plain.Record(value);
+        }
+
+        THEN("its snapshot matches a plain histogram of the same values") {
+            Histogram snapshot = atomic.Snapshot();
+            CHECK(snapshot.GetCount() == plain.GetCount());
+            CHECK(snapshot.GetMin() == plain.GetMin());
+            CHECK(snapshot.GetMax() == plain.GetMax());
+            CHECK(snapshot.GetMean() == plain.GetMean());
+            CHECK(snapshot.Percentile(0.5) == plain.Percentile(0.5));
+        }
+    }
+
+    GIVEN("an empty histogram") {
+        Histogram histogram;
+        THEN("it reports zeros") {
+            CHECK(histogram.GetCount() == 0);
+            CHECK(histogram.GetMin() == 0);
+            CHECK(histogram.Percentile(0.99) == 0);
+        }
+    }
+}
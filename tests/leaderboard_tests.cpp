@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/leaderboard.h"
+
+using namespace std::literals;
+
+SCENARIO("Order-statistics leaderboard") {
+    using namespace leaderboard;
+
+    GIVEN("an empty tree") {
+        RankTree tree;
+
+        THEN("it has no ranks") {
+            CHECK(tree.Size() == 0);
+            CHECK(tree.GetRange(0, 10).empty());
+            CHECK_FALSE(tree.GetRank({ 10, 1000, "Rex"s, "1"s }).has_value());
+            CHECK(tree.CountHigher({ 10, 1000, "Rex"s, "1"s }) == 0);
+        }
+
+        WHEN("entries are inserted") {
+            REQUIRE(tree.Insert({ 10, 5000, "Rex"s, "1"s }));
+            REQUIRE(tree.Insert({ 30, 9000, "Bim"s, "2"s }));
+            REQUIRE(tree.Insert({ 10, 2000, "Ace"s, "3"s }));
+            REQUIRE(tree.Insert({ 10, 2000, "Ace"s, "4"s }));
+
+            THEN("they are ordered by score, play time, name and id") {
+                auto top = tree.GetRange(0, 10);
+                REQUIRE(top.size() == 4);
+                CHECK(top[0].id == "2"s);
+                CHECK(top[1].id == "3"s);
+                CHECK(top[2].id == "4"s);
+                CHECK(top[3].id == "1"s);
+                CHECK(tree.GetRank({ 10, 5000, "Rex"s, "1"s }) == 3u);
+            }
+
+            THEN("a duplicate is rejected") {
+                CHECK_FALSE(tree.Insert({ 10, 5000, "Rex"s, "1"s }));
+                CHECK(tree.Size() == 4);
+            }
+
+            THEN("an absent key gets the rank it would have") {
+                CHECK(tree.CountHigher({ 20, 0, ""s, ""s }) == 1);
+                CHECK(tree.CountHigher({ 0, 0, ""s, ""s }) == 4);
+            }
+
+            THEN("an erased entry loses its rank") {
+                REQUIRE(tree.Erase({ 30, 9000, "Bim"s, "2"s }));
+                CHECK_FALSE(tree.Erase({ 30, 9000, "Bim"s, "2"s }));
+                CHECK(tree.GetRank({ 10, 2000, "Ace"s, "3"s }) == 0u);
+                CHECK(tree.Size() == 3);
+            }
+        }
+    }
+
+    GIVEN("random inserts and erases") {
+        RankTree tree{ 42 };
+        std::vector<Entry> expected;
+        std::mt19937 rng{ 7 };
+
+        for (int i = 0; i < 3000; ++i)
+        {
+            if (!expected.empty() && rng() % 3 == 0)
+            {
+                size_t pos = rng() % expected.size();
+                REQUIRE(tree.Erase(expected[pos]));
+                expected.erase(expected.begin() + pos);
+            }
+            else
+            {
+                Entry entry{ static_cast<int>(rng() % 50), static_cast<int64_t>(rng() % 100), "dog"s, std::to_string(i) };
+                REQUIRE(tree.Insert(entry));
+                expected.insert(std::upper_bound(expected.begin(), expected.end(), entry, IsRankedHigher), entry);
+            }
+        }
+
+        THEN("ranks and ranges match a sorted vector") {
+            REQUIRE(tree.Size() == expected.size());
+            for (size_t i = 0; i < expected.size(); i += 37)
+                CHECK(tree.GetRank(expected[i]) == i);
+
+            for (size_t offset : { size_t{ 0 }, size_t{ 1 }, expected.size() / 2, expected.size() - 1, expected.size() })
+            {
+                auto range = tree.GetRange(offset, 25);
+                size_t end = std::min(expected.size(), offset + 25);
+                REQUIRE(range.size() == end - offset);
+                CHECK(std::equal(range.begin(), range.end(), expected.begin() + offset));
+            }
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+
+#include "../src/local_store.h"
+
+using namespace std::literals;
+
+SCENARIO("Local records store") {
+    using namespace storage;
+    const auto dir = std::filesystem::temp_directory_path() / "game_server_local_store_tests";
+    std::filesystem::remove_all(dir);
+
+    GIVEN("a store with a few records") {
+        {
+            LocalStore store{ { .dir = dir, .compact_after = 4 } };
+            store.AddRetiredPlayers({ { ""s, "Rex"s, 10, 5000 }, { ""s, "Bim"s, 30, 9000 }, { ""s, "Ace"s, 10, 2000 } });
+
+            THEN("pages follow the hall of fame order") {
+                auto page = store.GetRetiredPlayersPage(nullptr, 0, 10);
+                REQUIRE(page.size() == 3);
+                CHECK(page[0].name == "Bim"s);
+                CHECK(page[1].name == "Ace"s);
+                CHECK(page[2].name == "Rex"s);
+                CHECK(page[0].id.size() == 36);
+
+                auto next = store.GetRetiredPlayersPage(&page[0], 0, 10);
+                REQUIRE(next.size() == 2);
+                CHECK(next[0].name == "Ace"s);
+                CHECK(store.GetRetiredPlayersPage(nullptr, 2, 10).size() == 1);
+            }
+
+            store.AddRetiredPlayers({ { ""s, "Max"s, 50, 100 }, { ""s, "Leo"s, 1, 100 } });
+        }
+
+        WHEN("the store is reopened after a torn write") {
+            std::ofstream(dir / "records.log", std::ios::app | std::ios::binary) << "torn"s;
+            LocalStore store{ { .dir = dir, .compact_after = 4 } };
+
+            THEN("complete records survive and the tail is dropped") {
+                CHECK(store.Size() == 5);
+                CHECK(store.GetStats().at("truncatedBytes").as_uint64() == 4);
+                auto page = store.GetRetiredPlayersPage(nullptr, 0, 10);
+                REQUIRE(page.size() == 5);
+                CHECK(page.front().name == "Max"s);
+                CHECK(page.back().name == "Leo"s);
+            }
+
+            THEN("compaction keeps every record") {
+                store.Compact();
+                CHECK(std::filesystem::file_size(dir / "records.log") == 0);
+                LocalStore reopened{ { .dir = dir } };
+                CHECK(reopened.Size() == 5);
+            }
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,94 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <thread>
+#include <vector>
+
+#include "../src/rate_limiter.h"
+
+using namespace std::literals;
+
+SCENARIO("Token bucket table") {
+    using namespace rate_limit;
+    const auto start = Clock::now();
+
+    GIVEN("a bucket with rate 10/s and burst 5") {
+        TokenBucketTable buckets{ { .rate = 10, .burst = 5 }, 16, start };
+
+        THEN("a burst is allowed and the next request is rejected") {
+            for (int i = 0; i < 5; ++i)
+                CHECK(buckets.TryAcquire(42, start).allowed);
+            auto decision = buckets.TryAcquire(42, start);
+            CHECK_FALSE(decision.allowed);
+            CHECK(decision.retry_after >= 1s);
+        }
+
+        THEN("tokens are refilled over time") {
+            for (int i = 0; i < 5; ++i)
+                REQUIRE(buckets.TryAcquire(42, start).allowed);
+            CHECK_FALSE(buckets.TryAcquire(42, start + 50ms).allowed);
+            CHECK(buckets.TryAcquire(42, start + 100ms).allowed);
+            CHECK_FALSE(buckets.TryAcquire(42, start + 100ms).allowed);
+        }
+
+        THEN("keys are limited independently") {
+            for (int i = 0; i < 5; ++i)
+                REQUIRE(buckets.TryAcquire(1ull << 50, start).allowed);
+            CHECK_FALSE(buckets.TryAcquire(1ull << 50, start).allowed);
+            CHECK(buckets.TryAcquire(2ull << 50, start).allowed);
+        }
+
+        THEN("concurrent requests never exceed the burst") {
+            std::atomic<int> allowed{ 0 };
+            std::vector<std::jthread> threads;
+            for (int t = 0; t < 4; ++t)
+            {
+                threads.emplace_back([&] {
+                    for (int i = 0; i < 100; ++i)
+                        if (buckets.TryAcquire(7, start).allowed)
+                            ++allowed;
+                    });
+            }
+            threads.clear();
+            CHECK(allowed == 5);
+        }
+    }
+}
+
+SCENARIO("Rate limiter") {
+    using namespace rate_limit;
+    const auto ip = boost::asio::ip::make_address("10.0.0.1");
+    const auto other_ip = boost::asio::ip::make_address("::1");
+
+    GIVEN("limits parsed from the command line") {
+        auto route = ParseRouteLimit("/api/v1/game/player/action=2:2");
+        CHECK(route.route == "/api/v1/game/player/action");
+        CHECK(route.limit.rate == 2);
+        CHECK(route.limit.burst == 2);
+        CHECK(ParseLimit("20").burst == 20);
+        CHECK_THROWS(ParseRouteLimit("action=2:2"));
+        CHECK_THROWS(ParseLimit("fast"));
+
+        RateLimiter limiter{ { .routes = { route }, .per_ip = ParseLimit("4:4") } };
+        const auto now = Clock::now();
+
+        THEN("the route limit is counted per token") {
+            CHECK(limiter.Check("/api/v1/game/player/action", "token1", ip, now).allowed);
+            CHECK(limiter.Check("/api/v1/game/player/action", "token1", ip, now).allowed);
+            CHECK_FALSE(limiter.Check("/api/v1/game/player/action", "token1", ip, now).allowed);
+            CHECK(limiter.Check("/api/v1/game/player/action", "token2", ip, now).allowed);
+
+            auto stats = limiter.GetRouteStats();
+            REQUIRE(stats.size() == 1);
+            CHECK(stats[0].allowed == 3);
+            CHECK(stats[0].rejected == 1);
+        }
+
+        THEN("the address limit covers all routes") {
+            for (int i = 0; i < 4; ++i)
+                REQUIRE(limiter.Check("/api/v1/maps", "", ip, now).allowed);
+            CHECK_FALSE(limiter.Check("/api/v1/maps", "", ip, now).allowed);
+            CHECK(limiter.GetRejectedByIp() == 1);
+            CHECK(limiter.Check("/api/v1/maps", "", other_ip, now).allowed);
+        }
+    }
+}
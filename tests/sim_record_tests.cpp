@@ -0,0 +1,99 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <variant>
+#include <vector>
+
+#include "../src/model.h"
+#include "../src/sim_record.h"
+
+using namespace std::literals;
+
+SCENARIO("Simulation journal") {
+    using namespace sim_record;
+    const auto dir = std::filesystem::temp_directory_path() / "game_server_sim_record_tests";
+    std::filesystem::remove_all(dir);
+    const auto path = dir / "journal";
+
+    GIVEN("a recorded session") {
+        {
+            Recorder recorder(path, { .config_crc = 42, .seed = 7, .randomize_spawn_points = true });
+            recorder.Append(Join{ 0, "map1"s, "Rex"s });
+            recorder.Append(Action{ 0, 'L' });
+            recorder.Append(Tick{ 50, 0xDEADBEEF });
+            recorder.Append(Action{ 0, 0 });
+            CHECK(recorder.GetRecords() == 4);
+        }
+
+        THEN("records are read back in order") {
+            Reader reader(path);
+            CHECK(reader.GetHeader().config_crc == 42);
+            CHECK(reader.GetHeader().seed == 7);
+            CHECK(reader.GetHeader().randomize_spawn_points);
+
+            std::vector<Record> records;
+            Record record;
+            while (reader.Next(record))
+                records.push_back(record);
+            REQUIRE(records.size() == 4);
+            CHECK(std::get<Join>(records[0]).name == "Rex"s);
+            CHECK(std::get<Action>(records[1]).move == 'L');
+            CHECK(std::get<Tick>(records[2]).delta_ms == 50);
+            CHECK(std::get<Tick>(records[2]).digest == 0xDEADBEEF);
+            CHECK(std::get<Action>(records[3]).move == 0);
+        }
+
+        WHEN("the last record is torn") {
+            std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+
+            THEN("the journal ends before it") {
+                Reader reader(path);
+                Record record;
+                size_t count = 0;
+                while (reader.Next(record))
+                    ++count;
+                CHECK(count == 3);
+            }
+        }
+    }
+
+    GIVEN("a file of another format") {
+        std::filesystem::create_directories(dir);
+        std::ofstream(path, std::ios::binary) << "not a journal at all, just text"s;
+
+        THEN("it is rejected") {
+            CHECK_THROWS_AS(Reader(path), std::runtime_error);
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+SCENARIO("Seeded map randomness") {
+    using namespace model;
+    auto make_map = [] {
+        Map map(Map::Id("map1"s), "Map 1"s);
+        map.AddRoad(Road(Road::HORIZONTAL, { 0, 0 }, 40));
+        map.AddRoad(Road(Road::VERTICAL, { 40, 0 }, 30));
+        return map;
+    };
+
+    GIVEN("two maps with the same seed") {
+        Map first = make_map();
+        Map second = make_map();
+        first.SeedRandom(123);
+        second.SeedRandom(123);
+
+        THEN("they produce the same spawn points and loot types") {
+            for (int i = 0; i < 100; ++i)
+            {
+                DogCoord a = first.GetRandomPosDog();
+                DogCoord b = second.GetRandomPosDog();
+                CHECK(a.x == b.x);
+                CHECK(a.y == b.y);
+                CHECK(first.GetRandomLootTypeIndex(5) == second.GetRandomLootTypeIndex(5));
+            }
+        }
+    }
+}
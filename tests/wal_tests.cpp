@@ -0,0 +1,148 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <variant>
+#include <vector>
+
+#ifdef __linux__
+#include <csignal>
+#include <sys/resource.h>
+#endif
+
+#include "../src/wal.h"
+
+using namespace std::literals;
+
+namespace {
+    constexpr size_t HEADER_SIZE = 8;
+
+    wal::Record RoundTrip(const wal::Record& record) {
+        std::string data;
+        wal::Encode(record, data);
+        REQUIRE(data.size() > HEADER_SIZE);
+        wal::Record decoded;
+        REQUIRE(wal::Decode(std::string_view(data).substr(HEADER_SIZE), decoded));
+        return decoded;
+    }
+}
+
+SCENARIO("Command log records") {
+    WHEN("every record type is encoded and decoded") {
+        THEN("the fields survive") {
+            auto join = std::get<wal::JoinRecord>(RoundTrip(wal::JoinRecord{ 3, "map1"s, "Rex"s, "0123456789abcdef0123456789abcdef"s, { 1.5, -2.25 } }));
+            CHECK(join.player_id == 3);
+            CHECK(join.map_id == "map1"s);
+            CHECK(join.name == "Rex"s);
+            CHECK(join.token == "0123456789abcdef0123456789abcdef"s);
+            CHECK(join.coords.x == 1.5);
+            CHECK(join.coords.y == -2.25);
+
+            auto action = std::get<wal::ActionRecord>(RoundTrip(wal::ActionRecord{ "token"s, ""s }));
+            CHECK(action.token == "token"s);
+            CHECK(action.move.empty());
+
+            wal::TickRecord tick{ 50, {} };
+            tick.loot.push_back({ "map1"s, 7, 2, { 3.0, 4.0 }, 10 });
+            auto tick_back = std::get<wal::TickRecord>(RoundTrip(tick));
+            CHECK(tick_back.delta_ms == 50);
+            REQUIRE(tick_back.loot.size() == 1);
+            CHECK(tick_back.loot[0].map_id == "map1"s);
+            CHECK(tick_back.loot[0].id == 7);
+            CHECK(tick_back.loot[0].value == 10);
+
+            auto retire = std::get<wal::RetireRecord>(RoundTrip(wal::RetireRecord{ { { "id"s, "Rex"s, 12, 3400 } } }));
+            REQUIRE(retire.players.size() == 1);
+            CHECK(retire.players[0].name == "Rex"s);
+            CHECK(retire.players[0].score == 12);
+            CHECK(retire.players[0].play_time_ms == 3400);
+        }
+    }
+
+    WHEN("a body is cut short") {
+        std::string data;
+        wal::Encode(wal::ActionRecord{ "token"s, "L"s }, data);
+        wal::Record record;
+        THEN("it is rejected") {
+            CHECK_FALSE(wal::Decode(std::string_view(data).substr(HEADER_SIZE, data.size() - HEADER_SIZE - 1), record));
+        }
+    }
+}
+
+SCENARIO("Command log replay") {
+    const auto dir = std::filesystem::temp_directory_path() / "game_server_wal_tests";
+    std::filesystem::remove_all(dir);
+    const auto path = dir / "commands";
+
+    GIVEN("two segments") {
+        {
+            wal::WriteAheadLog log({ .path = path, .fsync = wal::FsyncPolicy::NEVER });
+            log.StartSegment(1);
+            log.Append(wal::ActionRecord{ "a"s, "L"s });
+            log.Append(wal::ActionRecord{ "b"s, "R"s });
+            log.StartSegment(2);
+            log.Append(wal::ActionRecord{ "c"s, "U"s });
+            log.Flush();
+        }
+        const auto first = std::filesystem::path(path.string() + ".1");
+        REQUIRE(std::filesystem::exists(first));
+
+        THEN("all records are read in order") {
+            auto records = wal::WriteAheadLog({ .path = path, .fsync = wal::FsyncPolicy::NEVER }).ReadFrom(0);
+            REQUIRE(records.size() == 3);
+            CHECK(std::get<wal::ActionRecord>(records[2]).token == "c"s);
+        }
+
+        WHEN("the first segment has a torn tail") {
+            std::string data;
+            wal::Encode(wal::ActionRecord{ "torn"s, "D"s }, data);
+            {
+                std::ofstream out(first, std::ios::binary | std::ios::app);
+                out.write(data.data(), static_cast<std::streamsize>(data.size() - 2));
+            }
+
+            THEN("replay stops there and skips the later segment") {
+                auto records = wal::WriteAheadLog({ .path = path, .fsync = wal::FsyncPolicy::NEVER }).ReadFrom(0);
+                REQUIRE(records.size() == 2);
+                CHECK(std::get<wal::ActionRecord>(records[1]).token == "b"s);
+            }
+        }
+    }
+
+#ifdef __linux__
+    GIVEN("a group that fails to be written") {
+        {
+            wal::WriteAheadLog log({ .path = path, .fsync = wal::FsyncPolicy::NEVER });
+            log.StartSegment(1);
+            log.Append(wal::ActionRecord{ "a"s, "L"s });
+            log.Flush();
+
+            // Запись обрывается на пределе размера файла
+            auto handler = std::signal(SIGXFSZ, SIG_IGN);
+            rlimit limit{};
+            getrlimit(RLIMIT_FSIZE, &limit);
+            rlimit small = limit;
+            small.rlim_cur = 40;
+            setrlimit(RLIMIT_FSIZE, &small);
+            log.Append(wal::ActionRecord{ std::string(100, 'x'), "R"s });
+            log.Flush();
+            setrlimit(RLIMIT_FSIZE, &limit);
+            std::signal(SIGXFSZ, handler);
+
+            log.Append(wal::ActionRecord{ "b"s, "U"s });
+            log.StartSegment(2);
+            log.Append(wal::ActionRecord{ "c"s, "D"s });
+            log.Flush();
+            CHECK(log.GetStats().failures >= 2);
+        }
+
+        THEN("replay stops at the gap") {
+            auto records = wal::WriteAheadLog({ .path = path, .fsync = wal::FsyncPolicy::NEVER }).ReadFrom(0);
+            REQUIRE(records.size() == 1);
+            CHECK(std::get<wal::ActionRecord>(records[0]).token == "a"s);
+        }
+    }
+#endif
+
+    std::filesystem::remove_all(dir);
+}
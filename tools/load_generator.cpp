@@ -0,0 +1,403 @@
+// Нагрузка на запущенный game_server по HTTP вместо static/load_simulator.html.
+// Каждый клиентский поток держит одно keep-alive соединение и свою часть игроков: сначала заходит ими
+// на карты по кругу, затем с заданной частотой шлёт действия и опрашивает состояние.
+// Расписание открытое: задержка считается от запланированного момента отправки, поэтому отставание клиента
+// от расписания попадает в задержку, а не прячется в меньшем числе запросов.
+// При --tick-period отдельное соединение двигает время через /api/v1/game/tick (сервер запущен без -t).
+// Отчёт: на каждый эндпоинт число запросов, ошибок соединения, ответов не 200, запросов в секунду и гистограмма задержек в мкс.
+// Запуск: load_generator [--host 127.0.0.1] [--port 8080] [--players 100] [--connections N] [--map id ...]
+//         [--action-rate 1] [--state-rate 5] [--tick-period 0] [--duration 10]
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/json.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <latch>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "../src/latency_histogram.h"
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace json = boost::json;
+using tcp = net::ip::tcp;
+using namespace std::literals;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    enum Endpoint
+    {
+        JOIN,
+        ACTION,
+        STATE,
+        TICK,
+        ENDPOINT_COUNT
+    };
+
+    constexpr std::string_view TARGETS[ENDPOINT_COUNT] = {
+        "/api/v1/game/join"sv,
+        "/api/v1/game/player/action"sv,
+        "/api/v1/game/state"sv,
+        "/api/v1/game/tick"sv
+    };
+
+    constexpr std::string_view MOVES[] = { "L"sv, "R"sv, "U"sv, "D"sv, ""sv };
+
+    struct Options
+    {
+        std::string host = "127.0.0.1"s;
+        std::string port = "8080"s;
+        unsigned players = 100;
+        unsigned connections = 0;
+        std::vector<std::string> maps;
+        // Запросов в секунду на одного игрока
+        double action_rate = 1.0;
+        double state_rate = 5.0;
+        unsigned tick_period = 0;
+        unsigned duration = 10;
+    };
+
+    struct EndpointStats
+    {
+        uint64_t errors = 0;
+        uint64_t not_ok = 0;
+        latency::Histogram latency_us;
+
+        void Merge(const EndpointStats& other)
+        {
+            errors += other.errors;
+            not_ok += other.not_ok;
+            latency_us.Merge(other.latency_us);
+        }
+    };
+
+    using Stats = std::array<EndpointStats, ENDPOINT_COUNT>;
+
+    // Keep-alive соединение. После сетевой ошибки или ответа с Connection: close переоткрывается при следующем запросе
+    class Connection
+    {
+    public:
+        Connection(const tcp::resolver::results_type& endpoints, const std::string& host)
+            : endpoints_(endpoints)
+            , host_(host)
+        {
+        }
+
+        http::response<http::string_body> Send(http::verb method, std::string_view target, std::string body = {},
+            const std::string& authorization = {})
+        {
+            http::request<http::string_body> request(method, target, 11);
+            request.set(http::field::host, host_);
+            request.keep_alive(true);
+            if (!authorization.empty())
+                request.set(http::field::authorization, authorization);
+            if (method == http::verb::post)
+            {
+                request.set(http::field::content_type, "application/json"sv);
+                request.body() = std::move(body);
+                request.prepare_payload();
+            }
+
+            try
+            {
+                if (!socket_.is_open())
+                {
+                    buffer_.clear();
+                    net::connect(socket_, endpoints_);
+                    socket_.set_option(tcp::no_delay(true));
+                }
+                http::write(socket_, request);
+                http::response<http::string_body> response;
+                http::read(socket_, buffer_, response);
+                if (!response.keep_alive())
+                    Close();
+                return response;
+            }
+            catch (...)
+            {
+                Close();
+                throw;
+            }
+        }
+
+    private:
+        void Close()
+        {
+            beast::error_code ec;
+            socket_.shutdown(tcp::socket::shutdown_both, ec);
+            socket_.close(ec);
+        }
+
+        net::io_context ioc_;
+        tcp::socket socket_{ ioc_ };
+        beast::flat_buffer buffer_;
+        tcp::resolver::results_type endpoints_;
+        std::string host_;
+    };
+
+    // Задержка считается от scheduled, а не от момента отправки. Ответ не 200 тоже попадает в гистограмму
+    std::optional<http::response<http::string_body>> Measure(EndpointStats& stats, Clock::time_point scheduled,
+        Connection& connection, http::verb method, std::string_view target, std::string body = {},
+        const std::string& authorization = {})
+    {
+        try
+        {
+            auto response = connection.Send(method, target, std::move(body), authorization);
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - scheduled).count();
+            stats.latency_us.Record(static_cast<uint64_t>(std::max<int64_t>(us, 0)));
+            if (response.result() != http::status::ok)
+            {
+                ++stats.not_ok;
+                return std::nullopt;
+            }
+            return response;
+        }
+        catch (const std::exception&)
+        {
+            ++stats.errors;
+            return std::nullopt;
+        }
+    }
+
+    std::vector<std::string> LoadMapIds(const tcp::resolver::results_type& endpoints, const std::string& host)
+    {
+        Connection connection(endpoints, host);
+        auto response = connection.Send(http::verb::get, "/api/v1/maps"sv);
+        if (response.result() != http::status::ok)
+            throw std::runtime_error("Can't get the map list: status "s + std::to_string(response.result_int()));
+        const json::value maps = json::parse(response.body());
+        std::vector<std::string> ids;
+        for (const auto& map : maps.as_array())
+            ids.emplace_back(map.at("id").as_string());
+        return ids;
+    }
+
+    struct ClientContext
+    {
+        const Options& options;
+        const tcp::resolver::results_type& endpoints;
+        const std::vector<std::string>& maps;
+        // Все клиенты и main приходят сюда после входа игроков
+        std::latch& joined;
+    };
+
+    // Игроки клиента: index, index + connections, ...
+    Stats RunClient(const ClientContext& context, unsigned index)
+    {
+        const Options& options = context.options;
+        Stats stats;
+        Connection connection(context.endpoints, options.host);
+
+        std::vector<std::string> authorizations;
+        for (unsigned player = index; player < options.players; player += options.connections)
+        {
+            json::object join;
+            join["userName"] = "load"s + std::to_string(player);
+            join["mapId"] = context.maps[player % context.maps.size()];
+            auto response = Measure(stats[JOIN], Clock::now(), connection, http::verb::post, TARGETS[JOIN], json::serialize(join));
+            if (!response)
+                continue;
+            try
+            {
+                authorizations.push_back("Bearer "s + std::string(json::parse(response->body()).at("authToken").as_string()));
+            }
+            catch (const std::exception&)
+            {
+                ++stats[JOIN].errors;
+            }
+        }
+        context.joined.arrive_and_wait();
+        if (authorizations.empty())
+            return stats;
+
+        const auto start = Clock::now();
+        const auto deadline = start + std::chrono::seconds(options.duration);
+        const double players = static_cast<double>(authorizations.size());
+        auto interval = [players](double rate) {
+            return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / (rate * players)));
+            };
+        const auto action_interval = options.action_rate > 0 ? interval(options.action_rate) : Clock::duration::max();
+        const auto state_interval = options.state_rate > 0 ? interval(options.state_rate) : Clock::duration::max();
+        // Клиенты сдвинуты друг относительно друга, чтобы не слать запросы пачками
+        const double phase = static_cast<double>(index) / static_cast<double>(options.connections);
+        auto next_action = options.action_rate > 0 ? start + std::chrono::duration_cast<Clock::duration>(action_interval * phase) : Clock::time_point::max();
+        auto next_state = options.state_rate > 0 ? start + std::chrono::duration_cast<Clock::duration>(state_interval * phase) : Clock::time_point::max();
+        size_t actions = 0;
+        size_t states = 0;
+
+        while (true)
+        {
+            const bool action = next_action <= next_state;
+            const auto scheduled = action ? next_action : next_state;
+            if (scheduled >= deadline)
+                break;
+            std::this_thread::sleep_until(scheduled);
+
+            if (action)
+            {
+                const size_t player = actions % authorizations.size();
+                const auto move = MOVES[(actions / authorizations.size() + player) % std::size(MOVES)];
+                json::object body;
+                body["move"] = move;
+                Measure(stats[ACTION], scheduled, connection, http::verb::post, TARGETS[ACTION], json::serialize(body), authorizations[player]);
+                ++actions;
+                next_action += action_interval;
+            }
+            else
+            {
+                Measure(stats[STATE], scheduled, connection, http::verb::get, TARGETS[STATE], {}, authorizations[states % authorizations.size()]);
+                ++states;
+                next_state += state_interval;
+            }
+        }
+        return stats;
+    }
+
+    Stats RunTicker(const ClientContext& context)
+    {
+        const Options& options = context.options;
+        Stats stats;
+        Connection connection(context.endpoints, options.host);
+        json::object body;
+        body["timeDelta"] = options.tick_period;
+        const std::string serialized = json::serialize(body);
+
+        context.joined.arrive_and_wait();
+        const auto period = std::chrono::milliseconds(options.tick_period);
+        const auto deadline = Clock::now() + std::chrono::seconds(options.duration);
+        for (auto scheduled = Clock::now() + period; scheduled < deadline; scheduled += period)
+        {
+            std::this_thread::sleep_until(scheduled);
+            Measure(stats[TICK], scheduled, connection, http::verb::post, TARGETS[TICK], serialized);
+        }
+        return stats;
+    }
+
+    [[nodiscard]] std::optional<Options> ParseCommandLine(int argc, const char* const argv[])
+    {
+        namespace po = boost::program_options;
+
+        Options options;
+        po::options_description desc{ "Allowed options"s };
+        desc.add_options()
+            ("help,h", "produce help message")
+            ("host", po::value(&options.host)->value_name("address"s), "set server address")
+            ("port", po::value(&options.port)->value_name("port"s), "set server port")
+            ("players", po::value(&options.players)->value_name("players"s), "set number of joined players")
+            ("connections", po::value(&options.connections)->value_name("connections"s), "set number of client threads, one keep-alive connection each (default - number of cores)")
+            ("map", po::value(&options.maps)->multitoken()->value_name("id"s), "join only these maps (default - all maps)")
+            ("action-rate", po::value(&options.action_rate)->value_name("requests"s), "set actions per second per player (0 - none)")
+            ("state-rate", po::value(&options.state_rate)->value_name("requests"s), "set state requests per second per player (0 - none)")
+            ("tick-period", po::value(&options.tick_period)->value_name("milliseconds"s), "drive /api/v1/game/tick with this period (0 - server ticks by itself)")
+            ("duration", po::value(&options.duration)->value_name("seconds"s), "set load duration after all players joined");
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+
+        if (vm.contains("help"s))
+        {
+            std::cout << desc;
+            return std::nullopt;
+        }
+        if (options.players == 0)
+            throw std::runtime_error("At least one player is required"s);
+        if (options.connections == 0)
+            options.connections = std::max(1u, std::thread::hardware_concurrency());
+        options.connections = std::min(options.connections, options.players);
+        return options;
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    try
+    {
+        std::optional<Options> options = ParseCommandLine(argc, argv);
+        if (!options)
+            return EXIT_FAILURE;
+
+        net::io_context ioc;
+        tcp::resolver resolver(ioc);
+        const auto endpoints = resolver.resolve(options->host, options->port);
+        const std::vector<std::string> maps = options->maps.empty() ? LoadMapIds(endpoints, options->host) : options->maps;
+        if (maps.empty())
+            throw std::runtime_error("The server has no maps"s);
+
+        const bool ticker = options->tick_period != 0;
+        std::latch joined(options->connections + (ticker ? 1 : 0) + 1);
+        const ClientContext context{ *options, endpoints, maps, joined };
+        std::vector<Stats> results(options->connections + (ticker ? 1 : 0));
+
+        auto join_start = Clock::now();
+        std::chrono::duration<double> join_elapsed{ 0 };
+        auto load_start = join_start;
+        {
+            std::vector<std::jthread> clients;
+            for (unsigned i = 0; i < options->connections; ++i)
+                clients.emplace_back([&, i] { results[i] = RunClient(context, i); });
+            if (ticker)
+                clients.emplace_back([&] { results.back() = RunTicker(context); });
+            joined.arrive_and_wait();
+            load_start = Clock::now();
+            join_elapsed = load_start - join_start;
+        }
+        const std::chrono::duration<double> load_elapsed = Clock::now() - load_start;
+
+        Stats total;
+        for (const auto& result : results)
+        {
+            for (size_t i = 0; i < ENDPOINT_COUNT; ++i)
+                total[i].Merge(result[i]);
+        }
+
+        json::array endpoints_report;
+        for (size_t i = 0; i < ENDPOINT_COUNT; ++i)
+        {
+            const auto& stats = total[i];
+            if (stats.latency_us.GetCount() == 0 && stats.errors == 0)
+                continue;
+            // Вход идёт до основной нагрузки, его частота считается по своему времени
+            const double elapsed = i == JOIN ? join_elapsed.count() : load_elapsed.count();
+            json::object endpoint;
+            endpoint["target"] = TARGETS[i];
+            endpoint["requests"] = stats.latency_us.GetCount();
+            endpoint["errors"] = stats.errors;
+            endpoint["not_ok"] = stats.not_ok;
+            endpoint["requests_per_second"] = elapsed > 0 ? static_cast<double>(stats.latency_us.GetCount()) / elapsed : 0.0;
+            endpoint["latency_us"] = latency::MakeJSONHistogram(stats.latency_us);
+            endpoints_report.push_back(std::move(endpoint));
+        }
+
+        json::object report;
+        report["players"] = options->players;
+        report["connections"] = options->connections;
+        report["maps"] = maps.size();
+        report["action_rate"] = options->action_rate;
+        report["state_rate"] = options->state_rate;
+        report["tick_period"] = options->tick_period;
+        report["join_seconds"] = join_elapsed.count();
+        report["load_seconds"] = load_elapsed.count();
+        report["endpoints"] = std::move(endpoints_report);
+        std::cout << json::serialize(report) << std::endl;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
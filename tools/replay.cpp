@@ -0,0 +1,166 @@
+// Повтор записи симуляции (game_server --record) без HTTP и базы: те же команды и тики поверх модели MyLib.
+// После каждого тика хэш мира сверяется с записанным, первое расхождение завершает повтор с ошибкой.
+// В отчёт идёт время тиков: по нему настоящий трафик профилируют офлайн и сравнивают сборки.
+// Запуск: replay <config.json> <journal> [--no-verify]
+#include <boost/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/json_loader.h"
+#include "../src/sim_record.h"
+
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    class Replay
+    {
+    public:
+        Replay(model::Game& game, const sim_record::Header& header, bool verify)
+            : game_(game)
+            , header_(header)
+            , verify_(verify)
+        {
+        }
+
+        // Повторяет Application::AddJoinedPlayer на уровне модели
+        void operator()(const sim_record::Join& r)
+        {
+            auto map = game_.FindMap(model::Map::Id(r.map_id));
+            if (!map)
+                throw std::runtime_error("The journal joins a missing map "s + r.map_id);
+            auto session = game_.GetSession(r.map_id);
+            if (!session)
+                session = std::make_shared<model::GameSession>(map);
+
+            model::DogCoord coords = header_.randomize_spawn_points ? map->GetRandomPosDog() : map->GetStartPosDog();
+            auto dog = std::make_shared<model::Dog>(model::Direction::UP, map->GetDogSpeed(), coords);
+            if (dog->GetObjectId() != r.dog_id)
+                Diverged("dog id "s + std::to_string(dog->GetObjectId()) + " instead of "s + std::to_string(r.dog_id));
+            session->AddDog(dog);
+            game_.AddSession(session, r.map_id);
+            dogs_[r.dog_id] = std::move(dog);
+            ++joins_;
+        }
+
+        // Повторяет Application::MovePlayer
+        void operator()(const sim_record::Action& r)
+        {
+            auto it = dogs_.find(r.dog_id);
+            if (it == dogs_.end())
+                Diverged("action of a missing dog "s + std::to_string(r.dog_id));
+            const auto& dog = it->second;
+            dog->ClearIdleTime();
+            if (r.move == 0)
+                dog->StopDog();
+            else
+            {
+                dog->SetInGameDirection(static_cast<model::Direction>(r.move));
+                dog->SetInGameSpeed();
+            }
+            ++actions_;
+        }
+
+        // Повторяет модельную часть Application::Tick: тик и уход простаивающих собак
+        void operator()(const sim_record::Tick& r)
+        {
+            std::chrono::milliseconds delta(r.delta_ms);
+            auto start = Clock::now();
+            game_.UpdateGameState(delta);
+            game_.TakeScoredDogs();
+            game_.TakeSpawnedLoot();
+            auto idle = game_.GetIdleDogs(delta);
+            for (int id : idle)
+                dogs_.erase(id);
+            if (!idle.empty())
+                game_.DeleteEmptySessions();
+            tick_us_.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+            if (verify_ && game_.GetStateDigest() != r.digest)
+                Diverged("state digest differs");
+        }
+
+        json::object Report() const
+        {
+            std::vector<double> sorted = tick_us_;
+            std::sort(sorted.begin(), sorted.end());
+            auto percentile = [&sorted](double p) {
+                return sorted.empty() ? 0.0 : sorted[static_cast<size_t>(p * static_cast<double>(sorted.size() - 1))];
+                };
+            double total_us = 0;
+            for (double us : tick_us_)
+                total_us += us;
+
+            json::object report;
+            report["ticks"] = tick_us_.size();
+            report["joins"] = joins_;
+            report["actions"] = actions_;
+            report["verified"] = verify_;
+            report["dogs"] = dogs_.size();
+            report["digest"] = game_.GetStateDigest();
+            report["total_tick_ms"] = total_us / 1e3;
+            report["avg_tick_us"] = tick_us_.empty() ? 0.0 : total_us / static_cast<double>(tick_us_.size());
+            report["p50_tick_us"] = percentile(0.5);
+            report["p99_tick_us"] = percentile(0.99);
+            report["max_tick_us"] = sorted.empty() ? 0.0 : sorted.back();
+            return report;
+        }
+
+    private:
+        [[noreturn]] void Diverged(const std::string& what) const
+        {
+            throw std::runtime_error("Replay diverged at tick "s + std::to_string(tick_us_.size()) + ": "s + what);
+        }
+
+        model::Game& game_;
+        sim_record::Header header_;
+        bool verify_;
+        std::unordered_map<int, std::shared_ptr<model::Dog>> dogs_;
+        std::vector<double> tick_us_;
+        size_t joins_ = 0;
+        size_t actions_ = 0;
+    };
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: replay <config.json> <journal> [--no-verify]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::filesystem::path config_path = argv[1];
+    const bool verify = !(argc > 3 && argv[3] == "--no-verify"sv);
+
+    try
+    {
+        sim_record::Reader reader(argv[2]);
+        const auto& header = reader.GetHeader();
+        if (sim_record::HashConfig(config_path) != header.config_crc)
+            throw std::runtime_error("The config differs from the recorded one");
+
+        model::Game game = json_loader::LoadGame(config_path);
+        game.SeedRandom(header.seed);
+        Replay replay(game, header, verify);
+        sim_record::Record record;
+        while (reader.Next(record))
+            std::visit(replay, record);
+
+        std::cout << json::serialize(replay.Report()) << std::endl;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}